@@ -38,7 +38,8 @@ ini_file_t AppConfig::ms_def_values[2] = {
 	{ PROGRAM_SECTION, {
 		{ PROGRAM_MEDIA_DIR,    ""    },
 		{ PROGRAM_CAPTURE_DIR,  ""    },
-		{ PROGRAM_THREADS_SYNC, "yes" }
+		{ PROGRAM_THREADS_SYNC, "yes" },
+		{ PROGRAM_MAX_SPEED,    "no"  }
 	} },
 
 	{ GUI_SECTION, {
@@ -68,7 +69,8 @@ ini_file_t AppConfig::ms_def_values[2] = {
 		{ DISPLAY_REALISTIC_AMBIENT, "0.6" },
 		{ DISPLAY_BRIGHTNESS,        "1.0" },
 		{ DISPLAY_CONTRAST,          "1.0" },
-		{ DISPLAY_SATURATION,        "1.0" }
+		{ DISPLAY_SATURATION,        "1.0" },
+		{ DISPLAY_RENDER_THREADS,    "0" }
 	} },
 
 	{ CMOS_SECTION, {
@@ -132,8 +134,11 @@ ini_file_t AppConfig::ms_def_values[2] = {
 	} },
 
 	{ CPU_SECTION, {
-		{ CPU_MODEL,     "auto" },
-		{ CPU_FREQUENCY, "auto" }
+		{ CPU_MODEL,        "auto"  },
+		{ CPU_FREQUENCY,    "auto"  },
+		{ CPU_EXEC_MODE,    "step" },
+		{ CPU_IDLE_DETECT,  "yes"   },
+		{ CPU_IDLE_EXCLUDE, ""      }
 	} },
 
 	{ CMOS_SECTION, {
@@ -216,6 +221,8 @@ ini_filehelp_t AppConfig::ms_help = {
 		{ PROGRAM_SECTION,
 ";   media_dir: The default directory used to search for floppy and hdd images.\n"
 "; capture_dir: Directory where things like wave files, savestates and screenshots get captured.\n"
+";   max_speed: Run the emulation as fast as the host allows, without audio (toggle with CTRL+F9).\n"
+";              Possible values: yes, no.\n"
 		},
 
 		{ SYSTEM_SECTION,
@@ -227,10 +234,20 @@ ini_filehelp_t AppConfig::ms_help = {
 		},
 
 		{ CPU_SECTION,
-";     model: The CPU model.\n"
-";            Possible values: auto, 286, 386SX, 386DX.\n"
-"; frequency: Frequency in MHz.\n"
-";            Possible values: auto, or an integer number.\n"
+";        model: The CPU model.\n"
+";               Possible values: auto, 286, 386SX, 386DX.\n"
+";    frequency: Frequency in MHz.\n"
+";               Possible values: auto, or an integer number.\n"
+";    exec_mode: The instructions execution mode.\n"
+";               Possible values: step, block.\n"
+";                step: the machine state is updated after every instruction\n"
+";               block: the instructions are stepped back to back up to the next control transfer\n"
+";                      or timer event, the machine state is updated once per batch (experimental)\n"
+";  idle_detect: Detect when DOS programs are waiting for input (polling the keyboard or calling\n"
+";               INT 28h) and let the time pass until the next hardware event.\n"
+";               Possible values: yes, no.\n"
+"; idle_exclude: Comma separated list of programs for which the idle detection is disabled.\n"
+";               Example: GAME.EXE, EDIT.COM\n"
 		},
 
 		{ GUI_SECTION,
@@ -278,6 +295,8 @@ ini_filehelp_t AppConfig::ms_help = {
 ";         contrast: Monitor contrast.\n"
 ";                   When in realistic GUI mode it's clamped to 1.3\n"
 ";       saturation: Monitor saturation.\n"
+";   render_threads: Number of threads used to render the VGA graphics modes.\n"
+";                   0 uses the number of host cores (max 4).\n"
 		},
 
 		{ CMOS_SECTION, ""
@@ -407,7 +426,8 @@ ini_filehelp_t AppConfig::ms_help = {
 std::vector<std::pair<std::string, std::vector<std::string>>> AppConfig::ms_keys_order = {
 	{ PROGRAM_SECTION, {
 		PROGRAM_MEDIA_DIR,
-		PROGRAM_CAPTURE_DIR
+		PROGRAM_CAPTURE_DIR,
+		PROGRAM_MAX_SPEED
 	} },
 	{ GUI_SECTION, {
 		GUI_MODE,
@@ -435,7 +455,8 @@ std::vector<std::pair<std::string, std::vector<std::string>>> AppConfig::ms_keys
 		DISPLAY_REALISTIC_AMBIENT,
 		DISPLAY_BRIGHTNESS,
 		DISPLAY_CONTRAST,
-		DISPLAY_SATURATION
+		DISPLAY_SATURATION,
+		DISPLAY_RENDER_THREADS
 	} },
 	{ SYSTEM_SECTION, {
 		SYSTEM_ROMSET,
@@ -443,7 +464,10 @@ std::vector<std::pair<std::string, std::vector<std::string>>> AppConfig::ms_keys
 	} },
 	{ CPU_SECTION, {
 		CPU_MODEL,
-		CPU_FREQUENCY
+		CPU_FREQUENCY,
+		CPU_EXEC_MODE,
+		CPU_IDLE_DETECT,
+		CPU_IDLE_EXCLUDE
 	} },
 	{ MEM_SECTION, {
 		MEM_RAM_EXP,
@@ -123,6 +123,7 @@ public:
 #define PROGRAM_MEDIA_DIR       "media_dir"
 #define PROGRAM_CAPTURE_DIR     "capture_dir"
 #define PROGRAM_THREADS_SYNC    "threads_sync"
+#define PROGRAM_MAX_SPEED       "max_speed"
 
 #define GUI_SECTION             "gui"
 #define GUI_KEYMAP              "keymap"
@@ -151,6 +152,7 @@ public:
 #define DISPLAY_BRIGHTNESS       "brightness"
 #define DISPLAY_CONTRAST         "contrast"
 #define DISPLAY_SATURATION       "saturation"
+#define DISPLAY_RENDER_THREADS   "render_threads"
 
 #define SYSTEM_SECTION          "system"
 #define SYSTEM_ROMSET           "romset"
@@ -160,6 +162,9 @@ public:
 #define CPU_SECTION             "cpu"
 #define CPU_MODEL               "model"
 #define CPU_FREQUENCY           "frequency"
+#define CPU_EXEC_MODE           "exec_mode"
+#define CPU_IDLE_DETECT         "idle_detect"
+#define CPU_IDLE_EXCLUDE        "idle_exclude"
 
 #define MEM_SECTION             "memory"
 #define MEM_RAM_EXP             "expansion"
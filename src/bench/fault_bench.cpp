@@ -0,0 +1,207 @@
+/*
+ * Copyright (C) 2018  Marco Bortolin
+ *
+ * This file is part of IBMulator.
+ *
+ * IBMulator is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * IBMulator is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with IBMulator.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Micro-benchmark of the CPU fault propagation.
+ * Real #GP and #PF faults are raised by the guest code and dispatched through
+ * CPU::step(), with the faults propagated to the step function by a longjmp
+ * to the single unwind point (USE_FAULT_UNWIND, see CPU::raise()) and by a
+ * C++ exception. The CPU runs in 32-bit protected mode with paging and the
+ * fault handler returns to the faulting instruction, so every iteration is a
+ * fault, its delivery and the IRET. The cost of arming the unwind point is
+ * measured with a loop that doesn't fault, as it's paid by every instruction.
+ * Only the CPU and a RAM-only Memory are initialized, as in opcode_bench.
+ *
+ * usage: fault_bench [iterations]
+ */
+
+#include "ibmulator.h"
+#include "machine.h"
+#include "program.h"
+#include "hardware/cpu.h"
+#include "hardware/cpu/bus.h"
+#include "hardware/cpu/executor.h"
+#include "hardware/memory.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <vector>
+
+#define GDT_BASE    0x00500
+#define IDT_BASE    0x00600
+#define PD_BASE     0x01000 // page directory
+#define PT_BASE     0x02000 // page table of the first 4MB
+#define CODE_BASE   0x10000 // linear address of the code segment
+#define HANDLER_OFF 0x100   // offset of the fault handler in the code segment
+#define DATA_BASE   0x20000 // linear address of the data segments
+#define STACK_BASE  0x30000 // linear address of the stack segment
+#define FAULT_PAGE  0x40000 // linear address of the not present page
+
+struct BenchCase {
+	const char *name;
+	uint16_t ds;       // data segment selector
+	uint32_t ebx;      // offset of the memory operand
+	unsigned steps;    // instructions per iteration
+};
+
+// the guest code is "mov eax,[ebx]" followed by a jump back to it
+static const std::vector<BenchCase> g_cases = {
+{ "no fault",              0x18, 0x1000,                  2 },
+{ "#GP segment limit",     0x20, 0x20000,                 3 }, // 64K data segment
+{ "#PF page not present",  0x18, FAULT_PAGE - DATA_BASE, 3 },
+};
+
+static void write_descriptor(unsigned _idx, uint32_t _base, uint32_t _limit,
+		uint8_t _access, uint8_t _flags)
+{
+	uint8_t *d = g_memory.get_buffer_ptr(GDT_BASE + _idx*8);
+	d[0] = _limit;
+	d[1] = _limit >> 8;
+	d[2] = _base;
+	d[3] = _base >> 8;
+	d[4] = _base >> 16;
+	d[5] = _access;
+	d[6] = ((_limit >> 16) & 0x0F) | (_flags << 4);
+	d[7] = _base >> 24;
+}
+
+static void write_gate(unsigned _vector, uint16_t _sel, uint32_t _offset)
+{
+	// 32-bit interrupt gate, DPL 0
+	uint8_t *d = g_memory.get_buffer_ptr(IDT_BASE + _vector*8);
+	d[0] = _offset;
+	d[1] = _offset >> 8;
+	d[2] = _sel;
+	d[3] = _sel >> 8;
+	d[4] = 0;
+	d[5] = 0x8E;
+	d[6] = _offset >> 16;
+	d[7] = _offset >> 24;
+}
+
+static void write_dword(uint32_t _addr, uint32_t _value)
+{
+	uint8_t *d = g_memory.get_buffer_ptr(_addr);
+	d[0] = _value;
+	d[1] = _value >> 8;
+	d[2] = _value >> 16;
+	d[3] = _value >> 24;
+}
+
+static void setup_machine()
+{
+	g_program.config().set_string(CPU_SECTION, CPU_MODEL, "386DX");
+	g_program.config().set_string(MEM_SECTION, MEM_RAM_EXP, "none");
+
+	g_cpu.init();
+	g_memory.init();
+	g_cpu.config_changed();
+	g_memory.config_changed();
+	g_cpu.reset(MACHINE_POWER_ON);
+	g_memory.reset();
+
+	write_descriptor(1, CODE_BASE,  0xFFFFF, 0x9A, 0xC); // 0x08 code32
+	write_descriptor(3, DATA_BASE,  0xFFFFF, 0x92, 0xC); // 0x18 data32
+	write_descriptor(4, DATA_BASE,  0x0FFFF, 0x92, 0x0); // 0x20 data16
+	write_descriptor(5, STACK_BASE, 0xFFFFF, 0x92, 0xC); // 0x28 stack32
+
+	// the handler discards the error code and returns to the faulting instruction
+	write_gate(CPU_GP_EXC, 0x08, HANDLER_OFF);
+	write_gate(CPU_PF_EXC, 0x08, HANDLER_OFF);
+
+	// identity mapped first 4MB, but for the fault page
+	write_dword(PD_BASE, PT_BASE | 3);
+	for(uint32_t p=0; p<1024; p++) {
+		write_dword(PT_BASE + p*4, (p*4096 == FAULT_PAGE) ? 0 : (p*4096) | 3);
+	}
+
+	static const uint8_t code[] = {
+		0x8B,0x03,  // mov eax,[ebx]
+		0xEB,0xFC   // jmp short $-2
+	};
+	static const uint8_t handler[] = {
+		0x83,0xC4,0x04, // add esp,4
+		0xCF            // iretd
+	};
+	memcpy(g_memory.get_buffer_ptr(CODE_BASE), code, sizeof(code));
+	memcpy(g_memory.get_buffer_ptr(CODE_BASE + HANDLER_OFF), handler, sizeof(handler));
+
+	g_cpucore.set_GDTR(GDT_BASE, 6*8 - 1);
+	g_cpucore.set_IDTR(IDT_BASE, 256*8 - 1);
+	g_cpucore.set_CR0(CR0BIT_PE, true);
+	g_cpucore.set_CR3(PD_BASE);
+	g_cpucore.set_CR0(CR0BIT_PG, true);
+	Selector sel;
+	sel = 0x08;
+	Descriptor desc;
+	desc = g_cpuexecutor.fetch_descriptor(sel, CPU_GP_EXC);
+	g_cpucore.set_CS(sel, desc, 0);
+	g_cpucore.set_SS(0x28);
+}
+
+// returns ns per iteration
+static double run(const BenchCase &_case, unsigned _iterations)
+{
+	g_cpucore.set_DS(_case.ds);
+	REG_EBX = _case.ebx;
+	REG_ESP = 0xFF00;
+	SET_EIP(0);
+	COMMIT_EIP();
+	g_cpubus.invalidate_pq();
+
+	unsigned steps = _iterations * _case.steps;
+	auto start = std::chrono::steady_clock::now();
+	for(unsigned i=0; i<steps; i++) {
+		g_cpu.step();
+	}
+	auto stop = std::chrono::steady_clock::now();
+	return std::chrono::duration<double, std::nano>(stop - start).count() / _iterations;
+}
+
+int main(int argc, char **argv)
+{
+	unsigned iterations = 1000000;
+	if(argc > 1) {
+		iterations = strtoul(argv[1], nullptr, 0);
+		if(iterations == 0) {
+			fprintf(stderr, "usage: %s [iterations]\n", argv[0]);
+			return 1;
+		}
+	}
+	if(!USE_FAULT_UNWIND) {
+		fprintf(stderr, "USE_FAULT_UNWIND is disabled, both columns use exceptions\n");
+	}
+
+	setup_machine();
+
+	printf("386DX 32-bit protected mode, %u iterations, ns per iteration\n", iterations);
+	printf("%-24s %10s %10s\n", "", "exception", "longjmp");
+	for(const BenchCase &bc : g_cases) {
+		double ns[2];
+		for(int unwind=0; unwind<2; unwind++) {
+			g_cpu.set_fault_unwind(unwind);
+			run(bc, iterations/10); // warm up
+			ns[unwind] = run(bc, iterations);
+		}
+		printf("%-24s %10.1f %10.1f\n", bc.name, ns[0], ns[1]);
+	}
+	g_cpu.set_fault_unwind(true);
+
+	return 0;
+}
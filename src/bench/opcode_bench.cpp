@@ -0,0 +1,300 @@
+/*
+ * Copyright (C) 2018  Marco Bortolin
+ *
+ * This file is part of IBMulator.
+ *
+ * IBMulator is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * IBMulator is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with IBMulator.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Micro-benchmark of the CPU decoder and executor.
+ * Every test fills a code buffer with copies of a single instruction (or of a
+ * short sequence) and runs it through CPUDecoder::decode() and
+ * CPUExecutor::execute() in real mode, in a 16-bit and in a 32-bit protected
+ * mode code segment. Only the CPU and a RAM-only Memory are initialized, no
+ * devices, timers or ROM, so the numbers are the cost of the decoder and the
+ * executor alone. The registers are reloaded every time the buffer wraps
+ * around, so memory operands and string ops stay inside the data segment.
+ *
+ * usage: opcode_bench [-d] [-c 286|386SX|386DX] [iterations]
+ *   -d  decode only, the instructions are not executed
+ */
+
+#include "ibmulator.h"
+#include "machine.h"
+#include "program.h"
+#include "hardware/cpu.h"
+#include "hardware/cpu/bus.h"
+#include "hardware/cpu/decoder.h"
+#include "hardware/cpu/executor.h"
+#include "hardware/memory.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <vector>
+#include <unistd.h>
+
+#define CODE_BASE   0x10000 // linear address of the code segment
+#define CODE_SIZE   0x4000  // size of the instructions buffer
+#define DATA_BASE   0x20000 // linear address of the data segments
+#define STACK_BASE  0x30000 // linear address of the stack segment
+#define GDT_BASE    0x00500
+
+enum BenchMode {
+	MODE_REAL, MODE_PM16, MODE_PM32,
+	MODE_COUNT
+};
+
+static const char * mode_str[MODE_COUNT] = { "real16", "pm16", "pm32" };
+
+struct BenchCase {
+	const char *name;
+	unsigned min_cpu;          // min CPU family
+	std::vector<uint8_t> code16; // encoding for 16-bit code segments
+	std::vector<uint8_t> code32; // encoding for 32-bit code segments
+};
+
+// the register names are those of the 16-bit encoding, the 32-bit encoding
+// uses the 32-bit registers and the SIB byte when there is an index
+static const std::vector<BenchCase> g_cases = {
+{ "nop",                    CPU_286, { 0x90 },                   { 0x90 } },
+{ "mov r,r",                CPU_286, { 0x89,0xD8 },              { 0x89,0xD8 } },
+{ "mov r,imm",              CPU_286, { 0xB8,0x34,0x12 },         { 0xB8,0x78,0x56,0x34,0x12 } },
+{ "mov r,[bx]",             CPU_286, { 0x8B,0x07 },              { 0x8B,0x03 } },
+{ "mov r,[bx+si]",          CPU_286, { 0x8B,0x00 },              { 0x8B,0x04,0x33 } },
+{ "mov r,[bx+si+d8]",       CPU_286, { 0x8B,0x40,0x08 },         { 0x8B,0x44,0xB3,0x08 } },
+{ "mov r,[bp+d8]",          CPU_286, { 0x8B,0x46,0x08 },         { 0x8B,0x45,0x08 } },
+{ "mov r,[disp]",           CPU_286, { 0x8B,0x06,0x00,0x10 },    { 0x8B,0x05,0x00,0x10,0x00,0x00 } },
+{ "mov [bx],r",             CPU_286, { 0x89,0x07 },              { 0x89,0x03 } },
+{ "mov r,[bx] (opsize)",    CPU_386, { 0x66,0x8B,0x07 },         { 0x66,0x8B,0x03 } },
+{ "mov r,[bx] (seg ovr)",   CPU_286, { 0x26,0x8B,0x07 },         { 0x26,0x8B,0x03 } },
+{ "mov sr,r",               CPU_286, { 0x8C,0xD8,0x8E,0xD8 },    { 0x8C,0xD8,0x8E,0xD8 } },
+{ "add r,r",                CPU_286, { 0x01,0xD8 },              { 0x01,0xD8 } },
+{ "add r,[bx]",             CPU_286, { 0x03,0x07 },              { 0x03,0x03 } },
+{ "add [bx],r",             CPU_286, { 0x01,0x07 },              { 0x01,0x03 } },
+{ "add r,imm8",             CPU_286, { 0x83,0xC0,0x01 },         { 0x83,0xC0,0x01 } },
+{ "inc r",                  CPU_286, { 0x40 },                   { 0x40 } },
+{ "cmp r,r",                CPU_286, { 0x39,0xD8 },              { 0x39,0xD8 } },
+{ "lea r,[bx+si+d8]",       CPU_286, { 0x8D,0x40,0x08 },         { 0x8D,0x44,0xB3,0x08 } },
+{ "xchg r,r",               CPU_286, { 0x93 },                   { 0x93 } },
+{ "shl r,1",                CPU_286, { 0xD1,0xE0 },              { 0xD1,0xE0 } },
+{ "shl r,cl",               CPU_286, { 0xD3,0xE0 },              { 0xD3,0xE0 } },
+{ "rol r,imm8",             CPU_286, { 0xC1,0xC0,0x03 },         { 0xC1,0xC0,0x03 } },
+{ "mul r",                  CPU_286, { 0xF7,0xE3 },              { 0xF7,0xE3 } },
+{ "imul r,r",               CPU_386, { 0x0F,0xAF,0xC3 },         { 0x0F,0xAF,0xC3 } },
+{ "div r",                  CPU_286, { 0xF7,0xF3 },              { 0xF7,0xF3 } },
+{ "cbw",                    CPU_286, { 0x98 },                   { 0x98 } },
+{ "cwd",                    CPU_286, { 0x99 },                   { 0x99 } },
+{ "clc",                    CPU_286, { 0xF8 },                   { 0xF8 } },
+{ "movzx r,byte [bx]",      CPU_386, { 0x0F,0xB6,0x07 },         { 0x0F,0xB6,0x03 } },
+{ "setz r8",                CPU_386, { 0x0F,0x94,0xC0 },         { 0x0F,0x94,0xC0 } },
+{ "bt r,r",                 CPU_386, { 0x0F,0xA3,0xD8 },         { 0x0F,0xA3,0xD8 } },
+{ "bsf r,r",                CPU_386, { 0x0F,0xBC,0xC3 },         { 0x0F,0xBC,0xC3 } },
+{ "push r / pop r",         CPU_286, { 0x50,0x58 },              { 0x50,0x58 } },
+{ "jmp short",              CPU_286, { 0xEB,0x00 },              { 0xEB,0x00 } },
+{ "jz short",               CPU_286, { 0x74,0x00 },              { 0x74,0x00 } },
+{ "call / ret / jmp",       CPU_286, { 0xE8,0x02,0x00,0xEB,0x01,0xC3 },
+                                     { 0xE8,0x02,0x00,0x00,0x00,0xEB,0x01,0xC3 } },
+{ "movsb",                  CPU_286, { 0xA4 },                   { 0xA4 } },
+{ "stosw",                  CPU_286, { 0xAB },                   { 0xAB } },
+{ "lodsb",                  CPU_286, { 0xAC },                   { 0xAC } },
+{ "mov cx,16 / rep movsb",  CPU_286, { 0xB9,0x10,0x00,0xF3,0xA4 },
+                                     { 0xB9,0x10,0x00,0x00,0x00,0xF3,0xA4 } },
+};
+
+static bool g_decode_only = false;
+
+static void write_descriptor(unsigned _idx, uint32_t _base, uint32_t _limit,
+		uint8_t _access, uint8_t _flags)
+{
+	uint8_t *d = g_memory.get_buffer_ptr(GDT_BASE + _idx*8);
+	d[0] = _limit;
+	d[1] = _limit >> 8;
+	d[2] = _base;
+	d[3] = _base >> 8;
+	d[4] = _base >> 16;
+	d[5] = _access;
+	d[6] = ((_limit >> 16) & 0x0F) | (_flags << 4);
+	d[7] = _base >> 24;
+}
+
+static void setup_machine(const char *_cpu)
+{
+	g_program.config().set_string(CPU_SECTION, CPU_MODEL, _cpu);
+	g_program.config().set_string(MEM_SECTION, MEM_RAM_EXP, "none");
+
+	g_cpu.init();
+	g_memory.init();
+	g_cpu.config_changed();
+	g_memory.config_changed();
+	g_cpu.reset(MACHINE_POWER_ON);
+	g_memory.reset();
+
+	// flat-ish descriptors: 32-bit segments have 4G limits, 16-bit ones 64K
+	write_descriptor(1, CODE_BASE,  0xFFFFF, 0x9A, 0xC); // 0x08 code32
+	write_descriptor(2, CODE_BASE,  0x0FFFF, 0x9A, 0x0); // 0x10 code16
+	write_descriptor(3, DATA_BASE,  0xFFFFF, 0x92, 0xC); // 0x18 data32
+	write_descriptor(4, DATA_BASE,  0x0FFFF, 0x92, 0x0); // 0x20 data16
+	write_descriptor(5, STACK_BASE, 0xFFFFF, 0x92, 0xC); // 0x28 stack32
+	write_descriptor(6, STACK_BASE, 0x0FFFF, 0x92, 0x0); // 0x30 stack16
+}
+
+static void set_mode(BenchMode _mode)
+{
+	if(_mode == MODE_REAL) {
+		g_cpu.reset(MACHINE_POWER_ON);
+		g_cpucore.set_CS(CODE_BASE >> 4);
+		g_cpucore.set_DS(DATA_BASE >> 4);
+		g_cpucore.set_ES(DATA_BASE >> 4);
+		g_cpucore.set_SS(STACK_BASE >> 4);
+	} else {
+		bool big = (_mode == MODE_PM32);
+		g_cpucore.set_GDTR(GDT_BASE, 7*8 - 1);
+		g_cpucore.set_CR0(CR0BIT_PE, true);
+		Selector sel;
+		sel = big ? 0x08 : 0x10;
+		Descriptor desc;
+		desc = g_cpuexecutor.fetch_descriptor(sel, CPU_GP_EXC);
+		g_cpucore.set_CS(sel, desc, 0);
+		g_cpucore.set_DS(big ? 0x18 : 0x20);
+		g_cpucore.set_ES(big ? 0x18 : 0x20);
+		g_cpucore.set_SS(big ? 0x28 : 0x30);
+	}
+}
+
+static void reset_registers()
+{
+	REG_EAX = 0x1234;
+	REG_EBX = 0x1000;
+	REG_ECX = 4;
+	REG_EDX = 0;
+	REG_ESI = 0x0100;
+	REG_EDI = 0x2000;
+	REG_EBP = 0x0800;
+	REG_ESP = 0xFF00;
+	SET_EIP(0);
+	COMMIT_EIP();
+	g_cpubus.invalidate_pq();
+}
+
+// returns ns per instruction or a negative number if the test faulted
+static double run(const std::vector<uint8_t> &_code, unsigned _iterations)
+{
+	uint8_t *code = g_memory.get_buffer_ptr(CODE_BASE);
+	uint32_t copies = CODE_SIZE / _code.size();
+	uint32_t end = copies * _code.size();
+	for(uint32_t i=0; i<copies; i++) {
+		memcpy(code + i*_code.size(), _code.data(), _code.size());
+	}
+
+	reset_registers();
+	Instruction *instr = nullptr;
+	auto start = std::chrono::steady_clock::now();
+	try {
+		for(unsigned i=0; i<_iterations; i++) {
+			if(REG_EIP >= end) {
+				reset_registers();
+			}
+			g_cpubus.reset_counters();
+			if(!g_cpubus.pq_is_valid()) {
+				g_cpubus.reset_pq();
+			}
+			if(g_decode_only) {
+				instr = g_cpudecoder.decode();
+				SET_EIP(REG_EIP + instr->size);
+				COMMIT_EIP();
+				continue;
+			}
+			// a REP instruction is executed again without decoding until done
+			if(instr == nullptr || instr->cseip != CS_EIP) {
+				instr = g_cpudecoder.decode();
+			}
+			g_cpuexecutor.execute(instr);
+			// execute the queued memory writes, as CPU::step() does
+			g_cpubus.update(0);
+		}
+	} catch(CPUException &e) {
+		fprintf(stderr, "  %s at EIP=0x%08X\n", e.name(), REG_EIP);
+		return -1.0;
+	}
+	auto stop = std::chrono::steady_clock::now();
+	return std::chrono::duration<double, std::nano>(stop - start).count() / _iterations;
+}
+
+int main(int argc, char **argv)
+{
+	unsigned iterations = 2000000;
+	const char *cpu = "386DX";
+	int c;
+	while((c = getopt(argc, argv, "dc:")) != -1) {
+		switch(c) {
+			case 'd': g_decode_only = true; break;
+			case 'c': cpu = optarg; break;
+			default:
+				fprintf(stderr, "usage: %s [-d] [-c 286|386SX|386DX] [iterations]\n", argv[0]);
+				return 1;
+		}
+	}
+	if(optind < argc) {
+		iterations = strtoul(argv[optind], nullptr, 0);
+		if(iterations == 0) {
+			fprintf(stderr, "usage: %s [-d] [-c 286|386SX|386DX] [iterations]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	setup_machine(cpu);
+
+	printf("%s %s, %u iterations, ns per instruction\n",
+			cpu, g_decode_only ? "decode" : "decode+execute", iterations);
+	printf("%-24s", "");
+	for(int m=0; m<MODE_COUNT; m++) {
+		printf(" %8s", mode_str[m]);
+	}
+	printf("\n");
+
+	// real mode first, the switch to protected mode is one way
+	std::vector<std::vector<double>> results(g_cases.size());
+	for(int m=0; m<MODE_COUNT; m++) {
+		// there are no 32-bit code segments on the 286
+		bool supported = (m != MODE_PM32 || CPU_FAMILY >= CPU_386);
+		if(supported) {
+			set_mode(BenchMode(m));
+		}
+		for(size_t i=0; i<g_cases.size(); i++) {
+			const BenchCase &bc = g_cases[i];
+			double ns = -1.0;
+			if(supported && CPU_FAMILY >= bc.min_cpu) {
+				const std::vector<uint8_t> &code = (m == MODE_PM32) ? bc.code32 : bc.code16;
+				run(code, iterations/10); // warm up
+				ns = run(code, iterations);
+			}
+			results[i].push_back(ns);
+		}
+	}
+
+	for(size_t i=0; i<g_cases.size(); i++) {
+		printf("%-24s", g_cases[i].name);
+		for(double ns : results[i]) {
+			if(ns < 0.0) {
+				printf(" %8s", "-");
+			} else {
+				printf(" %8.1f", ns);
+			}
+		}
+		printf("\n");
+	}
+
+	return 0;
+}
@@ -121,6 +121,7 @@ m_gui_visible(true),
 m_input_grab(false),
 m_mode(GUI_MODE_NORMAL),
 m_symspeed_factor(1.0),
+m_headless(false),
 m_rocket_renderer(nullptr),
 m_rocket_sys_interface(nullptr),
 m_rocket_file_interface(nullptr),
@@ -223,9 +224,20 @@ void GUI::init(Machine *_machine, Mixer *_mixer)
 	show_welcome_screen();
 }
 
+void GUI::init_headless(Machine *_machine, Mixer *_mixer)
+{
+	m_machine = _machine;
+	m_mixer = _mixer;
+	m_headless = true;
+
+	PINFOF(LOG_V0, LOG_GUI, "Running headless, no window will be created\n");
+}
+
 void GUI::config_changed()
 {
-	m_windows.config_changed();
+	if(!m_headless) {
+		m_windows.config_changed();
+	}
 
 	m_curr_model = m_machine->devices().sysboard()->model_string();
 	m_curr_model += " (" + m_machine->cpu().model() + "@";
@@ -539,6 +551,9 @@ void GUI::GL_debug_output(
 
 void GUI::render()
 {
+	if(m_headless) {
+		return;
+	}
 	SDL_RenderClear(m_SDL_renderer);
 	GLCALL( glViewport(0,0,	m_width, m_height) );
 	m_windows.interface->render();
@@ -650,6 +665,12 @@ bool GUI::dispatch_special_keys(const SDL_Event &_event, SDL_Keycode &_discard_n
 					}, nullptr);
 					return true;
 				}
+				case SDLK_F9: {
+					//maximum emulation speed on/off
+					if(_event.type == SDL_KEYUP) return true;
+					m_machine->cmd_toggle_max_speed();
+					return true;
+				}
 				case SDLK_F10: {
 					//mouse grab
 					if(m_grab_method.compare("ctrl-f10") != 0) return false;
@@ -756,6 +777,10 @@ void GUI::dispatch_event(const SDL_Event &_event)
 	static bool special_key = false;
 	static SDL_Keycode discard_next_key = 0;
 
+	if(m_headless) {
+		return;
+	}
+
 	if(_event.type == SDL_WINDOWEVENT) {
 		dispatch_window_event(_event.window);
 	} else if(_event.type == SDL_USEREVENT) {
@@ -1081,6 +1106,9 @@ void GUI::dispatch_rocket_event(const SDL_Event &event)
 
 void GUI::update(uint64_t _current_time)
 {
+	if(m_headless) {
+		return;
+	}
 	m_windows.update(_current_time);
 
 	/* during a libRocket Context update no other thread can call any windows
@@ -1124,6 +1152,9 @@ void GUI::shutdown_SDL()
 
 void GUI::shutdown()
 {
+	if(m_headless) {
+		return;
+	}
 	SDL_RemoveTimer(m_second_timer);
 
 	m_windows.shutdown();
@@ -1276,6 +1307,10 @@ GLuint GUI::load_texture(const std::string &_path, vec2i *_texdim)
 
 void GUI::save_framebuffer(std::string _screenfile, std::string _palfile)
 {
+	if(m_headless) {
+		PERRF(LOG_GUI, "screenshots are not available when running headless\n");
+		throw std::exception();
+	}
 	m_windows.interface->save_framebuffer(_screenfile, _palfile);
 }
 
@@ -1557,7 +1592,7 @@ void GUI::Windows::update(uint64_t _current_time)
 
 	// timers are where the timed windows events take place
 	// like the interface messages clears
-	while(!timers.update(_current_time));
+	timers.update(_current_time);
 }
 
 void GUI::Windows::toggle_dbg()
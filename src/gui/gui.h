@@ -147,6 +147,10 @@ protected:
 
 	double m_symspeed_factor;
 
+	// without a window the VGA renders in memory only
+	bool m_headless;
+	VGADisplay m_headless_display;
+
 	// mutex must be locked before any access to the libRocket's objects
 	// TODO this mutex is currently used by 1 thread only (GUI). remove?
 	static std::mutex ms_rocket_mutex;
@@ -229,6 +233,7 @@ public:
 	~GUI();
 
 	void init(Machine *_machine, Mixer *_mixer);
+	void init_headless(Machine *_machine, Mixer *_mixer);
 	void config_changed();
 	void render();
 	void dispatch_event(const SDL_Event &_event);
@@ -246,7 +251,14 @@ public:
 	void show_message(const char* _mex);
 	void show_dbg_message(const char* _mex);
 
-	VGADisplay * vga_display() { assert(m_windows.interface); return m_windows.interface->vga_display(); }
+	VGADisplay * vga_display() {
+		if(m_headless) {
+			return &m_headless_display;
+		}
+		assert(m_windows.interface);
+		return m_windows.interface->vga_display();
+	}
+	inline bool is_headless() const { return m_headless; }
 
 	vec2i resize_window(int _width, int _height);
 	int get_window_width() { return m_width; }
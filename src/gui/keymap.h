@@ -35,8 +35,6 @@ struct KeyEntry
 class Keymap
 {
 private:
-	uint32_t convert_string_to_key(const char *);
-
 	KeyEntry *m_keymapTable;
 	uint16_t  m_keymapCount;
 
@@ -55,6 +53,7 @@ public:
 
 	void load(const std::string &_filename);
 	bool is_loaded();
+	uint32_t convert_string_to_key(const char *);
 
 	KeyEntry *find_host_key(uint32_t _hostkeynum);
 	KeyEntry *find_ascii_char(uint8_t _ascii);
@@ -24,13 +24,23 @@
 #include "mixer.h"
 #include "stats.h"
 #include "hardware/memory.h"
+#include "hardware/cpu/mmu.h"
+#include "hardware/cpu/idle.h"
 #include "hardware/devices/cmos.h"
+#include "filesys.h"
 
 #include <Rocket/Core.h>
 #include <sstream>
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
+
+#define STATS_PROFILE_ROWS 10 // number of host time counters shown
 
 event_map_t Stats::ms_evt_map = {
-	GUI_EVT( "close", "click", DebugTools::DebugWindow::on_close )
+	GUI_EVT( "close", "click", DebugTools::DebugWindow::on_close ),
+	GUI_EVT( "save_profile", "click", Stats::on_save_profile )
 };
 
 Stats::Stats(Machine *_machine, GUI * _gui, Mixer *_mixer, RC::Element *_button)
@@ -47,6 +57,10 @@ DebugTools::DebugWindow(_gui, "stats.rml", _button)
 
 	m_mixer = _mixer;
 	m_stats.mixer = get_element("mixer");
+
+	m_stats.profile = get_element("profile");
+	m_prof.enabled = false;
+	m_prof.last_time = 0;
 }
 
 Stats::~Stats()
@@ -56,6 +70,12 @@ Stats::~Stats()
 
 void Stats::update()
 {
+	// the host time profiler runs only while the window is open
+	if(m_enabled != m_prof.enabled) {
+		m_prof.enabled = m_enabled;
+		g_hwprof.set_enabled(m_enabled);
+		m_prof.last_time = 0;
+	}
 	if(!m_enabled) {
 		return;
 	}
@@ -71,6 +91,9 @@ void Stats::update()
 	ss << "CPU time diff: " << int64_t(vdiff/1.0e3) << "<br />";
 
 	ss << hwb;
+	ss << "TLB flushes: " << g_cpummu.TLB_flushes() << "<br />";
+	ss << "TLB misses: " << g_cpummu.TLB_misses() << "<br />";
+	ss << "Idle skipped cycles: " << g_cpuidle.skipped_cycles() << "<br />";
 
 	//read the DOS clock from MEM 0040h:006Ch
 	uint32_t ticks = g_memory.dbg_read_dword(0x0400 + 0x006C);
@@ -101,5 +124,63 @@ void Stats::update()
 	ss << "buffer: " << m_mixer->get_buffer_read_avail() << "<br />";
 	ss << "delay: " << m_mixer->get_buffer_len() << "<br />";
 	m_stats.mixer->SetInnerRML(ss.str().c_str());
+
+	update_profile();
 }
 
+void Stats::update_profile()
+{
+	uint64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+	if(m_prof.last_time && now - m_prof.last_time < 1000000000) {
+		return;
+	}
+
+	std::vector<HWProfiler::CounterData> counters;
+	g_hwprof.get_counters(counters);
+	if(m_prof.last_time == 0) {
+		m_prof.last = counters;
+		m_prof.last_time = now;
+		return;
+	}
+
+	// percent of the wall time spent in the last interval, the sum can be
+	// more than 100% as the machine and the mixer run on different threads
+	double interval = double(now - m_prof.last_time);
+	std::vector<std::pair<double,std::string>> rows;
+	for(size_t i=0; i<counters.size(); i++) {
+		uint64_t last = (i < m_prof.last.size()) ? m_prof.last[i].ns : 0;
+		uint64_t ns = counters[i].ns - last;
+		if(ns) {
+			rows.push_back({ double(ns) * 100.0 / interval, counters[i].name });
+		}
+	}
+	std::sort(rows.begin(), rows.end(), std::greater<std::pair<double,std::string>>());
+	if(rows.size() > STATS_PROFILE_ROWS) {
+		rows.resize(STATS_PROFILE_ROWS);
+	}
+
+	std::stringstream ss;
+	ss << std::fixed << std::setprecision(1);
+	for(auto &row : rows) {
+		ss << row.second << ": " << row.first << "%<br />";
+	}
+	m_stats.profile->SetInnerRML(ss.str().c_str());
+
+	m_prof.last = counters;
+	m_prof.last_time = now;
+}
+
+void Stats::on_save_profile(RC::Event &)
+{
+	std::string path = g_program.config().find_file(PROGRAM_SECTION, PROGRAM_CAPTURE_DIR);
+	std::string filename = FileSys::get_next_filename(path, "profile_", ".csv");
+	std::ofstream file(filename.c_str());
+	if(filename.empty() || !file.is_open()) {
+		PERRF(LOG_GUI, "Unable to save the host time profile\n");
+		return;
+	}
+	g_hwprof.write_csv(file);
+	PINFOF(LOG_V0, LOG_GUI, "Host time profile saved to '%s'\n", filename.c_str());
+	m_gui->show_message("host time profile saved");
+}
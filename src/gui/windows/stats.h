@@ -21,6 +21,7 @@
 #define IBMULATOR_GUI_STATS_H
 
 #include "debugtools.h"
+#include "hwbench.h"
 
 class Machine;
 class GUI;
@@ -31,9 +32,15 @@ class Stats : public DebugTools::DebugWindow
 private:
 
 	struct {
-		Rocket::Core::Element *fps, *machine, *mixer;
+		Rocket::Core::Element *fps, *machine, *mixer, *profile;
 	} m_stats;
 
+	struct {
+		bool enabled;
+		uint64_t last_time; // steady clock, in ns
+		std::vector<HWProfiler::CounterData> last;
+	} m_prof;
+
 	Machine * m_machine;
 	Mixer * m_mixer;
 
@@ -46,6 +53,10 @@ public:
 
 	void update();
 	event_map_t & get_event_map() { return Stats::ms_evt_map; }
+
+private:
+	void update_profile();
+	void on_save_profile(RC::Event &);
 };
 
 #endif
@@ -23,6 +23,8 @@
 #include "cpu/decoder.h"
 #include "cpu/executor.h"
 #include "cpu/mmu.h"
+#include "cpu/icache.h"
+#include "cpu/idle.h"
 #include "cpu/debugger.h"
 #include "machine.h"
 #include "devices.h"
@@ -61,7 +63,10 @@ m_family(0),
 m_signature(0),
 m_frequency(.0),
 m_cycle_time(0),
-m_instr(nullptr)
+m_exec_mode(CPU_EXEC_STEP),
+m_instr(nullptr),
+m_fault_armed(false),
+m_fault_unwind(USE_FAULT_UNWIND)
 {
 	m_shutdown_trap = std::bind(&CPU::default_shutdown_trap,this);
 }
@@ -78,6 +83,7 @@ void CPU::init()
 	m_instr = &nullinstr;
 
 	g_cpubus.init();
+	g_cpuicache.init();
 }
 
 void CPU::config_changed()
@@ -111,12 +117,20 @@ void CPU::config_changed()
 	m_frequency = 1e3 / m_cycle_time; // in MHz
 	g_program.config().set_real(CPU_SECTION, CPU_FREQUENCY, freq);
 
+	static ini_enum_map_t exec_modes = {
+		{ "step",  CPU_EXEC_STEP  },
+		{ "block", CPU_EXEC_BLOCK }
+	};
+	m_exec_mode = g_program.config().get_enum(CPU_SECTION, CPU_EXEC_MODE, exec_modes, CPU_EXEC_STEP);
+
 	PINFOF(LOG_V0, LOG_CPU, "Installed CPU: %s @ %.0fMHz\n", m_model.c_str(), freq);
 	PINFOF(LOG_V1, LOG_CPU, "  Family: %d86, Signature: 0x%04x\n", m_family, m_signature);
 	PINFOF(LOG_V1, LOG_CPU, "  Cycle time: %u nsec (%.3fMHz)\n", m_cycle_time, m_frequency);
+	PINFOF(LOG_V1, LOG_CPU, "  Execution mode: %s\n", m_exec_mode==CPU_EXEC_BLOCK?"block":"step");
 
 	g_cpubus.config_changed();
 	g_cpuexecutor.config_changed();
+	g_cpuidle.config_changed();
 }
 
 void CPU::reset(uint _signal)
@@ -147,6 +161,10 @@ void CPU::reset(uint _signal)
 	g_cpucore.reset();
 	g_cpuexecutor.reset(_signal);
 	g_cpubus.reset();
+	g_cpuicache.flush();
+	g_cpuidle.reset();
+	m_rep.cseip = 0;
+	m_rep.steady = false;
 }
 
 #define CPU_STATE_NAME "CPU"
@@ -177,6 +195,8 @@ void CPU::restore_state(StateBuf &_state)
 
 	m_logger.reset_iret_address();
 	disable_prg_log();
+	g_cpuidle.reset();
+	m_rep.steady = false;
 }
 
 void CPU::power_off()
@@ -185,7 +205,7 @@ void CPU::power_off()
 	disable_prg_log();
 }
 
-uint CPU::step()
+uint CPU::step(int _max_idle_cycles)
 {
 	CPUCore core_log;
 	CPUState state_log;
@@ -197,61 +217,25 @@ uint CPU::step()
 
 	if(m_s.activity_state == CPU_STATE_ACTIVE) {
 
+		bool fault = false;
 		try {
-			if(m_s.async_event) {
-				// check on events which occurred for previous instructions (traps)
-				// and ones which are asynchronous to the CPU (hardware interrupts)
-				handle_async_event();
-				g_cpubus.update(0);
-
-				if(m_s.activity_state != CPU_STATE_ACTIVE) {
-					// something (eg. triple-fault) put the CPU in non active state
-					// return a non zero number of elapsed cycles anyway
-					return 1;
-				}
-			}
-
-			if(m_instr->cseip != CS_EIP) {
-				// When RF is set, it causes any debug fault to be ignored during the next instruction.
-				if(DR7_ENABLED_ANY && !FLAG_RF && !interrupts_inhibited(CPU_INHIBIT_DEBUG)) {
-					// Priority 6:
-					//   Code breakpoint fault.
-					//   Instruction breakpoints are the highest priority debug
-					//   exceptions. They are serviced before any other exceptions
-					//   detected during the decoding or execution of an instruction.
-					uint32_t debug_trap = g_cpucore.match_x86_code_breakpoint(CS_EIP);
-					if(debug_trap & CPU_DEBUG_TRAP_HIT) {
-						m_s.debug_trap = debug_trap | CPU_DEBUG_TRAP_CODE;
-						throw CPUException(CPU_DEBUG_EXC, 0);
-					}
-				}
-
-				// instruction decoding
-				if(!g_cpubus.pq_is_valid()) {
-					g_cpubus.reset_pq();
-					m_instr = g_cpudecoder.decode();
-					cycles.decode = m_instr->size;
-				} else {
-					m_instr = g_cpudecoder.decode();
-				}
-
-				if(CPULOG) {
-					do_log = true;
-					core_log = g_cpucore;
-					state_log = m_s;
-				}
+			if(!step_unwind(cycles, do_log, core_log, state_log, fault)) {
+				// something (eg. triple-fault) put the CPU in non active state
+				// return a non zero number of elapsed cycles anyway
+				return 1;
 			}
-
-			// instruction execution
-			g_cpuexecutor.execute(m_instr);
-
-			cycles.eu = get_execution_cycles(g_cpubus.memory_accessed());
-			int io_time = g_devices.get_last_io_time();
-			if(io_time) {
-				cycles.io = get_io_cycles(io_time);
-			}
-			m_instr->cycles.rep = 0;
 		} catch(CPUException &e) {
+			m_fault_armed = false;
+			m_fault = e;
+			fault = true;
+		} catch(CPUShutdown &s) {
+			m_fault_armed = false;
+			PDEBUGF(LOG_V2, LOG_CPU, "Entering shutdown for %s\n", s.what());
+			g_cpu.enter_sleep_state(CPU_STATE_SHUTDOWN);
+			cycles.eu = 5; //just a random number
+		}
+		if(fault) {
+			CPUException e = m_fault;
 			PDEBUGF(LOG_V2, LOG_CPU, "CPU exception %s\n", e.name());
 			if(STOP_AT_EXC && ((1<<e.vector)&STOP_AT_EXC_VEC)) {
 				g_machine.set_single_step(true);
@@ -269,17 +253,21 @@ uint CPU::step()
 			}
 			exception(e);
 			cycles.eu = 5; //just a random number
-		} catch(CPUShutdown &s) {
-			PDEBUGF(LOG_V2, LOG_CPU, "Entering shutdown for %s\n", s.what());
-			g_cpu.enter_sleep_state(CPU_STATE_SHUTDOWN);
-			cycles.eu = 5; //just a random number
+		} else if(USE_IDLE_SKIP && g_cpuidle.skip_requested()) {
+			// the guest is polling for an event that only an interrupt can
+			// deliver, spend the cycles until the next timer all at once
+			int skip = 0;
+			if(FLAG_IF) {
+				skip = cycles_to_next_timer(_max_idle_cycles) - 1;
+			}
+			g_cpuidle.skip_done(skip);
+			cycles.eu += skip;
 		}
 
 	} else {
 		// the CPU is idle and waiting for an external event
-		wait_for_event();
 		//we need to spend at least 1 cycle, otherwise the timers will never fire
-		cycles.eu = 1;
+		cycles.eu = wait_for_event(_max_idle_cycles);
 	}
 
 	if(g_cpubus.pq_is_valid()) {
@@ -301,6 +289,7 @@ uint CPU::step()
 	cycles.bus = g_cpubus.fetch_cycles() + g_cpubus.mem_r_cycles();
 
 	int tot_cycles = cycles.sum();
+	int iter_cycles = tot_cycles;
 	if(cycles.bus && (g_machine.get_virt_time_ns()%15085)<((tot_cycles*m_cycle_time))) {
 		// DRAM refresh
 		// TODO count only for DRAM not other bus uses
@@ -308,6 +297,17 @@ uint CPU::step()
 	}
 	tot_cycles += cycles.refresh;
 
+	if(USE_REP_BULK && m_instr->rep) {
+		unsigned bulk = g_cpuexecutor.rep_bulk_count();
+		if(bulk) {
+			tot_cycles += rep_bulk_cycles(bulk, iter_cycles, cycles.bus,
+				g_machine.get_virt_time_ns() + tot_cycles*m_cycle_time);
+			m_s.icount += bulk;
+		} else {
+			rep_update(iter_cycles, cycles);
+		}
+	}
+
 	if(CPULOG && do_log) {
 		m_logger.add_entry(
 			g_machine.get_virt_time_ns(), // time
@@ -326,6 +326,182 @@ uint CPU::step()
 	return tot_cycles;
 }
 
+bool CPU::step_unwind(CPUCycles &cycles_, bool &do_log_, CPUCore &core_log_,
+		CPUState &state_log_, bool &fault_)
+{
+#if USE_FAULT_UNWIND
+	/* The faults raised by CPU::raise() jump back here. Only the arguments,
+	 * which live in the caller's frame, are accessed after the jump.
+	 */
+	if(!m_fault_unwind) {
+		return step_execute(cycles_, do_log_, core_log_, state_log_);
+	}
+	if(setjmp(m_fault_env)) {
+		m_fault_armed = false;
+		fault_ = true;
+		return true;
+	}
+	m_fault_armed = true;
+	bool active = step_execute(cycles_, do_log_, core_log_, state_log_);
+	m_fault_armed = false;
+	return active;
+#else
+	UNUSED(fault_);
+	return step_execute(cycles_, do_log_, core_log_, state_log_);
+#endif
+}
+
+bool CPU::step_execute(CPUCycles &cycles_, bool &do_log_, CPUCore &core_log_,
+		CPUState &state_log_)
+{
+	// not a HWProfiler::Scope, a fault can longjmp out of this function
+	HWProfiler::Mark prof;
+
+	if(m_s.async_event) {
+		// check on events which occurred for previous instructions (traps)
+		// and ones which are asynchronous to the CPU (hardware interrupts)
+		handle_async_event();
+		g_cpubus.update(0);
+
+		if(m_s.activity_state != CPU_STATE_ACTIVE) {
+			return false;
+		}
+	}
+
+	if(m_instr->cseip != CS_EIP) {
+		// When RF is set, it causes any debug fault to be ignored during the next instruction.
+		if(DR7_ENABLED_ANY && !FLAG_RF && !interrupts_inhibited(CPU_INHIBIT_DEBUG)) {
+			// Priority 6:
+			//   Code breakpoint fault.
+			//   Instruction breakpoints are the highest priority debug
+			//   exceptions. They are serviced before any other exceptions
+			//   detected during the decoding or execution of an instruction.
+			uint32_t debug_trap = g_cpucore.match_x86_code_breakpoint(CS_EIP);
+			if(debug_trap & CPU_DEBUG_TRAP_HIT) {
+				m_s.debug_trap = debug_trap | CPU_DEBUG_TRAP_CODE;
+				raise(CPU_DEBUG_EXC, 0);
+			}
+		}
+
+		// instruction decoding
+		g_hwprof.begin(prof);
+		if(!g_cpubus.pq_is_valid()) {
+			g_cpubus.reset_pq();
+			m_instr = decode();
+			cycles_.decode = m_instr->size;
+		} else {
+			m_instr = decode();
+		}
+		g_hwprof.end(HWProfiler::CPU_DECODE, prof);
+
+		if(CPULOG) {
+			do_log_ = true;
+			core_log_ = g_cpucore;
+			state_log_ = m_s;
+		}
+	}
+
+	// instruction execution
+	if(USE_REP_BULK && m_instr->rep && m_instr->rep_first) {
+		// a new execution of the REP, the timings of a previous one don't apply
+		m_rep.steady = false;
+		m_rep.cycles = -1;
+	}
+	if(USE_REP_BULK && m_rep.steady && m_instr->rep && m_instr->cseip == m_rep.cseip) {
+		g_cpuexecutor.set_rep_bulk(rep_bulk_max());
+	} else {
+		g_cpuexecutor.set_rep_bulk(0);
+	}
+	g_hwprof.begin(prof);
+	g_cpuexecutor.execute(m_instr);
+	g_hwprof.end(HWProfiler::CPU_EXECUTE, prof);
+
+	cycles_.eu = get_execution_cycles(g_cpubus.memory_accessed());
+	int io_time = g_devices.get_last_io_time();
+	if(io_time) {
+		cycles_.io = get_io_cycles(io_time);
+	}
+	m_instr->cycles.rep = 0;
+
+	return true;
+}
+
+Instruction * CPU::decode()
+{
+#if USE_ICACHE && USE_PREFETCH_QUEUE
+	bool big = REG_CS.desc.big;
+	if(g_cpuicache.lookup(g_cpubus.cseip(), big, m_cached_instr)) {
+		// same cseip but possibly different CS base
+		m_cached_instr.eip = g_cpubus.eip();
+		g_cpubus.skip(m_cached_instr.size);
+		return &m_cached_instr;
+	}
+	Instruction *instr = g_cpudecoder.decode();
+	g_cpuicache.insert(*instr, big);
+	return instr;
+#else
+	return g_cpudecoder.decode();
+#endif
+}
+
+void CPU::rep_update(int _cycles, const CPUCycles &_c)
+{
+	/* The timings of an iteration depend on the bus state left by the
+	 * previous one. When the prefetch queue is full no code is fetched and
+	 * two consecutive iterations with the same cycles mean that all the next
+	 * ones will have the same cycles too (the DRAM refresh apart).
+	 */
+	bool steady = (_c.decode == 0 && _c.io == 0 &&
+			g_cpubus.fetch_cycles() == 0 && g_cpubus.pipelined_fetch_cycles() == 0);
+	if(steady && m_rep.cseip == m_instr->cseip && m_rep.cycles == _cycles) {
+		m_rep.steady = true;
+	} else {
+		m_rep.steady = false;
+		m_rep.cseip = m_instr->cseip;
+		m_rep.cycles = steady ? _cycles : -1;
+	}
+}
+
+unsigned CPU::rep_bulk_max() const
+{
+	/* The iterations executed in bulk must end before the next timer fires,
+	 * so the machine can't observe any difference with the normal execution.
+	 */
+	if(CPULOG) {
+		return 0;
+	}
+	uint64_t now = g_machine.get_virt_time_ns();
+	uint64_t next = g_machine.get_next_timer_time();
+	if(next <= now) {
+		return 0;
+	}
+	uint64_t iter_ns = uint64_t(m_rep.cycles + g_memory.dram_cycles()) * m_cycle_time;
+	if(iter_ns == 0) {
+		return 0;
+	}
+	uint64_t count = (next - now) / iter_ns;
+	if(count < 2) {
+		return 0;
+	}
+	// the first iteration is always executed the normal way
+	return std::min(count - 1, uint64_t(CPU_REP_BULK_MAX));
+}
+
+int CPU::rep_bulk_cycles(unsigned _count, int _cycles, bool _bus, uint64_t _time) const
+{
+	// same timings and DRAM refresh logic of step() for every iteration
+	int total = 0;
+	for(unsigned i=0; i<_count; i++) {
+		int c = _cycles;
+		if(_bus && (_time%15085) < uint64_t(c*m_cycle_time)) {
+			c += g_memory.dram_cycles();
+		}
+		total += c;
+		_time += c * m_cycle_time;
+	}
+	return total;
+}
+
 int CPU::get_execution_cycles(bool _memtx)
 {
 	unsigned cycles_spent = 0;
@@ -407,9 +583,10 @@ void CPU::enter_sleep_state(CPUActivityState _state)
 	// state until one of the wakeup conditions is met.
 }
 
-void CPU::wait_for_event()
+int CPU::wait_for_event(int _max_cycles)
 {
 	// pass the time until an interrupt wakes up the CPU.
+	// returns the number of cycles spent waiting.
 
 	if((is_pending(CPU_EVENT_PENDING_INTR) && FLAG_IF)
 		|| is_unmasked_event_pending(CPU_EVENT_NMI) )
@@ -417,17 +594,48 @@ void CPU::wait_for_event()
 		// interrupt ends the HALT condition
 		m_s.activity_state = CPU_STATE_ACTIVE;
 		m_s.inhibit_mask = 0; // clear inhibits for after resume
-		return;
+		return 1;
 	}
 
 	if(m_s.activity_state == CPU_STATE_ACTIVE) {
-		return;
+		return 1;
 	}
 
 	if(m_s.HRQ) {
 		// handle DMA also when CPU is halted
 		g_devices.dma()->raise_HLDA();
+		return 1;
+	}
+
+	return idle_cycles(_max_cycles);
+}
+
+int CPU::idle_cycles(int _max_cycles) const
+{
+	/* A sleeping CPU can only be woken up by an interrupt, and interrupts are
+	 * raised by the devices when their timers fire. If the bus has nothing
+	 * left to do, every cycle until the next timer is the same, so they can
+	 * be spent in one step: the timer fires at the same cycle it would have
+	 * fired spending them one at a time.
+	 */
+	if(!USE_IDLE_SKIP || !g_cpubus.is_idle()) {
+		return 1;
+	}
+	return cycles_to_next_timer(_max_cycles);
+}
+
+int CPU::cycles_to_next_timer(int _max_cycles) const
+{
+	if(_max_cycles <= 1) {
+		return 1;
+	}
+	uint64_t now = g_machine.get_virt_time_ns();
+	uint64_t next = g_machine.get_next_timer_time();
+	if(next <= now) {
+		return 1;
 	}
+	uint64_t cycles = (next - now + m_cycle_time - 1) / m_cycle_time;
+	return std::max(1, int(std::min(cycles, uint64_t(_max_cycles))));
 }
 
 void CPU::handle_async_event()
@@ -440,7 +648,7 @@ void CPU::handle_async_event()
 	// Priority 2: Trap on Task Switch
 	//   T flag in TSS is set
 	if(m_s.debug_trap & CPU_DEBUG_TRAP_TASK_SWITCH_BIT) {
-		throw CPUException(CPU_DEBUG_EXC, 0);
+		raise(CPU_DEBUG_EXC, 0);
 	}
 
 	// Priority 3: External Hardware Interventions
@@ -461,7 +669,7 @@ void CPU::handle_async_event()
 				// on previous instruction.
 				m_s.debug_trap |= g_cpucore.match_x86_code_breakpoint(m_instr->cseip);
 			}
-			throw CPUException(CPU_DEBUG_EXC, 0);
+			raise(CPU_DEBUG_EXC, 0);
 		} else {
 			m_s.debug_trap = 0;
 		}
@@ -584,7 +792,7 @@ void CPU::interrupt(uint8_t _vector, unsigned _type, bool _push_error, uint16_t
 
 	if(_type==CPU_SOFTWARE_INTERRUPT && IS_V8086() && (FLAG_IOPL < 3)) {
 		PDEBUGF(LOG_V1, LOG_CPU, "Software INT 0x%02X (%d) in V8086 mode with IOPL:%d\n", _vector, _vector, FLAG_IOPL);
-		throw CPUException(CPU_GP_EXC, 0);
+		raise(CPU_GP_EXC, 0);
 	}
 
 	if(IS_RMODE()) {
@@ -703,6 +911,7 @@ void CPU::exception(CPUException _exc)
 	m_s.EXT = true;
 
 	try {
+		CPUFaultScope fault_scope;
 		interrupt(_exc.vector, CPU_HARDWARE_EXCEPTION, push_error, error_code);
 	} catch(CPUException &e) {
 		/* If another protection violation occurs during the processing of
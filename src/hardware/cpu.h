@@ -26,6 +26,7 @@
 #include "cpu/exception.h"
 #include "cpu/logger.h"
 #include <regex>
+#include <csetjmp>
 
 class CPU;
 extern CPU g_cpu;
@@ -50,8 +51,22 @@ enum CPUFamily {
 	CPU_COUNT = 2
 };
 
+#define CPU_REP_BULK_MAX 4096 // max iterations of a REP instruction executed in bulk
+
 #define CPU_FAMILY  g_cpu.family()
 
+/* Execution modes.
+ * step:  the machine advances the CPU one instruction at a time.
+ * block: the machine steps the CPU back to back until a control transfer or
+ *        the next timer, doing its bookkeeping once per batch. Instructions
+ *        are still executed one at a time by CPU::step() and timers are
+ *        still fired at the exact instruction.
+ */
+enum CPUExecMode {
+	CPU_EXEC_STEP,
+	CPU_EXEC_BLOCK
+};
+
 /* Signatures are reported in the EDX register upon a RESET.
 Sig    Model       Step
 -----------------------
@@ -84,11 +99,26 @@ protected:
 	unsigned m_signature;
 	double   m_frequency;
 	uint32_t m_cycle_time;
+	unsigned m_exec_mode;
 	Instruction *m_instr;
+	Instruction m_cached_instr;
 	std::function<void(void)> m_shutdown_trap;
 
 	CPUState m_s;
 
+	// timings of the REP string instruction in execution, for bulk execution
+	struct {
+		uint32_t cseip;  // the instruction address
+		int  cycles;     // the cycles of the last iteration, DRAM refresh excluded
+		bool steady;     // the last two iterations had the same timings
+	} m_rep;
+
+	// the unwind point of the faults raised while executing an instruction
+	jmp_buf m_fault_env;
+	bool    m_fault_armed;
+	bool    m_fault_unwind; // USE_FAULT_UNWIND, can be disabled for benchmarks
+	CPUException m_fault;
+
 	CPULogger m_logger;
 	std::string m_log_prg_name;
 	std::regex m_log_prg_regex;
@@ -102,13 +132,20 @@ public:
 	void power_off();
 	void config_changed();
 
-	uint step();
+	uint step(int _max_idle_cycles = 1);
 
 	inline std::string model() const { return m_model; }
 	inline unsigned family() const { return m_family; }
 	inline unsigned signature() const { return m_signature; }
 	inline double frequency() const { return m_frequency; }
 	inline uint32_t cycle_time_ns() const { return m_cycle_time; }
+	inline unsigned exec_mode() const { return m_exec_mode; }
+	inline uint64_t get_icount() const { return m_s.icount; }
+	inline bool events_pending() const { return m_s.pending_event || m_s.HRQ; }
+	inline void set_fault_unwind(bool _enabled) { m_fault_unwind = USE_FAULT_UNWIND && _enabled; }
+	inline bool fault_unwind() const { return m_fault_unwind; }
+
+	[[noreturn]] inline void raise(uint8_t _vector, uint16_t _error_code);
 
 	void interrupt(uint8_t _vector, unsigned _type, bool _push_error, uint16_t _error_code);
 	void clear_INTR();
@@ -154,10 +191,51 @@ protected:
 	void default_shutdown_trap() {}
 	bool is_double_fault(uint8_t _first_vec, uint8_t _current_vec);
 
-	void wait_for_event();
+	int wait_for_event(int _max_cycles);
+	int idle_cycles(int _max_cycles) const;
+	int cycles_to_next_timer(int _max_cycles) const;
+	bool step_unwind(CPUCycles &cycles_, bool &do_log_, CPUCore &core_log_,
+			CPUState &state_log_, bool &fault_);
+	bool step_execute(CPUCycles &cycles_, bool &do_log_, CPUCore &core_log_,
+			CPUState &state_log_);
+	Instruction * decode();
+	unsigned rep_bulk_max() const;
+	int rep_bulk_cycles(unsigned _count, int _cycles, bool _bus, uint64_t _time) const;
+	void rep_update(int _cycles, const CPUCycles &_c);
 
 	int get_execution_cycles(bool _memtx);
 	int get_io_cycles(int _io_time);
+
+	friend class CPUFaultScope;
+};
+
+/* Raises a CPU exception.
+ * During the execution of an instruction the fault is propagated with a
+ * longjmp to the single unwind point in CPU::step(), which is much cheaper
+ * than unwinding the stack with a C++ exception. The code between the raise
+ * and the unwind point must not have locals with non-trivial destructors.
+ * Outside of CPU::step() or inside a CPUFaultScope a CPUException is thrown.
+ */
+inline void CPU::raise(uint8_t _vector, uint16_t _error_code)
+{
+	if(USE_FAULT_UNWIND && m_fault_armed) {
+		m_fault = CPUException(_vector, _error_code);
+		longjmp(m_fault_env, 1);
+	}
+	throw CPUException(_vector, _error_code);
+}
+
+/* To be declared before a try block that catches a CPUException, so that the
+ * faults raised inside it are thrown instead of unwinding to CPU::step().
+ */
+class CPUFaultScope
+{
+	bool m_armed;
+public:
+	CPUFaultScope() : m_armed(g_cpu.m_fault_armed) { g_cpu.m_fault_armed = false; }
+	~CPUFaultScope() { g_cpu.m_fault_armed = m_armed; }
+	CPUFaultScope(const CPUFaultScope &) = delete;
+	CPUFaultScope & operator=(const CPUFaultScope &) = delete;
 };
 
 
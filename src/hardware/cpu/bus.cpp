@@ -20,6 +20,7 @@
 #include "ibmulator.h"
 #include "bus.h"
 #include "mmu.h"
+#include "icache.h"
 #include "../cpu.h"
 #include "program.h"
 #include <cstring>
@@ -32,7 +33,8 @@ CPUBus g_cpubus;
 
 CPUBus::CPUBus()
 : m_cycles_ahead(0),
-  m_wq_idx(-1)
+  m_wq_idx(-1),
+  m_wq_flushed(0)
 {
 	memset(&m_s, 0, sizeof(m_s));
 	memset(&m_write_queue, 0, sizeof(m_write_queue));
@@ -147,19 +149,37 @@ void CPUBus::update(int _cycles)
 		if(_cycles <= 0) {
 			m_cycles_ahead = (-1 * _cycles);
 		}
-		for(int i=0; i<=m_wq_idx; i++) {
+		for(int i=m_wq_flushed; i<=m_wq_idx; i++) {
 			(this->*m_write_queue[i].w_fn)(
 					m_write_queue[i].address,
 					m_write_queue[i].data,
 					m_mem_w_cycles);
 		}
 		m_wq_idx = -1;
+		m_wq_flushed = 0;
 		m_cycles_ahead += m_mem_w_cycles;
 #else
 		m_mem_r_cycles += m_mem_w_cycles;
 #endif
 }
 
+void CPUBus::flush_write_queue()
+{
+	/* Executes the queued memory writes before the end of the instruction,
+	 * for the operations that access the memory directly (REP bulk).
+	 * The writes stay in the queue to update() so the timings don't change.
+	 */
+#if USE_PREFETCH_QUEUE
+	for(int i=m_wq_flushed; i<=m_wq_idx; i++) {
+		(this->*m_write_queue[i].w_fn)(
+				m_write_queue[i].address,
+				m_write_queue[i].data,
+				m_mem_w_cycles);
+	}
+	m_wq_flushed = m_wq_idx + 1;
+#endif
+}
+
 template<int len>
 uint32_t CPUBus::mmu_read(uint32_t _linear, int &_cycles)
 {
@@ -204,6 +224,7 @@ int CPUBus::fill_pq(int _amount, int _cycles, bool _paddress)
 			// reads must be inside dword boundaries
 			assert((PAGE_OFFSET(m_s.pq_tail) + adv) <= 4096);
 			try {
+				CPUFaultScope fault_scope;
 				switch(adv) {
 					case 2: // word aligned
 						*((uint16_t*)pq_ptr) = mmu_read<2>(m_s.pq_tail, c);
@@ -439,6 +460,32 @@ void CPUBus::p_mem_write<4>(uint32_t _addr, uint32_t _data, int &_cycles)
 	}
 }
 
+/* Host TLB writes, _offset is the masked physical address.
+ */
+template<>
+void CPUBus::p_host_write<1>(uint32_t _offset, uint32_t _data, int &_cycles)
+{
+	g_cpuicache.write_notify(_offset, 1);
+	g_memory.m_ram.buffer[_offset] = _data;
+	_cycles += g_memory.dram_cycles();
+}
+
+template<>
+void CPUBus::p_host_write<2>(uint32_t _offset, uint32_t _data, int &_cycles)
+{
+	g_cpuicache.write_notify(_offset, 2);
+	*(uint16_t*)(&g_memory.m_ram.buffer[_offset]) = _data;
+	_cycles += g_memory.dram_cycles();
+}
+
+template<>
+void CPUBus::p_host_write<4>(uint32_t _offset, uint32_t _data, int &_cycles)
+{
+	g_cpuicache.write_notify(_offset, 4);
+	*(uint32_t*)(&g_memory.m_ram.buffer[_offset]) = _data;
+	_cycles += g_memory.dram_cycles();
+}
+
 int CPUBus::write_pq_to_logfile(FILE *_dest)
 {
 	int res = 0;
@@ -23,6 +23,7 @@
 #include "core.h"
 #include "mmu.h"
 #include "../memory.h"
+#include <algorithm>
 
 #define CPU_PQ_MAX_SIZE  16
 #define CPU_BUS_WQ_SIZE  50
@@ -63,6 +64,7 @@ private:
 	};
 	wq_data m_write_queue[CPU_BUS_WQ_SIZE];
 	int m_wq_idx;
+	int m_wq_flushed; // number of queued writes already executed
 
 public:
 	CPUBus();
@@ -83,14 +85,20 @@ public:
 	inline bool memory_written() const { return (m_wq_idx>=0) || m_mem_w_cycles; }
 	inline int  fetch_cycles() const { return m_fetch_cycles; }
 	inline int  mem_r_cycles() const { return m_mem_r_cycles; }
+	inline void add_mem_r_cycles(int _cycles) { m_mem_r_cycles += _cycles; }
 	inline int  mem_tx_cycles() const { return m_mem_r_cycles + m_mem_w_cycles; }
 	inline int  pipelined_mem_cycles() const { return m_pmem_cycles; }
 	inline int  pipelined_fetch_cycles() const { return m_pfetch_cycles; }
 	inline int  cycles_ahead() const { return m_cycles_ahead; }
 	inline bool pq_is_valid() const { return m_s.pq_valid; }
+	// no fetches or pending cycles, the next cycles won't use the bus
+	inline bool is_idle() const {
+		return !m_cycles_ahead && (!m_s.pq_valid || (m_pq_size - m_s.pq_len) < m_pq_thres);
+	}
 	inline int  width() const { return m_width; }
 
 	void update(int _cycles);
+	void flush_write_queue();
 	void enable_paging(bool _enabled);
 
 	//instruction fetching
@@ -104,6 +112,24 @@ public:
 	inline uint32_t fetchdw() { return fetch_noqueue<uint32_t,4>(); }
 	#endif
 
+	// consumes _len bytes of the queue as if they were fetched one at a time
+	inline void skip(unsigned _len) {
+		while(_len) {
+			if(m_s.pq_len < 1) {
+				m_fetch_cycles += (this->*fill_pq_fn)(1, 0, m_fetch_cycles>0);
+				if(m_cycles_ahead) {
+					m_pfetch_cycles += m_cycles_ahead;
+					m_cycles_ahead = 0;
+				}
+			}
+			unsigned len = std::min(_len, unsigned(m_s.pq_len));
+			m_s.pq_len -= len;
+			m_s.cseip += len;
+			m_s.eip += len;
+			_len -= len;
+		}
+	}
+
 	inline uint32_t eip() const { return m_s.eip; }
 	inline uint32_t cseip() const { return m_s.cseip; }
 
@@ -135,6 +161,34 @@ public:
 		#endif
 	}
 
+	/* Accesses to RAM pages through the host TLB (see CPUMMU). _host points to
+	 * the data in the RAM buffer. Only the accesses that Memory would execute
+	 * with a single transfer are done directly, the others use the normal path
+	 * so the timings are always the same.
+	 */
+	template<unsigned S> inline uint32_t mem_read(uint32_t _addr, const uint8_t *_host)
+	{
+		if(_host && host_access<S>(_addr)) {
+			m_mem_r_cycles += g_memory.dram_cycles();
+			return host_read<S>(_host);
+		}
+		return p_mem_read<S>(_addr, m_mem_r_cycles);
+	}
+	template<unsigned S> inline void mem_write(uint32_t _addr, uint32_t _data, const uint8_t *_host)
+	{
+		if(_host && host_access<S>(_addr)) {
+			uint32_t offset = _host - g_memory.m_ram.buffer;
+			#if USE_PREFETCH_QUEUE
+			assert(m_wq_idx<CPU_BUS_WQ_SIZE-1);
+			m_write_queue[++m_wq_idx] = { &CPUBus::p_host_write<S>, offset, _data };
+			#else
+			p_host_write<S>(offset, _data, m_mem_w_cycles);
+			#endif
+		} else {
+			mem_write<S>(_addr, _data);
+		}
+	}
+
 	void save_state(StateBuf &_state);
 	void restore_state(StateBuf &_state);
 
@@ -144,6 +198,27 @@ private:
 	template<unsigned> uint32_t p_mem_read(uint32_t _addr, int &_cycles) { assert(false); return 0; }
 	template<unsigned> void p_mem_write(uint32_t _addr, uint32_t _data, int &_cycles) { assert(false); }
 
+	template<unsigned S>
+	ALWAYS_INLINE
+	inline bool host_access(uint32_t _addr) const {
+		switch(S) {
+			case 1: return true;
+			case 2: return ((_addr&0x1)==0) || (m_width==32 && ((_addr&0x3)==1));
+			case 4: return (m_width==32 && ((_addr&0x3)==0));
+			default: return false;
+		}
+	}
+	template<unsigned S>
+	ALWAYS_INLINE
+	static inline uint32_t host_read(const uint8_t *_host) {
+		switch(S) {
+			case 1: return *_host;
+			case 2: return *(const uint16_t*)_host;
+			default: return *(const uint32_t*)_host;
+		}
+	}
+	template<unsigned> void p_host_write(uint32_t _offset, uint32_t _data, int &_cycles) { assert(false); }
+
 	ALWAYS_INLINE
 	inline int pq_free_space() {
 		return m_pq_size - m_s.pq_len;
@@ -212,5 +287,9 @@ template<> void CPUBus::p_mem_write<2>(uint32_t _addr, uint32_t _data, int &_cyc
 template<> void CPUBus::p_mem_write<3>(uint32_t _addr, uint32_t _data, int &_cycles);
 template<> void CPUBus::p_mem_write<4>(uint32_t _addr, uint32_t _data, int &_cycles);
 
+template<> void CPUBus::p_host_write<1>(uint32_t _offset, uint32_t _data, int &_cycles);
+template<> void CPUBus::p_host_write<2>(uint32_t _offset, uint32_t _data, int &_cycles);
+template<> void CPUBus::p_host_write<4>(uint32_t _offset, uint32_t _data, int &_cycles);
+
 
 #endif
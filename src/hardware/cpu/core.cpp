@@ -44,6 +44,7 @@ void CPUCore::reset()
 	memset(m_segregs, 0, sizeof(SegReg)*10);
 
 	m_eflags = 0x00000002;
+	m_lf.op = LF_NONE;
 	m_cr[0] = 0x0;
 	m_cr[2] = 0x0;
 	m_cr[3] = 0x0;
@@ -94,6 +95,7 @@ void CPUCore::reset()
 void CPUCore::save_state(StateBuf &_state) const
 {
 	static_assert(std::is_pod<CPUCore>::value, "CPUCore must be POD");
+	materialize_flags();
 	StateHeader h;
 	h.name = CPUCORE_STATE_NAME;
 	h.data_size = sizeof(CPUCore);
@@ -209,7 +211,7 @@ void CPUCore::load_segment_protected(SegReg & _segreg, uint16_t _value)
 
 		if ((_value & SELECTOR_RPL_MASK) == 0) {
 			PDEBUGF(LOG_V2, LOG_CPU, "load_segment_protected(SS): null selector\n");
-			throw CPUException(CPU_GP_EXC, _value & SELECTOR_RPL_MASK);
+			g_cpu.raise(CPU_GP_EXC, _value & SELECTOR_RPL_MASK);
 		}
 
 		selector = _value;
@@ -217,29 +219,29 @@ void CPUCore::load_segment_protected(SegReg & _segreg, uint16_t _value)
 		/* selector's RPL must be equal to CPL, else #GP(selector) */
 		if(selector.rpl != CPL) {
 			PDEBUGF(LOG_V2, LOG_CPU, "load_segment_protected(SS): rpl != CPL\n");
-			throw CPUException(CPU_GP_EXC, _value & SELECTOR_RPL_MASK);
+			g_cpu.raise(CPU_GP_EXC, _value & SELECTOR_RPL_MASK);
 		}
 
 		descriptor = g_cpuexecutor.fetch_descriptor(selector, CPU_GP_EXC);
 
 		if(!descriptor.valid) {
 			PDEBUGF(LOG_V2, LOG_CPU,"load_segment_protected(SS): not valid\n");
-			throw CPUException(CPU_GP_EXC, _value & SELECTOR_RPL_MASK);
+			g_cpu.raise(CPU_GP_EXC, _value & SELECTOR_RPL_MASK);
 		}
 		/* AR byte must indicate a writable data segment else #GP(selector) */
 		if(!descriptor.is_data_segment() || !descriptor.is_writeable()) {
 			PDEBUGF(LOG_V2, LOG_CPU, "load_segment_protected(SS): not writable data segment\n");
-			throw CPUException(CPU_GP_EXC, _value & SELECTOR_RPL_MASK);
+			g_cpu.raise(CPU_GP_EXC, _value & SELECTOR_RPL_MASK);
 		}
 		/* DPL in the AR byte must equal CPL else #GP(selector) */
 		if(descriptor.dpl != CPL) {
 			PDEBUGF(LOG_V2, LOG_CPU,"load_segment_protected(SS): dpl != CPL\n");
-			throw CPUException(CPU_GP_EXC, _value & SELECTOR_RPL_MASK);
+			g_cpu.raise(CPU_GP_EXC, _value & SELECTOR_RPL_MASK);
 		}
 		/* segment must be marked PRESENT else #SS(selector) */
 		if(!descriptor.present) {
 			PDEBUGF(LOG_V2, LOG_CPU,"load_segment_protected(SS): not present\n");
-			throw CPUException(CPU_SS_EXC, _value & SELECTOR_RPL_MASK);
+			g_cpu.raise(CPU_SS_EXC, _value & SELECTOR_RPL_MASK);
 		}
 
 		/* set accessed bit */
@@ -267,7 +269,7 @@ void CPUCore::load_segment_protected(SegReg & _segreg, uint16_t _value)
 		if(descriptor.valid==0) {
 			PDEBUGF(LOG_V2, LOG_CPU,"load_segment_protected(%s, 0x%04x): invalid segment\n",
 					_segreg.to_string(), _value);
-			throw CPUException(CPU_GP_EXC, _value & SELECTOR_RPL_MASK);
+			g_cpu.raise(CPU_GP_EXC, _value & SELECTOR_RPL_MASK);
 		}
 
 		/* AR byte must indicate a writable data segment else #GP(selector) */
@@ -277,7 +279,7 @@ void CPUCore::load_segment_protected(SegReg & _segreg, uint16_t _value)
 		) {
 			PDEBUGF(LOG_V2, LOG_CPU, "load_segment_protected(%s, 0x%04x): not data or readable code (AR=0x%02X)\n",
 					_segreg.to_string(), _value, descriptor.get_AR());
-			throw CPUException(CPU_GP_EXC, _value & SELECTOR_RPL_MASK);
+			g_cpu.raise(CPU_GP_EXC, _value & SELECTOR_RPL_MASK);
 		}
 
 		/* If data or non-conforming code, then both the RPL and the CPL
@@ -286,7 +288,7 @@ void CPUCore::load_segment_protected(SegReg & _segreg, uint16_t _value)
 			if((selector.rpl > descriptor.dpl) || (CPL > descriptor.dpl)) {
 				PDEBUGF(LOG_V2, LOG_CPU, "load_segment_protected(%s, 0x%04x): RPL & CPL must be <= DPL\n",
 						_segreg.to_string(), _value);
-				throw CPUException(CPU_GP_EXC, _value & SELECTOR_RPL_MASK);
+				g_cpu.raise(CPU_GP_EXC, _value & SELECTOR_RPL_MASK);
 			}
 		}
 
@@ -294,7 +296,7 @@ void CPUCore::load_segment_protected(SegReg & _segreg, uint16_t _value)
 		if(!descriptor.present) {
 			PDEBUGF(LOG_V2, LOG_CPU,"load_segment_protected(%s, 0x%04x): segment not present\n",
 					_segreg.to_string(), _value);
-			throw CPUException(CPU_NP_EXC, _value & SELECTOR_RPL_MASK);
+			g_cpu.raise(CPU_NP_EXC, _value & SELECTOR_RPL_MASK);
 		}
 
 		/* set accessed bit */
@@ -316,7 +318,7 @@ void CPUCore::check_CS(uint16_t selector, Descriptor &descriptor, uint8_t rpl, u
 	// descriptor AR byte must indicate code segment else #GP(selector)
 	if(!descriptor.valid || !descriptor.is_code_segment()) {
 		PDEBUGF(LOG_V2, LOG_CPU,"check_CS(0x%04x): not a valid code segment\n", selector);
-		throw CPUException(CPU_GP_EXC, selector & SELECTOR_RPL_MASK);
+		g_cpu.raise(CPU_GP_EXC, selector & SELECTOR_RPL_MASK);
 	}
 
 	// if non-conforming, code segment descriptor DPL must = CPL else #GP(selector)
@@ -324,14 +326,14 @@ void CPUCore::check_CS(uint16_t selector, Descriptor &descriptor, uint8_t rpl, u
 		if(descriptor.dpl != cpl) {
 			PDEBUGF(LOG_V2, LOG_CPU,"check_CS(0x%04x): non-conforming code seg descriptor dpl != cpl, dpl=%d, cpl=%d\n",
 					selector, descriptor.dpl, cpl);
-			throw CPUException(CPU_GP_EXC, selector & SELECTOR_RPL_MASK);
+			g_cpu.raise(CPU_GP_EXC, selector & SELECTOR_RPL_MASK);
 		}
 
 		/* RPL of destination selector must be <= CPL else #GP(selector) */
 		if(rpl > cpl) {
 			PDEBUGF(LOG_V2, LOG_CPU,"check_CS(0x%04x): non-conforming code seg selector rpl > cpl, rpl=%d, cpl=%d\n",
 					selector, rpl, cpl);
-			throw CPUException(CPU_GP_EXC, selector & SELECTOR_RPL_MASK);
+			g_cpu.raise(CPU_GP_EXC, selector & SELECTOR_RPL_MASK);
 		}
 	}
 	// if conforming, then code segment descriptor DPL must <= CPL else #GP(selector)
@@ -339,14 +341,14 @@ void CPUCore::check_CS(uint16_t selector, Descriptor &descriptor, uint8_t rpl, u
 		if(descriptor.dpl > cpl) {
 			PDEBUGF(LOG_V2, LOG_CPU,"check_CS(0x%04x): conforming code seg descriptor dpl > cpl, dpl=%d, cpl=%d\n",
 					selector, descriptor.dpl, cpl);
-			throw CPUException(CPU_GP_EXC, selector & SELECTOR_RPL_MASK);
+			g_cpu.raise(CPU_GP_EXC, selector & SELECTOR_RPL_MASK);
 		}
 	}
 
 	// code segment must be present else #NP(selector)
 	if(!descriptor.present) {
 		PDEBUGF(LOG_V2, LOG_CPU,"check_CS(0x%04x): code segment not present\n", selector);
-		throw CPUException(CPU_NP_EXC, selector & SELECTOR_RPL_MASK);
+		g_cpu.raise(CPU_NP_EXC, selector & SELECTOR_RPL_MASK);
 	}
 }
 
@@ -378,8 +380,64 @@ void CPUCore::set_SS(Selector &selector, Descriptor &descriptor, uint8_t cpl)
 	REG_SS.sel.cpl = cpl;
 }
 
+void CPUCore::materialize_flags() const
+{
+	extern bool parity_table[256];
+
+	const uint32_t op1 = m_lf.op1, op2 = m_lf.op2, res = m_lf.res;
+	uint32_t flags = 0;
+
+	switch(m_lf.op) {
+		case LF_ADD:
+			if(((op1 & op2) | ((op1 | op2) & ~res)) & m_lf.msb) {
+				flags |= FMASK_CF;
+			}
+			// fall through
+		case LF_INC:
+			if(((op1 ^ res) & (op2 ^ res)) & m_lf.msb) {
+				flags |= FMASK_OF;
+			}
+			flags |= (op1 ^ op2 ^ res) & FMASK_AF;
+			break;
+		case LF_SUB:
+			if(((~op1 & op2) | (~(op1 ^ op2) & res)) & m_lf.msb) {
+				flags |= FMASK_CF;
+			}
+			// fall through
+		case LF_DEC:
+			if(((op1 ^ op2) & (op1 ^ res)) & m_lf.msb) {
+				flags |= FMASK_OF;
+			}
+			flags |= (op1 ^ op2 ^ res) & FMASK_AF;
+			break;
+		case LF_LOGIC:
+			break;
+		case LF_NONE:
+		default:
+			return;
+	}
+	if(res & m_lf.msb) {
+		flags |= FMASK_SF;
+	}
+	if(res == 0) {
+		flags |= FMASK_ZF;
+	}
+	if(parity_table[res & 0xFF]) {
+		flags |= FMASK_PF;
+	}
+
+	uint32_t mask = FMASK_ARITH;
+	if(m_lf.op == LF_INC || m_lf.op == LF_DEC) {
+		mask &= ~FMASK_CF;
+	}
+	m_eflags = (m_eflags & ~mask) | flags;
+	m_lf.op = LF_NONE;
+}
+
 void CPUCore::set_FLAGS(uint16_t _val)
 {
+	// all the arithmetic flags are overwritten
+	m_lf.op = LF_NONE;
 	uint16_t f16 = uint16_t(m_eflags);
 	// bit1 is fixed 1
 	m_eflags = (_val & FMASK_VALID) | (m_eflags & 0x30000) | 2;
@@ -393,6 +451,7 @@ void CPUCore::set_FLAGS(uint16_t _val)
 
 void CPUCore::set_EFLAGS(uint32_t _val)
 {
+	m_lf.op = LF_NONE;
 	uint32_t f32 = m_eflags;
 	// bit1 is fixed 1
 	m_eflags = (_val & FMASK_VALID) | 2;
@@ -466,7 +525,7 @@ void CPUCore::set_CR0(uint32_t _cr0)
 
 	if((_cr0&CR0MASK_PG) && !(_cr0&CR0MASK_PE)) {
 		PDEBUGF(LOG_V2, LOG_CPU, "attempt to set CR0.PG with CR0.PE cleared\n");
-		throw CPUException(CPU_GP_EXC, 0);
+		g_cpu.raise(CPU_GP_EXC, 0);
 	}
 
 	uint32_t oldcr0 = m_cr[0];
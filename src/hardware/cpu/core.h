@@ -83,9 +83,11 @@ extern CPUCore g_cpucore;
 #define FMASK_FLAGS  0xFFFF
 #define FMASK_EFLAGS 0x3FFFF
 #define FMASK_VALID  0x00037FD5 // only supported bits for EFLAGS register
+#define FMASK_ARITH  (FMASK_CF|FMASK_PF|FMASK_AF|FMASK_ZF|FMASK_SF|FMASK_OF)
 
 #define GET_FLAG(NAME)     g_cpucore.get_EFLAGS(FMASK_ ## NAME)
 #define SET_FLAG(NAME,VAL) g_cpucore.set_##NAME (VAL)
+#define SET_LAZY_FLAGS(OP,OP1,OP2,RES,MSB) g_cpucore.set_lazy_flags(LF_##OP,OP1,OP2,RES,MSB)
 #define GET_FLAGS()        g_cpucore.get_FLAGS(FMASK_FLAGS)
 #define GET_EFLAGS()       g_cpucore.get_EFLAGS(FMASK_EFLAGS)
 #define SET_FLAGS(VAL)     g_cpucore.set_FLAGS(VAL)
@@ -364,6 +366,28 @@ bits.
 #define IS_PAGING() g_cpucore.is_paging()
 
 
+/* Lazy evaluation of the arithmetic flags.
+ * The most common ALU operations only record their kind, operands and result;
+ * CF,PF,AF,ZF,SF,OF are computed when they are read or when an instruction
+ * modifies only some of them.
+ */
+enum LazyFlagsOp {
+	LF_NONE,  // EFLAGS is up to date
+	LF_ADD,   // ADD,ADC
+	LF_SUB,   // SUB,SBB,CMP,NEG
+	LF_INC,   // INC (CF not affected)
+	LF_DEC,   // DEC (CF not affected)
+	LF_LOGIC  // AND,OR,XOR,TEST
+};
+
+struct LazyFlags
+{
+	LazyFlagsOp op;
+	uint32_t op1, op2;
+	uint32_t res;      // the result truncated to the operand size
+	uint32_t msb;      // the most significant bit mask of the operand size
+};
+
 class CPUCore
 {
 protected:
@@ -375,7 +399,8 @@ protected:
 	SegReg m_segregs[10];
 
 	// status and control registers
-	uint32_t m_eflags;
+	mutable uint32_t m_eflags;
+	mutable LazyFlags m_lf;
 	uint32_t m_eip, m_prev_eip;
 	uint32_t m_cr[4];
 	uint32_t m_dr[8];
@@ -395,8 +420,12 @@ protected:
 	void load_segment_defaults(SegReg & _segreg, uint16_t _value);
 
 	inline void set_flag(uint8_t _flagnum, bool _val) {
+		if(((1<<_flagnum) & FMASK_ARITH) && m_lf.op != LF_NONE) {
+			materialize_flags();
+		}
 		m_eflags = (m_eflags &~ (1<<_flagnum)) | ((_val)<<_flagnum);
 	}
+	void materialize_flags() const;
 
 	void handle_mode_change();
 
@@ -449,8 +478,31 @@ public:
 	inline uint32_t get_EIP() const { return m_eip; }
 	inline void restore_EIP() { m_eip = m_prev_eip; }
 
-	inline uint16_t get_FLAGS(uint16_t _mask) const { return (uint16_t(m_eflags) & _mask); }
-	inline uint32_t get_EFLAGS(uint32_t _mask) const { return (m_eflags & _mask); }
+	inline uint16_t get_FLAGS(uint16_t _mask) const {
+		if((_mask & FMASK_ARITH) && m_lf.op != LF_NONE) {
+			materialize_flags();
+		}
+		return (uint16_t(m_eflags) & _mask);
+	}
+	inline uint32_t get_EFLAGS(uint32_t _mask) const {
+		if((_mask & FMASK_ARITH) && m_lf.op != LF_NONE) {
+			materialize_flags();
+		}
+		return (m_eflags & _mask);
+	}
+	// defer the computation of the arithmetic flags to the next read
+	inline void set_lazy_flags(LazyFlagsOp _op, uint32_t _op1, uint32_t _op2,
+			uint32_t _res, uint32_t _msb) {
+		if((_op == LF_INC || _op == LF_DEC) && m_lf.op != LF_NONE) {
+			// CF is not affected and must be preserved
+			materialize_flags();
+		}
+		m_lf.op = _op;
+		m_lf.op1 = _op1;
+		m_lf.op2 = _op2;
+		m_lf.res = _res;
+		m_lf.msb = _msb;
+	}
 
 	       void set_FLAGS(uint16_t _val);
 	       void set_EFLAGS(uint32_t _val);
@@ -212,7 +212,7 @@ private:
 
 	inline uint8_t fetchb() {
 		uint8_t b = g_cpubus.fetchb();
-		#ifndef NDEBUG
+		#if !defined(NDEBUG) || USE_ICACHE
 		if(m_ilen < CPU_MAX_INSTR_SIZE) {
 			m_instr.bytes[m_ilen] = b;
 		}
@@ -223,7 +223,7 @@ private:
 
 	inline uint16_t fetchw() {
 		uint16_t w = g_cpubus.fetchw();
-		#ifndef NDEBUG
+		#if !defined(NDEBUG) || USE_ICACHE
 		if(m_ilen+1 < CPU_MAX_INSTR_SIZE) {
 			*(uint16_t*)(&m_instr.bytes[m_ilen]) = w;
 		}
@@ -234,7 +234,7 @@ private:
 
 	inline uint32_t fetchdw() {
 		uint32_t dw = g_cpubus.fetchdw();
-		#ifndef NDEBUG
+		#if !defined(NDEBUG) || USE_ICACHE
 		if(m_ilen+3 < CPU_MAX_INSTR_SIZE) {
 			*(uint32_t*)(&m_instr.bytes[m_ilen]) = dw;
 		}
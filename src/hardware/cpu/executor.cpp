@@ -19,7 +19,12 @@
 
 #include "ibmulator.h"
 #include "executor.h"
+#include "mmu.h"
+#include "bus.h"
+#include "icache.h"
+#include "idle.h"
 #include "machine.h"
+#include <cstring>
 
 
 CPUExecutor g_cpuexecutor;
@@ -50,8 +55,14 @@ inline bool rep_string_op(uint16_t _opcode)
 
 CPUExecutor::CPUExecutor()
 :
-m_dos_prg_int_exit(0)
+m_dos_prg_int_exit(0),
+m_rep_bulk_max(0),
+m_rep_bulk_count(0),
+m_desc_cache_gen(1)
 {
+	// generation 0 is never valid
+	memset(m_desc_cache, 0, sizeof(m_desc_cache));
+
 	//register_INT_trap(0x00, 0xFF, &CPUExecutor::INT_debug);
 	register_INT_trap(0x13, 0x13, &CPUExecutor::INT_debug);
 	register_INT_trap(0x21, 0x21, &CPUExecutor::INT_debug);
@@ -62,6 +73,7 @@ void CPUExecutor::reset(uint _signal)
 	m_instr = nullptr;
 	m_base_ds = REGI_DS;
 	m_base_ss = REGI_SS;
+	desc_cache_flush();
 
 	if(_signal == MACHINE_HARD_RESET || _signal == MACHINE_POWER_ON) {
 		m_inttraps_ret.clear();
@@ -83,6 +95,7 @@ void CPUExecutor::config_changed()
 void CPUExecutor::execute(Instruction * _instr)
 {
 	m_instr = _instr;
+	m_rep_bulk_count = 0;
 
 	uint32_t old_eip = REG_EIP;
 
@@ -90,6 +103,10 @@ void CPUExecutor::execute(Instruction * _instr)
 	// throw a CPU exception
 	SET_EIP(REG_EIP + m_instr->size);
 
+	if(USE_IDLE_SKIP && UNLIKELY(m_instr->cseip == g_cpuidle.INT_pending_ret())) {
+		g_cpuidle.INT16_ret();
+	}
+
 	if(INT_TRAPS) {
 		auto ret = m_inttraps_ret.find(m_instr->cseip);
 		if(ret != m_inttraps_ret.end()) {
@@ -111,7 +128,7 @@ void CPUExecutor::execute(Instruction * _instr)
 		// Priority 7:
 		//  Code-Segment Limit Violation
 		PERRF(LOG_CPU, "CS limit violation!\n");
-		throw CPUException(CPU_GP_EXC, 0);
+		g_cpu.raise(CPU_GP_EXC, 0);
 	}
 
 	/* All IA-32 processors manage the RF flag as follows. The RF Flag is
@@ -135,7 +152,7 @@ void CPUExecutor::execute(Instruction * _instr)
 		 * greater than 10 (286) or 15 (386+) bytes in length, it generates
 		 * an exception #13 (General Protection Violation)
 		 */
-		throw CPUException(CPU_GP_EXC, 0);
+		g_cpu.raise(CPU_GP_EXC, 0);
 	}
 
 	if(UNLIKELY(m_instr->lock)) {
@@ -143,7 +160,7 @@ void CPUExecutor::execute(Instruction * _instr)
 		// #GP(O) if the current privilege level is bigger (less privileged)
 		// than the I/O privilege level.
 		if(CPU_FAMILY==CPU_286 && IS_PMODE() && CPL>FLAG_IOPL) {
-			throw CPUException(CPU_GP_EXC, 0);
+			g_cpu.raise(CPU_GP_EXC, 0);
 		}
 	}
 
@@ -192,6 +209,7 @@ void CPUExecutor::rep_16()
 	}
 
 	try {
+		CPUFaultScope fault_scope;
 		// Perform the string operation once.
 		(this->*(m_instr->fn))();
 	} catch(CPUException &e) {
@@ -229,6 +247,19 @@ void CPUExecutor::rep_16()
 		}
 	}
 
+	if(m_rep_bulk_max) {
+		unsigned count = rep_bulk(std::min(m_rep_bulk_max, unsigned(REG_CX)));
+		if(count) {
+			REG_CX -= count;
+			if(REG_CX == 0 || (m_instr->rep_zf &&
+			  ((m_instr->rep_equal && !FLAG_ZF) || (!m_instr->rep_equal && FLAG_ZF))))
+			{
+				COMMIT_EIP();
+				return;
+			}
+		}
+	}
+
 	// REP not finished so back up
 	RESTORE_EIP();
 
@@ -242,6 +273,7 @@ void CPUExecutor::rep_32()
 	}
 
 	try {
+		CPUFaultScope fault_scope;
 		(this->*(m_instr->fn))();
 	} catch(CPUException &e) {
 		RESTORE_EIP();
@@ -261,6 +293,19 @@ void CPUExecutor::rep_32()
 		}
 	}
 
+	if(m_rep_bulk_max) {
+		uint32_t count = rep_bulk(std::min(m_rep_bulk_max, REG_ECX));
+		if(count) {
+			REG_ECX -= count;
+			if(REG_ECX == 0 || (m_instr->rep_zf &&
+			  ((m_instr->rep_equal && !FLAG_ZF) || (!m_instr->rep_equal && FLAG_ZF))))
+			{
+				COMMIT_EIP();
+				return;
+			}
+		}
+	}
+
 	RESTORE_EIP();
 
 	m_instr->rep_first = false;
@@ -276,7 +321,7 @@ void CPUExecutor::illegal_opcode()
 		writecode += 2;
 	}
 	PDEBUGF(LOG_V2, LOG_CPU, "Illegal opcode: %s\n", buf);
-	throw CPUException(CPU_UD_EXC, 0);
+	g_cpu.raise(CPU_UD_EXC, 0);
 }
 
 uint64_t CPUExecutor::fetch_descriptor(Selector & _selector, uint8_t _exc_vec)
@@ -287,23 +332,58 @@ uint64_t CPUExecutor::fetch_descriptor(Selector & _selector, uint8_t _exc_vec)
 		if((offset + 7u) > SEG_REG(REGI_GDTR).desc.limit) {
 			PDEBUGF(LOG_V2, LOG_CPU,"fetch_descriptor: GDT: index (%x) %x > limit (%x)\n",
 					offset + 7u, _selector.index, SEG_REG(REGI_GDTR).desc.limit);
-			throw CPUException(_exc_vec, _selector.value & SELECTOR_RPL_MASK);
+			g_cpu.raise(_exc_vec, _selector.value & SELECTOR_RPL_MASK);
 		}
 		base = SEG_REG(REGI_GDTR).desc.base;
 	} else {
 		// from LDT
 		if(!SEG_REG(REGI_LDTR).desc.valid) {
 			PDEBUGF(LOG_V2, LOG_CPU, "fetch_descriptor: LDTR not valid\n");
-			throw CPUException(_exc_vec, _selector.value & SELECTOR_RPL_MASK);
+			g_cpu.raise(_exc_vec, _selector.value & SELECTOR_RPL_MASK);
 		}
 		if((offset + 7u) > SEG_REG(REGI_LDTR).desc.limit) {
 			PDEBUGF(LOG_V2, LOG_CPU,"fetch_descriptor: LDT: index (%x) %x > limit (%x)\n",
 					offset + 7u, _selector.index, SEG_REG(REGI_LDTR).desc.limit);
-			throw CPUException(_exc_vec, _selector.value & SELECTOR_RPL_MASK);
+			g_cpu.raise(_exc_vec, _selector.value & SELECTOR_RPL_MASK);
 		}
 		base = SEG_REG(REGI_LDTR).desc.base;
 	}
-	return read_qword(base + offset);
+	return read_descriptor(base + offset);
+}
+
+uint64_t CPUExecutor::read_descriptor(uint32_t _linear)
+{
+	/* A cache hit is used only if the descriptor would be read with the same
+	 * page translation and without page walks, so the timings are the same.
+	 */
+	if(UNLIKELY(DR7_ENABLED_ANY) || PAGE_OFFSET(_linear) > 4096-8) {
+		return read_qword(_linear);
+	}
+	DescCacheEntry &e = m_desc_cache[(_linear >> 3) & (CPU_DESC_CACHE_SIZE-1)];
+	uint32_t phy = _linear;
+	bool mapped = !IS_PAGING() || g_cpummu.TLB_peek(_linear, phy);
+	if(mapped && e.linear == _linear && e.gen == m_desc_cache_gen && e.phy == phy
+	&& e.page_gen == *g_cpuicache.page_gen(phy & g_memory.get_address_mask()))
+	{
+		g_cpubus.add_mem_r_cycles(e.cycles);
+		return e.data;
+	}
+
+	int cycles = g_cpubus.mem_r_cycles();
+	uint64_t misses = g_cpummu.TLB_misses();
+	uint64_t data = read_qword(_linear);
+	if(g_cpummu.TLB_misses() == misses
+	&& (!IS_PAGING() || g_cpummu.TLB_peek(_linear, phy))
+	&& g_memory.get_ram_page(phy, false))
+	{
+		e.linear = _linear;
+		e.phy = phy;
+		e.gen = m_desc_cache_gen;
+		e.page_gen = *g_cpuicache.watch_page(phy & g_memory.get_address_mask());
+		e.cycles = g_cpubus.mem_r_cycles() - cycles;
+		e.data = data;
+	}
+	return data;
 }
 
 void CPUExecutor::touch_segment(Selector &_selector, Descriptor &_descriptor)
@@ -29,6 +29,7 @@ extern CPUExecutor g_cpuexecutor;
 #include <stack>
 
 #define CPU_CHECK_REP_STRING_OP false
+#define CPU_DESC_CACHE_SIZE 64 // number of entries in the descriptors cache
 
 
 enum {
@@ -70,6 +71,7 @@ public:
 	struct {
 		uint32_t lin1;
 		uint32_t phy1;
+		uint8_t *host1; // RAM buffer pointer of phy1 if 1 page and in the host TLB
 		uint32_t lin2;
 		uint32_t phy2;
 		unsigned len1;
@@ -77,6 +79,25 @@ public:
 		unsigned pages;
 	} m_cached_phy;
 
+	unsigned m_rep_bulk_max;   // max number of REP iterations to execute in bulk
+	unsigned m_rep_bulk_count; // number of REP iterations executed in bulk
+
+	/* Descriptors cache for the GDT, LDT and IDT lookups, indexed by the
+	 * linear address of the descriptor. An entry is valid until the cache is
+	 * flushed (LGDT, LLDT, LIDT, task switches) or the page of the descriptor
+	 * is written (the accessed bit updates included).
+	 */
+	struct DescCacheEntry {
+		uint32_t linear;   // linear address of the descriptor
+		uint32_t phy;      // physical address of the descriptor
+		uint32_t gen;      // the cache generation
+		uint32_t page_gen; // the generation of the physical page
+		int cycles;        // the bus cycles needed to read the descriptor
+		uint64_t data;
+	};
+	DescCacheEntry m_desc_cache[CPU_DESC_CACHE_SIZE];
+	uint32_t m_desc_cache_gen;
+
 	uint8_t load_eb();
 	uint8_t load_rb();
 	uint16_t load_ew();
@@ -301,6 +322,8 @@ public:
 
 	void rep_16();
 	void rep_32();
+	unsigned rep_bulk(unsigned _count);
+	uint8_t * rep_bulk_block(SegReg &_seg, uint32_t _offset, unsigned _size, bool _write, unsigned &count_);
 	void illegal_opcode();
 
 public:
@@ -311,6 +334,8 @@ public:
 	void config_changed();
 
 	void execute(Instruction * _instr);
+	inline void set_rep_bulk(unsigned _max) { m_rep_bulk_max = _max; }
+	inline unsigned rep_bulk_count() const { return m_rep_bulk_count; }
 	Instruction * get_current_instruction() { return m_instr; }
 
 	void interrupt(uint8_t _vector);
@@ -318,6 +343,8 @@ public:
 			bool _push_error, uint16_t _error_code);
 
 	uint64_t fetch_descriptor(Selector & _selector, uint8_t _exc_vec);
+	uint64_t read_descriptor(uint32_t _linear);
+	inline void desc_cache_flush() { m_desc_cache_gen++; }
 	void touch_segment(Selector & _selector, Descriptor & _descriptor);
 
 	void register_INT_trap(uint8_t _lo_vec, uint8_t _hi_vec, inttrap_fun_t _fn);
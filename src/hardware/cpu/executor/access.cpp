@@ -31,15 +31,15 @@ void CPUExecutor::seg_check_read(SegReg & _seg, uint32_t _offset, unsigned _len,
 		}
 		if(_offset <= _seg.desc.limit || _offset > upper_limit || (upper_limit - _offset) < _len) {
 			PDEBUGF(LOG_V2, LOG_CPU, "seg_check_read(): segment limit violation exp.down\n");
-			throw CPUException(_vector, _errcode);
+			g_cpu.raise(_vector, _errcode);
 		}
 	} else if((_len-1) > _seg.desc.limit || _offset > (_seg.desc.limit-(_len-1))) {
 		PDEBUGF(LOG_V2, LOG_CPU, "seg_check_read(): segment limit violation\n");
-		throw CPUException(_vector, _errcode);
+		g_cpu.raise(_vector, _errcode);
 	}
 	if(_seg.desc.is_code_segment() && !_seg.desc.is_readable()) {
 		PDEBUGF(LOG_V2, LOG_CPU, "seg_check_read(): execute only\n");
-		throw CPUException(_vector, _errcode);
+		g_cpu.raise(_vector, _errcode);
 	}
 }
 
@@ -49,7 +49,7 @@ void CPUExecutor::seg_check_write(SegReg & _seg, uint32_t _offset, unsigned _len
 
 	if(!_seg.desc.is_writeable()) {
 		PDEBUGF(LOG_V2, LOG_CPU, "seg_check_write(): segment not writeable\n");
-		throw CPUException(_vector, _errcode);
+		g_cpu.raise(_vector, _errcode);
 	}
 	if(_seg.desc.is_expand_down()) {
 		uint32_t upper_limit = 0xFFFF;
@@ -58,11 +58,11 @@ void CPUExecutor::seg_check_write(SegReg & _seg, uint32_t _offset, unsigned _len
 		}
 		if(_offset <= _seg.desc.limit || _offset > upper_limit || (upper_limit - _offset) < _len) {
 			PDEBUGF(LOG_V2, LOG_CPU, "seg_check_write(): segment limit violation exp.down\n");
-			throw CPUException(_vector, _errcode);
+			g_cpu.raise(_vector, _errcode);
 		}
 	} else if((_len-1) > _seg.desc.limit || _offset > (_seg.desc.limit-(_len-1))) {
 		PDEBUGF(LOG_V2, LOG_CPU, "seg_check_write(): segment limit violation\n");
-		throw CPUException(_vector, _errcode);
+		g_cpu.raise(_vector, _errcode);
 	}
 }
 
@@ -74,7 +74,7 @@ void CPUExecutor::seg_check(SegReg & _seg, uint32_t _offset, unsigned _len,
 	}
 	if(!_seg.desc.valid) {
 		PDEBUGF(LOG_V2, LOG_CPU, "seg_check(): segment not valid\n");
-		throw CPUException(_vector, _errcode);
+		g_cpu.raise(_vector, _errcode);
 	}
 	if(_write) {
 		seg_check_write(_seg, _offset, _len, _vector, _errcode);
@@ -91,7 +91,7 @@ void CPUExecutor::io_check(uint16_t _port, unsigned _len)
 			 * than IOPL; which is the privilege level found in the flags register.
 			 */
 			PDEBUGF(LOG_V2, LOG_CPU, "I/O access not allowed\n");
-			throw CPUException(CPU_GP_EXC, 0);
+			g_cpu.raise(CPU_GP_EXC, 0);
 		}
 		if(!REG_TR.desc.valid || !REG_TR.desc.is_system_segment() || (
 			REG_TR.desc.type != DESC_TYPE_AVAIL_386_TSS &&
@@ -99,14 +99,14 @@ void CPUExecutor::io_check(uint16_t _port, unsigned _len)
 		))
 		{
 			PDEBUGF(LOG_V2, LOG_CPU, "TR doesn't point to a valid 32bit TSS\n");
-			throw CPUException(CPU_GP_EXC, 0);
+			g_cpu.raise(CPU_GP_EXC, 0);
 		}
 		uint32_t io_base = read_word(REG_TR, 102, CPU_GP_EXC, 0);
 		uint16_t permission = read_word(REG_TR, io_base + _port/8, CPU_GP_EXC, 0);
 		unsigned bit_index = _port & 0x7;
 		unsigned mask = (1 << _len) - 1;
 		if((permission >> bit_index) & mask) {
-			throw CPUException(CPU_GP_EXC, 0);
+			g_cpu.raise(CPU_GP_EXC, 0);
 		}
 	}
 }
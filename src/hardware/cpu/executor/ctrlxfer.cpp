@@ -34,7 +34,7 @@ void CPUExecutor::call_gate(Descriptor &gate_descriptor)
 	// selector must not be null else #GP(0)
 	if((cs_selector.value & SELECTOR_RPL_MASK) == 0) {
 		PDEBUGF(LOG_V2, LOG_CPU, "call_gate: selector in gate null\n");
-		throw CPUException(CPU_GP_EXC, 0);
+		g_cpu.raise(CPU_GP_EXC, 0);
 	}
 	// selector must be within its descriptor table limits,
 	//   else #GP(code segment selector)
@@ -47,13 +47,13 @@ void CPUExecutor::call_gate(Descriptor &gate_descriptor)
 	if(!cs_descriptor.valid || !cs_descriptor.is_code_segment() || cs_descriptor.dpl > CPL)
 	{
 		PDEBUGF(LOG_V2, LOG_CPU, "call_gate: selected descriptor is not code\n");
-		throw CPUException(CPU_GP_EXC, cs_selector.value & SELECTOR_RPL_MASK);
+		g_cpu.raise(CPU_GP_EXC, cs_selector.value & SELECTOR_RPL_MASK);
 	}
 
 	// code segment must be present else #NP(selector)
 	if(!cs_descriptor.present) {
 		PDEBUGF(LOG_V2, LOG_CPU, "call_gate: code segment not present!\n");
-		throw CPUException(CPU_NP_EXC, cs_selector.value & SELECTOR_RPL_MASK);
+		g_cpu.raise(CPU_NP_EXC, cs_selector.value & SELECTOR_RPL_MASK);
 	}
 
 	// CALL GATE TO MORE PRIVILEGE
@@ -75,7 +75,7 @@ void CPUExecutor::call_gate(Descriptor &gate_descriptor)
 		// selector must not be null, else #TS(0)
 		if((SS_for_cpl_x & SELECTOR_RPL_MASK) == 0) {
 			PDEBUGF(LOG_V2, LOG_CPU, "call_gate: new SS null\n");
-			throw CPUException(CPU_TS_EXC, 0);
+			g_cpu.raise(CPU_TS_EXC, 0);
 		}
 
 		// selector index must be within its descriptor table limits,
@@ -87,14 +87,14 @@ void CPUExecutor::call_gate(Descriptor &gate_descriptor)
 		//   else #TS(SS selector)
 		if(ss_selector.rpl != cs_descriptor.dpl) {
 			PDEBUGF(LOG_V2, LOG_CPU, "call_gate: SS selector.rpl != CS descr.dpl\n");
-			throw CPUException(CPU_TS_EXC, SS_for_cpl_x & SELECTOR_RPL_MASK);
+			g_cpu.raise(CPU_TS_EXC, SS_for_cpl_x & SELECTOR_RPL_MASK);
 		}
 
 		// stack segment DPL must equal DPL of code segment,
 		//   else #TS(SS selector)
 		if(ss_descriptor.dpl != cs_descriptor.dpl) {
 			PDEBUGF(LOG_V2, LOG_CPU, "call_gate: SS descr.rpl != CS descr.dpl\n");
-			throw CPUException(CPU_TS_EXC, SS_for_cpl_x & SELECTOR_RPL_MASK);
+			g_cpu.raise(CPU_TS_EXC, SS_for_cpl_x & SELECTOR_RPL_MASK);
 		}
 
 		// descriptor must indicate writable data segment,
@@ -102,13 +102,13 @@ void CPUExecutor::call_gate(Descriptor &gate_descriptor)
 		if(!ss_descriptor.valid || !ss_descriptor.is_data_segment() || !ss_descriptor.is_writeable())
 		{
 			PDEBUGF(LOG_V2, LOG_CPU, "call_gate: ss descriptor is not writable data seg\n");
-			throw CPUException(CPU_TS_EXC, SS_for_cpl_x & SELECTOR_RPL_MASK);
+			g_cpu.raise(CPU_TS_EXC, SS_for_cpl_x & SELECTOR_RPL_MASK);
 		}
 
 		// segment must be present, else #SS(SS selector)
 		if(!ss_descriptor.present) {
 			PDEBUGF(LOG_V2, LOG_CPU, "call_gate: ss descriptor not present\n");
-			throw CPUException(CPU_SS_EXC, SS_for_cpl_x & SELECTOR_RPL_MASK);
+			g_cpu.raise(CPU_SS_EXC, SS_for_cpl_x & SELECTOR_RPL_MASK);
 		}
 
 		// get word count from call gate, mask to 5 bits
@@ -213,7 +213,7 @@ void CPUExecutor::call_gate(Descriptor &gate_descriptor)
 		// new EIP must be in code segment limit else #GP(0)
 		if(new_EIP > cs_descriptor.limit) {
 			PDEBUGF(LOG_V2, LOG_CPU, "new EIP not within CS limits\n");
-			throw CPUException(CPU_GP_EXC, 0);
+			g_cpu.raise(CPU_GP_EXC, 0);
 		}
 
 		/* load SS descriptor */
@@ -269,7 +269,7 @@ void CPUExecutor::branch_near(uint32_t new_EIP)
 	// check always, not only in protected mode
 	if(new_EIP > GET_LIMIT(CS)) {
 		PDEBUGF(LOG_V2,LOG_CPU,"branch_near: offset outside of CS limits\n");
-		throw CPUException(CPU_GP_EXC, 0);
+		g_cpu.raise(CPU_GP_EXC, 0);
 	}
 
 	SET_EIP(new_EIP);
@@ -281,7 +281,7 @@ void CPUExecutor::branch_far(Selector &selector, Descriptor &descriptor, uint32_
 	/* instruction pointer must be in code segment limit else #GP(0) */
 	if(eip > descriptor.limit) {
 		PERRF(LOG_CPU, "branch_far: EIP > descriptor limit\n");
-		throw CPUException(CPU_GP_EXC, 0);
+		g_cpu.raise(CPU_GP_EXC, 0);
 	}
 
 	/* Load CS:EIP from destination pointer */
@@ -295,7 +295,7 @@ void CPUExecutor::branch_far(uint16_t _sel, uint32_t _disp)
 	// CS LIMIT can't change when in real mode
 	if(_disp > GET_LIMIT(CS)) {
 		PDEBUGF(LOG_V2,LOG_CPU, "branch_far: offset outside of CS limits\n");
-		throw CPUException(CPU_GP_EXC, 0);
+		g_cpu.raise(CPU_GP_EXC, 0);
 	}
 
 	SET_CS(_sel);
@@ -313,7 +313,7 @@ void CPUExecutor::branch_far_pmode(uint16_t _cs, uint32_t _disp)
 	/* destination selector is not null else #GP(0) */
 	if((_cs & SELECTOR_RPL_MASK) == 0) {
 		PDEBUGF(LOG_V2, LOG_CPU,"branch_far_pmode: cs == 0\n");
-		throw CPUException(CPU_GP_EXC, 0);
+		g_cpu.raise(CPU_GP_EXC, 0);
 	}
 
 	selector = _cs;
@@ -332,13 +332,13 @@ void CPUExecutor::branch_far_pmode(uint16_t _cs, uint32_t _disp)
 		// call gate DPL must be >= CPL else #GP(gate selector)
 		if(descriptor.dpl < CPL) {
 			PDEBUGF(LOG_V2, LOG_CPU,"branch_far_pmode: call gate.dpl < CPL\n");
-			throw CPUException(CPU_GP_EXC, _cs & SELECTOR_RPL_MASK);
+			g_cpu.raise(CPU_GP_EXC, _cs & SELECTOR_RPL_MASK);
 		}
 
 		// call gate DPL must be >= gate selector RPL else #GP(gate selector)
 		if(descriptor.dpl < selector.rpl) {
 			PDEBUGF(LOG_V2, LOG_CPU,"branch_far_pmode: call gate.dpl < selector.rpl\n");
-			throw CPUException(CPU_GP_EXC, _cs & SELECTOR_RPL_MASK);
+			g_cpu.raise(CPU_GP_EXC, _cs & SELECTOR_RPL_MASK);
 		}
 
 		switch(descriptor.type) {
@@ -348,13 +348,13 @@ void CPUExecutor::branch_far_pmode(uint16_t _cs, uint32_t _disp)
 
 				if(!descriptor.valid || selector.ti) {
 					PDEBUGF(LOG_V2, LOG_CPU,"branch_far_pmode: jump to bad TSS selector\n");
-					throw CPUException(CPU_GP_EXC, _cs & SELECTOR_RPL_MASK);
+					g_cpu.raise(CPU_GP_EXC, _cs & SELECTOR_RPL_MASK);
 				}
 
 				// TSS must be present, else #NP(TSS selector)
 				if(!descriptor.present) {
 					PDEBUGF(LOG_V2, LOG_CPU,"branch_far_pmode: jump to not present TSS\n");
-					throw CPUException(CPU_NP_EXC, _cs & SELECTOR_RPL_MASK);
+					g_cpu.raise(CPU_NP_EXC, _cs & SELECTOR_RPL_MASK);
 				}
 
 				// SWITCH_TASKS _without_ nesting to TSS
@@ -372,7 +372,7 @@ void CPUExecutor::branch_far_pmode(uint16_t _cs, uint32_t _disp)
 
 			default:
 				PDEBUGF(LOG_V2, LOG_CPU,"branch_far_pmode: gate type %u unsupported\n", descriptor.type);
-				throw CPUException(CPU_GP_EXC, _cs & SELECTOR_RPL_MASK);
+				g_cpu.raise(CPU_GP_EXC, _cs & SELECTOR_RPL_MASK);
 		}
 	}
 }
@@ -402,7 +402,7 @@ void CPUExecutor::call_16(uint16_t _cs, uint16_t _ip)
 	// CS LIMIT can't change when in real mode
 	if(_ip > GET_LIMIT(CS)) {
 		PDEBUGF(LOG_V2, LOG_CPU, "CALL_cd: instruction pointer not within code segment limits\n");
-		throw CPUException(CPU_GP_EXC, 0);
+		g_cpu.raise(CPU_GP_EXC, 0);
 	}
 	stack_push_word(REG_CS.sel.value);
 	stack_push_word(REG_IP);
@@ -421,7 +421,7 @@ void CPUExecutor::call_32(uint16_t _cs, uint32_t _eip)
 	// CS LIMIT can't change when in real mode
 	if(_eip > GET_LIMIT(CS)) {
 		PDEBUGF(LOG_V2, LOG_CPU, "CALL_cd: instruction pointer not within code segment limits\n");
-		throw CPUException(CPU_GP_EXC, 0);
+		g_cpu.raise(CPU_GP_EXC, 0);
 	}
 	stack_push_dword(REG_CS.sel.value);
 	stack_push_dword(REG_EIP);
@@ -438,13 +438,14 @@ void CPUExecutor::call_pmode(uint16_t cs_raw, uint32_t disp)
 	/* new cs selector must not be null, else #GP(0) */
 	if((cs_raw & SELECTOR_RPL_MASK) == 0) {
 		PDEBUGF(LOG_V2, LOG_CPU,"call_pmode: CS selector null\n");
-		throw CPUException(CPU_GP_EXC, 0);
+		g_cpu.raise(CPU_GP_EXC, 0);
 	}
 	cs_selector = cs_raw;
 
 	// check new CS selector index within its descriptor limits,
 	// else #GP(new CS selector)
 	try {
+		CPUFaultScope fault_scope;
 		cs_descriptor = fetch_descriptor(cs_selector, CPU_GP_EXC);
 	} catch(CPUException &e) {
 		PDEBUGF(LOG_V2, LOG_CPU, "call_pmode: descriptor fetch error\n");
@@ -454,7 +455,7 @@ void CPUExecutor::call_pmode(uint16_t cs_raw, uint32_t disp)
 	// examine AR byte of selected descriptor for various legal values
 	if(!cs_descriptor.valid) {
 		PDEBUGF(LOG_V2, LOG_CPU,"call_pmode: invalid CS descriptor\n");
-		throw CPUException(CPU_GP_EXC, cs_raw & SELECTOR_RPL_MASK);
+		g_cpu.raise(CPU_GP_EXC, cs_raw & SELECTOR_RPL_MASK);
 	}
 
 	if(cs_descriptor.segment) {  // normal segment
@@ -495,13 +496,13 @@ void CPUExecutor::call_pmode(uint16_t cs_raw, uint32_t disp)
 		// descriptor DPL must be >= CPL else #GP(gate selector)
 		if(gate_descriptor.dpl < CPL) {
 			PDEBUGF(LOG_V2, LOG_CPU,"call_pmode: descriptor.dpl < CPL\n");
-			throw CPUException(CPU_GP_EXC, cs_raw & SELECTOR_RPL_MASK);
+			g_cpu.raise(CPU_GP_EXC, cs_raw & SELECTOR_RPL_MASK);
 		}
 
 		// descriptor DPL must be >= gate selector RPL else #GP(gate selector)
 		if(gate_descriptor.dpl < gate_selector.rpl) {
 			PDEBUGF(LOG_V2, LOG_CPU,"call_pmode: descriptor.dpl < selector.rpl\n");
-			throw CPUException(CPU_GP_EXC, cs_raw & SELECTOR_RPL_MASK);
+			g_cpu.raise(CPU_GP_EXC, cs_raw & SELECTOR_RPL_MASK);
 		}
 
 		switch(gate_descriptor.type) {
@@ -510,13 +511,13 @@ void CPUExecutor::call_pmode(uint16_t cs_raw, uint32_t disp)
 				PDEBUGF(LOG_V2, LOG_CPU, "call_pmode: available TSS\n");
 				if(!gate_descriptor.valid || gate_selector.ti) {
 					PDEBUGF(LOG_V2, LOG_CPU,"call_pmode: call bad TSS selector!\n");
-					throw CPUException(CPU_GP_EXC, cs_raw & SELECTOR_RPL_MASK);
+					g_cpu.raise(CPU_GP_EXC, cs_raw & SELECTOR_RPL_MASK);
 				}
 
 				// TSS must be present, else #NP(TSS selector)
 				if(!gate_descriptor.present) {
 					PDEBUGF(LOG_V2, LOG_CPU,"call_pmode: call not present TSS !\n");
-					throw CPUException(CPU_NP_EXC, cs_raw & SELECTOR_RPL_MASK);
+					g_cpu.raise(CPU_NP_EXC, cs_raw & SELECTOR_RPL_MASK);
 				}
 
 				// SWITCH_TASKS _without_ nesting to TSS
@@ -532,7 +533,7 @@ void CPUExecutor::call_pmode(uint16_t cs_raw, uint32_t disp)
 				// gate descriptor must be present else #NP(gate selector)
 				if(!gate_descriptor.present) {
 					PDEBUGF(LOG_V2, LOG_CPU,"call_pmode: gate not present\n");
-					throw CPUException(CPU_NP_EXC, cs_raw & SELECTOR_RPL_MASK);
+					g_cpu.raise(CPU_NP_EXC, cs_raw & SELECTOR_RPL_MASK);
 				}
 				call_gate(gate_descriptor);
 				return;
@@ -540,7 +541,7 @@ void CPUExecutor::call_pmode(uint16_t cs_raw, uint32_t disp)
 			default: // can't get here
 				PDEBUGF(LOG_V2, LOG_CPU,"call_pmode: gate.type(%u) unsupported\n",
 						(unsigned) gate_descriptor.type);
-				throw CPUException(CPU_GP_EXC, cs_raw & SELECTOR_RPL_MASK);
+				g_cpu.raise(CPU_GP_EXC, cs_raw & SELECTOR_RPL_MASK);
 		}
 	}
 }
@@ -553,7 +554,7 @@ void CPUExecutor::jump_call_gate(Selector &selector, Descriptor &gate_descriptor
 	// task gate must be present else #NP(gate selector)
 	if(!gate_descriptor.present) {
 		PERRF(LOG_CPU,"jump_call_gate: call gate not present!\n");
-		throw CPUException(CPU_NP_EXC, selector.value & SELECTOR_RPL_MASK);
+		g_cpu.raise(CPU_NP_EXC, selector.value & SELECTOR_RPL_MASK);
 	}
 
 	gate_cs_selector = gate_descriptor.selector;
@@ -562,7 +563,7 @@ void CPUExecutor::jump_call_gate(Selector &selector, Descriptor &gate_descriptor
 	// selector must not be null, else #GP(0)
 	if((gate_cs_selector.value & SELECTOR_RPL_MASK) == 0) {
 		PERRF(LOG_CPU,"jump_call_gate: CS selector null\n");
-		throw CPUException(CPU_GP_EXC, 0);
+		g_cpu.raise(CPU_GP_EXC, 0);
 	}
 
 	// selector must be within its descriptor table limits else #GP(CS selector)
@@ -599,7 +600,7 @@ void CPUExecutor::iret_pmode(bool _32bit)
 		// must specify global, else #TS(new TSS selector)
 		if(link_selector.ti) {
 			PDEBUGF(LOG_V2, LOG_CPU, "iret_pmode: link selector.ti=1\n");
-			throw CPUException(CPU_TS_EXC, link_selector.value & SELECTOR_RPL_MASK);
+			g_cpu.raise(CPU_TS_EXC, link_selector.value & SELECTOR_RPL_MASK);
 		}
 
 		// index must be within GDT limits, else #TS(new TSS selector)
@@ -607,7 +608,7 @@ void CPUExecutor::iret_pmode(bool _32bit)
 
 		if(!tss_descriptor.valid || tss_descriptor.segment) {
 			PDEBUGF(LOG_V2, LOG_CPU, "iret_pmode: TSS selector points to bad TSS\n");
-			throw CPUException(CPU_TS_EXC, link_selector.value & SELECTOR_RPL_MASK);
+			g_cpu.raise(CPU_TS_EXC, link_selector.value & SELECTOR_RPL_MASK);
 		}
 		// AR byte must specify TSS, else #TS(new TSS selector)
 		// new TSS must be busy, else #TS(new TSS selector)
@@ -615,13 +616,13 @@ void CPUExecutor::iret_pmode(bool _32bit)
 		   tss_descriptor.type != DESC_TYPE_BUSY_386_TSS)
 		{
 			PDEBUGF(LOG_V2, LOG_CPU, "iret_pmode: TSS selector points to bad TSS\n");
-			throw CPUException(CPU_TS_EXC, link_selector.value & SELECTOR_RPL_MASK);
+			g_cpu.raise(CPU_TS_EXC, link_selector.value & SELECTOR_RPL_MASK);
 		}
 
 		// TSS must be present, else #NP(new TSS selector)
 		if(!tss_descriptor.present) {
 			PDEBUGF(LOG_V2, LOG_CPU, "iret_pmode: task descriptor.p == 0\n");
-			throw CPUException(CPU_NP_EXC, link_selector.value & SELECTOR_RPL_MASK);
+			g_cpu.raise(CPU_NP_EXC, link_selector.value & SELECTOR_RPL_MASK);
 		}
 
 		// switch tasks (without nesting) to TSS specified by back link selector
@@ -671,7 +672,7 @@ void CPUExecutor::iret_pmode(bool _32bit)
 	// return CS selector must be non-null, else #GP(0)
 	if((cs_selector.value & SELECTOR_RPL_MASK) == 0) {
 		PDEBUGF(LOG_V2, LOG_CPU, "iret_pmode: return CS selector null\n");
-		throw CPUException(CPU_GP_EXC, 0);
+		g_cpu.raise(CPU_GP_EXC, 0);
 	}
 
 	// selector index must be within descriptor table limits,
@@ -681,7 +682,7 @@ void CPUExecutor::iret_pmode(bool _32bit)
 	// return CS selector RPL must be >= CPL, else #GP(return selector)
 	if(cs_selector.rpl < CPL) {
 		PDEBUGF(LOG_V2, LOG_CPU, "iret_pmode: return selector RPL < CPL\n");
-		throw CPUException(CPU_GP_EXC, cs_selector.value & SELECTOR_RPL_MASK);
+		g_cpu.raise(CPU_GP_EXC, cs_selector.value & SELECTOR_RPL_MASK);
 	}
 
 	// check code-segment descriptor
@@ -746,14 +747,14 @@ void CPUExecutor::iret_pmode(bool _32bit)
 		/* selector must be non-null, else #GP(0) */
 		if((ss_selector.value & SELECTOR_RPL_MASK) == 0) {
 			PDEBUGF(LOG_V2, LOG_CPU, "iret_pmode: SS selector null\n");
-			throw CPUException(CPU_GP_EXC, 0);
+			g_cpu.raise(CPU_GP_EXC, 0);
 		}
 
 		/* selector RPL must = RPL of return CS selector,
 		 * else #GP(SS selector) */
 		if(ss_selector.rpl != cs_selector.rpl) {
 			PDEBUGF(LOG_V2, LOG_CPU, "iret_pmode: SS.rpl != CS.rpl\n");
-			throw CPUException(CPU_GP_EXC, ss_selector.value & SELECTOR_RPL_MASK);
+			g_cpu.raise(CPU_GP_EXC, ss_selector.value & SELECTOR_RPL_MASK);
 		}
 
 		/* selector index must be within its descriptor table limits,
@@ -764,20 +765,20 @@ void CPUExecutor::iret_pmode(bool _32bit)
 		 * else #GP(SS selector) */
 		if(!ss_descriptor.valid || !ss_descriptor.is_data_segment() || !ss_descriptor.is_writeable()) {
 			PDEBUGF(LOG_V2, LOG_CPU, "iret_pmode: SS AR byte not writable or code segment\n");
-			throw CPUException(CPU_GP_EXC, ss_selector.value & SELECTOR_RPL_MASK);
+			g_cpu.raise(CPU_GP_EXC, ss_selector.value & SELECTOR_RPL_MASK);
 		}
 
 		/* stack segment DPL must equal the RPL of the return CS selector,
 		 * else #GP(SS selector) */
 		if(ss_descriptor.dpl != cs_selector.rpl) {
 			PDEBUGF(LOG_V2, LOG_CPU, "iret_pmode: SS.dpl != CS selector RPL\n");
-			throw CPUException(CPU_GP_EXC, ss_selector.value & SELECTOR_RPL_MASK);
+			g_cpu.raise(CPU_GP_EXC, ss_selector.value & SELECTOR_RPL_MASK);
 		}
 
 		/* SS must be present, else #NP(SS selector) */
 		if(!ss_descriptor.present) {
 			PDEBUGF(LOG_V2, LOG_CPU, "iret_pmode: SS not present!\n");
-			throw CPUException(CPU_NP_EXC, ss_selector.value & SELECTOR_RPL_MASK);
+			g_cpu.raise(CPU_NP_EXC, ss_selector.value & SELECTOR_RPL_MASK);
 		}
 
 		if(_32bit) {
@@ -832,7 +833,7 @@ void CPUExecutor::return_near(uint32_t _newEIP, uint16_t _pop_bytes)
 {
 	if(_newEIP > REG_CS.desc.limit) {
 		PDEBUGF(LOG_V2, LOG_CPU, "return_near: offset outside of CS limits\n");
-		throw CPUException(CPU_GP_EXC, 0);
+		g_cpu.raise(CPU_GP_EXC, 0);
 	}
 
 	SET_EIP(_newEIP);
@@ -852,7 +853,7 @@ void CPUExecutor::return_far_rmode(uint16_t _newCS, uint32_t _newEIP, uint16_t _
 	if(_newEIP > REG_CS.desc.limit) {
 		PDEBUGF(LOG_V2, LOG_CPU,
 				"return_far_real: instruction pointer not within code segment limits\n");
-		throw CPUException(CPU_GP_EXC, 0);
+		g_cpu.raise(CPU_GP_EXC, 0);
 	}
 
 	SET_CS(_newCS);
@@ -902,7 +903,7 @@ void CPUExecutor::return_far_pmode(uint16_t _pop_bytes, bool _32bit)
 	// selector must be non-null else #GP(0)
 	if((cs_selector.value & SELECTOR_RPL_MASK) == 0) {
 		PDEBUGF(LOG_V2, LOG_CPU, "return_far_pmode: CS selector null\n");
-		throw CPUException(CPU_GP_EXC, 0);
+		g_cpu.raise(CPU_GP_EXC, 0);
 	}
 
 	// selector index must be within its descriptor table limits,
@@ -912,7 +913,7 @@ void CPUExecutor::return_far_pmode(uint16_t _pop_bytes, bool _32bit)
 	// return selector RPL must be >= CPL, else #GP(return selector)
 	if(cs_selector.rpl < CPL) {
 		PDEBUGF(LOG_V2, LOG_CPU, "return_far_pmode: CS.rpl < CPL\n");
-		throw CPUException(CPU_GP_EXC, cs_selector.value & SELECTOR_RPL_MASK);
+		g_cpu.raise(CPU_GP_EXC, cs_selector.value & SELECTOR_RPL_MASK);
 	}
 
 	// descriptor AR byte must indicate code segment, else #GP(selector)
@@ -952,7 +953,7 @@ void CPUExecutor::return_far_pmode(uint16_t _pop_bytes, bool _32bit)
 
 		if((ss_selector.value & SELECTOR_RPL_MASK) == 0) {
 			PDEBUGF(LOG_V2, LOG_CPU, "return_far_pmode: SS selector null\n");
-			throw CPUException(CPU_GP_EXC, 0);
+			g_cpu.raise(CPU_GP_EXC, 0);
 		}
 
 		// selector index must be within its descriptor table limits,
@@ -963,27 +964,27 @@ void CPUExecutor::return_far_pmode(uint16_t _pop_bytes, bool _32bit)
 		// else #GP(selector)
 		if(ss_selector.rpl != cs_selector.rpl) {
 			PDEBUGF(LOG_V2, LOG_CPU, "return_far_pmode: ss.rpl != cs.rpl\n");
-			throw CPUException(CPU_GP_EXC, ss_selector.value & SELECTOR_RPL_MASK);
+			g_cpu.raise(CPU_GP_EXC, ss_selector.value & SELECTOR_RPL_MASK);
 		}
 
 		// descriptor AR byte must indicate a writable data segment,
 		// else #GP(selector)
 		if(!ss_descriptor.valid || !ss_descriptor.is_data_segment() || !ss_descriptor.is_writeable()) {
 			PDEBUGF(LOG_V2, LOG_CPU, "return_far_pmode: SS.AR byte not writable data\n");
-			throw CPUException(CPU_GP_EXC, ss_selector.value & SELECTOR_RPL_MASK);
+			g_cpu.raise(CPU_GP_EXC, ss_selector.value & SELECTOR_RPL_MASK);
 		}
 
 		// descriptor dpl must == RPL of the return CS selector,
 		// else #GP(selector)
 		if(ss_descriptor.dpl != cs_selector.rpl) {
 			PDEBUGF(LOG_V2, LOG_CPU, "return_far_pmode: SS.dpl != cs.rpl\n");
-			throw CPUException(CPU_GP_EXC, ss_selector.value & SELECTOR_RPL_MASK);
+			g_cpu.raise(CPU_GP_EXC, ss_selector.value & SELECTOR_RPL_MASK);
 		}
 
 		// segment must be present else #SS(selector)
 		if(!ss_descriptor.present) {
 			PDEBUGF(LOG_V2, LOG_CPU, "return_pmode: ss.present == 0\n");
-			throw CPUException(CPU_SS_EXC, ss_selector.value & SELECTOR_RPL_MASK);
+			g_cpu.raise(CPU_SS_EXC, ss_selector.value & SELECTOR_RPL_MASK);
 		}
 
 		branch_far(cs_selector, cs_descriptor, return_EIP, cs_selector.rpl);
@@ -52,7 +52,7 @@ void CPUExecutor::write_flags(uint16_t _flags)
 	} else if(IS_V8086()) {
 		if(FLAG_IOPL < 3) {
 			PDEBUGF(LOG_CPU, LOG_V2, "write_flags: general protection in v8086 mode\n");
-			throw CPUException(CPU_GP_EXC, 0);
+			g_cpu.raise(CPU_GP_EXC, 0);
 		}
 		write_flags(_flags,
 			false, // IOPL CPL is always 3 in V86 mode
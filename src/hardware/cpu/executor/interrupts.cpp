@@ -49,7 +49,7 @@ void CPUExecutor::interrupt(uint8_t _vector)
 		 * (cfr. 5-7)
 		 */
 		PERRF(LOG_CPU, "real mode interrupt vector > IDT limit\n");
-		throw CPUException(CPU_IDT_LIMIT_EXC, 0);
+		g_cpu.raise(CPU_IDT_LIMIT_EXC, 0);
 	}
 	stack_push_word(GET_FLAGS());
 	stack_push_word(REG_CS.sel.value);
@@ -136,13 +136,13 @@ void CPUExecutor::interrupt_inner_privilege(Descriptor &gate_descriptor,
 	if(IS_V8086() && cs_descriptor.dpl != 0) {
 		// if code segment DPL != 0 then #GP(new code segment selector)
 		PDEBUGF(LOG_V2, LOG_CPU, "interrupt_inner_privilege(): code segment DPL(%d) != 0 in v8086 mode\n", cs_descriptor.dpl);
-		throw CPUException(CPU_GP_EXC, cs_selector.value & SELECTOR_RPL_MASK);
+		g_cpu.raise(CPU_GP_EXC, cs_selector.value & SELECTOR_RPL_MASK);
 	}
 
 	// Selector must be non-null else #TS(EXT)
 	if((SS_for_cpl_x & SELECTOR_RPL_MASK) == 0) {
 		PDEBUGF(LOG_V1,LOG_CPU, "interrupt_inner_privilege(): SS selector null\n");
-		throw CPUException(CPU_TS_EXC, 0); /* TS(ext) */
+		g_cpu.raise(CPU_TS_EXC, 0); /* TS(ext) */
 	}
 
 	// selector index must be within its descriptor table limits
@@ -151,6 +151,7 @@ void CPUExecutor::interrupt_inner_privilege(Descriptor &gate_descriptor,
 
 	// fetch 2 dwords of descriptor; call handles out of limits checks
 	try {
+		CPUFaultScope fault_scope;
 		ss_descriptor = fetch_descriptor(ss_selector, CPU_TS_EXC);
 	} catch(CPUException &e) {
 		PDEBUGF(LOG_V1,LOG_CPU, "interrupt_inner_privilege(): bad ss_selector fetch\n");
@@ -161,14 +162,14 @@ void CPUExecutor::interrupt_inner_privilege(Descriptor &gate_descriptor,
 	// else #TS(SS selector + ext)
 	if(ss_selector.rpl != cs_descriptor.dpl) {
 		PDEBUGF(LOG_V1,LOG_CPU, "interrupt_inner_privilege(): SS.rpl != CS.dpl\n");
-		throw CPUException(CPU_TS_EXC, SS_for_cpl_x & SELECTOR_RPL_MASK);
+		g_cpu.raise(CPU_TS_EXC, SS_for_cpl_x & SELECTOR_RPL_MASK);
 	}
 
 	// stack seg DPL must = DPL of code segment,
 	// else #TS(SS selector + ext)
 	if(ss_descriptor.dpl != cs_descriptor.dpl) {
 		PDEBUGF(LOG_V1,LOG_CPU, "interrupt_inner_privilege(): SS.dpl != CS.dpl\n");
-		throw CPUException(CPU_TS_EXC, SS_for_cpl_x & SELECTOR_RPL_MASK);
+		g_cpu.raise(CPU_TS_EXC, SS_for_cpl_x & SELECTOR_RPL_MASK);
 	}
 
 	// descriptor must indicate writable data segment,
@@ -176,19 +177,19 @@ void CPUExecutor::interrupt_inner_privilege(Descriptor &gate_descriptor,
 	if(!ss_descriptor.valid || !ss_descriptor.is_data_segment() || !ss_descriptor.is_writeable())
 	{
 		PDEBUGF(LOG_V1,LOG_CPU,"interrupt_inner_privilege(): SS is not writable data segment\n");
-		throw CPUException(CPU_TS_EXC, SS_for_cpl_x & SELECTOR_RPL_MASK);
+		g_cpu.raise(CPU_TS_EXC, SS_for_cpl_x & SELECTOR_RPL_MASK);
 	}
 
 	// seg must be present, else #SS(SS selector + ext)
 	if(!ss_descriptor.present) {
 		PDEBUGF(LOG_V1,LOG_CPU, "interrupt_inner_privilege(): SS not present\n");
-		throw CPUException(CPU_SS_EXC, SS_for_cpl_x & SELECTOR_RPL_MASK);
+		g_cpu.raise(CPU_SS_EXC, SS_for_cpl_x & SELECTOR_RPL_MASK);
 	}
 
 	// IP must be within CS segment boundaries, else #GP(0)
 	if(gate_descriptor.offset > cs_descriptor.limit) {
 		PDEBUGF(LOG_V1,LOG_CPU,"interrupt_inner_privilege(): gate EIP > CS.limit\n");
-		throw CPUException(CPU_GP_EXC, 0);
+		g_cpu.raise(CPU_GP_EXC, 0);
 	}
 
 	// Prepare new stack segment
@@ -243,13 +244,13 @@ void CPUExecutor::interrupt_same_privilege(Descriptor &gate_descriptor,
 	if(IS_V8086() && (cs_descriptor.is_conforming() || cs_descriptor.dpl != 0)) {
 		// if code segment DPL != 0 then #GP(new code segment selector)
 		PDEBUGF(LOG_V2, LOG_CPU, "interrupt_same_privilege(): code segment conforming or DPL(%d) != 0 in v8086 mode\n", cs_descriptor.dpl);
-		throw CPUException(CPU_GP_EXC, cs_selector.value & SELECTOR_RPL_MASK);
+		g_cpu.raise(CPU_GP_EXC, cs_selector.value & SELECTOR_RPL_MASK);
 	}
 
 	// EIP must be in CS limit else #GP(0)
 	if(gate_descriptor.offset > cs_descriptor.limit) {
 		PDEBUGF(LOG_V1,LOG_CPU,"interrupt_same_privilege(): IP > CS descriptor limit\n");
-		throw CPUException(CPU_GP_EXC, 0);
+		g_cpu.raise(CPU_GP_EXC, 0);
 	}
 
 	// push flags onto stack
@@ -296,16 +297,16 @@ void CPUExecutor::interrupt_pmode(uint8_t vector, bool soft_int,
 		PDEBUGF(LOG_V2,LOG_CPU,
 			"interrupt_pmode(): vector must be within IDT table limits, IDT.limit = 0x%x\n",
 			GET_LIMIT(IDTR));
-		throw CPUException(CPU_GP_EXC, vector*8 + 2);
+		g_cpu.raise(CPU_GP_EXC, vector*8 + 2);
 	}
 
-	gate_descriptor = read_qword(GET_BASE(IDTR) + vector*8);
+	gate_descriptor = read_descriptor(GET_BASE(IDTR) + vector*8);
 
 	if(!gate_descriptor.valid || gate_descriptor.segment) {
 		PDEBUGF(LOG_V2,LOG_CPU,
 				"interrupt_pmode(): gate descriptor is not valid sys seg (vector=0x%02x)\n",
 				vector);
-		throw CPUException(CPU_GP_EXC, vector*8 + 2);
+		g_cpu.raise(CPU_GP_EXC, vector*8 + 2);
 	}
 
 	// descriptor AR byte must indicate interrupt gate, trap gate,
@@ -320,20 +321,20 @@ void CPUExecutor::interrupt_pmode(uint8_t vector, bool soft_int,
 		default:
 			PDEBUGF(LOG_V1,LOG_CPU, "interrupt_pmode(): gate.type(%u) != {5,6,7,14,15}\n",
 					(unsigned) gate_descriptor.type);
-			throw CPUException(CPU_GP_EXC, vector*8 + 2);
+			g_cpu.raise(CPU_GP_EXC, vector*8 + 2);
 	}
 
 	// if software interrupt, then gate descripor DPL must be >= CPL,
 	// else #GP(vector * 8 + 2 + EXT)
 	if(soft_int && gate_descriptor.dpl < CPL) {
 		PDEBUGF(LOG_V2,LOG_CPU, "interrupt_pmode(): soft_int && (gate.dpl < CPL)\n");
-		throw CPUException(CPU_GP_EXC, vector*8 + 2);
+		g_cpu.raise(CPU_GP_EXC, vector*8 + 2);
 	}
 
 	// Gate must be present, else #NP(vector * 8 + 2 + EXT)
 	if(!gate_descriptor.present) {
 		PDEBUGF(LOG_V2,LOG_CPU, "interrupt_pmode(): gate not present\n");
-		throw CPUException(CPU_NP_EXC, vector*8 + 2);
+		g_cpu.raise(CPU_NP_EXC, vector*8 + 2);
 	}
 
 	switch(gate_descriptor.type) {
@@ -350,11 +351,12 @@ void CPUExecutor::interrupt_pmode(uint8_t vector, bool soft_int,
 			if(tss_selector.ti) {
 				PDEBUGF(LOG_V2,LOG_CPU,
 					"interrupt_pmode(): tss_selector.ti=1 from gate descriptor - #GP(tss_selector)\n");
-				throw CPUException(CPU_GP_EXC, tss_selector.value & SELECTOR_RPL_MASK);
+				g_cpu.raise(CPU_GP_EXC, tss_selector.value & SELECTOR_RPL_MASK);
 			}
 
 			// index must be within GDT limits, else #TS(TSS selector)
 			try {
+				CPUFaultScope fault_scope;
 				tss_descriptor = fetch_descriptor(tss_selector, CPU_GP_EXC);
 			} catch(CPUException &e) {
 				PDEBUGF(LOG_V1,LOG_CPU, "interrupt_pmode(): bad TSS selector fetch\n");
@@ -366,7 +368,7 @@ void CPUExecutor::interrupt_pmode(uint8_t vector, bool soft_int,
 			if(!tss_descriptor.valid || tss_descriptor.segment) {
 				PDEBUGF(LOG_V2,LOG_CPU,
 					"interrupt_pmode(): TSS selector points to invalid or bad TSS - #GP(tss_selector)\n");
-				throw CPUException(CPU_GP_EXC, tss_selector.value & SELECTOR_RPL_MASK);
+				g_cpu.raise(CPU_GP_EXC, tss_selector.value & SELECTOR_RPL_MASK);
 			}
 
 			if(tss_descriptor.type != DESC_TYPE_AVAIL_286_TSS &&
@@ -374,13 +376,13 @@ void CPUExecutor::interrupt_pmode(uint8_t vector, bool soft_int,
 			{
 				PDEBUGF(LOG_V2,LOG_CPU,
 					"interrupt_pmode(): TSS selector points to bad TSS - #GP(tss_selector)\n");
-				throw CPUException(CPU_GP_EXC, tss_selector.value & SELECTOR_RPL_MASK);
+				g_cpu.raise(CPU_GP_EXC, tss_selector.value & SELECTOR_RPL_MASK);
 			}
 
 			// TSS must be present, else #NP(TSS selector)
 			if(!tss_descriptor.present) {
 				PDEBUGF(LOG_V2,LOG_CPU, "interrupt_pmode(): TSS descriptor not present\n");
-				throw CPUException(CPU_NP_EXC, tss_selector.value & SELECTOR_RPL_MASK);
+				g_cpu.raise(CPU_NP_EXC, tss_selector.value & SELECTOR_RPL_MASK);
 			}
 
 			// switch tasks with nesting to TSS
@@ -403,13 +405,14 @@ void CPUExecutor::interrupt_pmode(uint8_t vector, bool soft_int,
 			// selector must be non-null else #GP(EXT)
 			if((gate_descriptor.selector & SELECTOR_RPL_MASK) == 0) {
 				PDEBUGF(LOG_V2,LOG_CPU,"interrupt_pmode(): null selector\n");
-				throw CPUException(CPU_GP_EXC, 0);
+				g_cpu.raise(CPU_GP_EXC, 0);
 			}
 			cs_selector = gate_descriptor.selector;
 
 			// selector must be within its descriptor table limits
 			// else #GP(selector+EXT)
 			try {
+				CPUFaultScope fault_scope;
 				cs_descriptor = fetch_descriptor(cs_selector, CPU_GP_EXC);
 			} catch(CPUException &e) {
 				PDEBUGF(LOG_V1,LOG_CPU, "interrupt_pmode(): bad CS selector fetch\n");
@@ -421,13 +424,13 @@ void CPUExecutor::interrupt_pmode(uint8_t vector, bool soft_int,
 			if(!cs_descriptor.valid || !cs_descriptor.is_code_segment() || cs_descriptor.dpl > CPL) {
 				PDEBUGF(LOG_V2,LOG_CPU, "interrupt_pmode(): not accessible or not code segment cs=0x%04x\n",
 						cs_selector.value);
-				throw CPUException(CPU_GP_EXC, cs_selector.value & SELECTOR_RPL_MASK);
+				g_cpu.raise(CPU_GP_EXC, cs_selector.value & SELECTOR_RPL_MASK);
 			}
 
 			// segment must be present, else #NP(selector + EXT)
 			if(!cs_descriptor.present) {
 				PDEBUGF(LOG_V2,LOG_CPU,"interrupt_pmode(): segment not present\n");
-				throw CPUException(CPU_NP_EXC, cs_selector.value & SELECTOR_RPL_MASK);
+				g_cpu.raise(CPU_NP_EXC, cs_selector.value & SELECTOR_RPL_MASK);
 			}
 
 			// if code segment is non-conforming and DPL < CPL then int to inner priv
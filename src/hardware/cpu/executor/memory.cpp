@@ -20,25 +20,41 @@
 #include "ibmulator.h"
 #include "hardware/cpu/executor.h"
 #include "hardware/cpu/mmu.h"
+#include "hardware/cpu/idle.h"
 
 void CPUExecutor::mmu_lookup(uint32_t _linear, unsigned _len, bool _user, bool _write)
 {
-	if(IS_PAGING()) {
-		if(LIKELY((PAGE_OFFSET(_linear) + _len) <= 4096)) {
-			m_cached_phy.lin1 = _linear;
-			m_cached_phy.phy1 = g_cpummu.TLB_lookup(m_cached_phy.lin1, _len, _user, _write);
-			m_cached_phy.len1 = _len;
-			m_cached_phy.pages = 1;
+	if(LIKELY((PAGE_OFFSET(_linear) + _len) <= 4096)) {
+		m_cached_phy.lin1 = _linear;
+		m_cached_phy.len1 = _len;
+		m_cached_phy.pages = 1;
+		if(USE_HOST_TLB) {
+			m_cached_phy.host1 = g_cpummu.host_TLB_lookup(_linear, _len, _user, _write, m_cached_phy.phy1);
+			if(m_cached_phy.host1) {
+				return;
+			}
+		}
+		if(IS_PAGING()) {
+			m_cached_phy.phy1 = g_cpummu.TLB_lookup(_linear, _len, _user, _write);
 		} else {
-			uint32_t page_offset = PAGE_OFFSET(_linear);
-			m_cached_phy.len1 = 4096 - page_offset;
-			m_cached_phy.len2 = _len - m_cached_phy.len1;
-			m_cached_phy.lin1 = _linear;
-			m_cached_phy.phy1 = g_cpummu.TLB_lookup(m_cached_phy.lin1, m_cached_phy.len1, _user, _write);
-			m_cached_phy.lin2 = _linear + m_cached_phy.len1;
-			m_cached_phy.phy2 = g_cpummu.TLB_lookup(m_cached_phy.lin2, m_cached_phy.len2, _user, _write);
-			m_cached_phy.pages = 2;
+			m_cached_phy.phy1 = _linear;
+		}
+		if(USE_HOST_TLB) {
+			// the next accesses to this page will use the host TLB
+			g_cpummu.host_TLB_fill(_linear, m_cached_phy.phy1);
 		}
+		return;
+	}
+	m_cached_phy.host1 = nullptr;
+	if(IS_PAGING()) {
+		uint32_t page_offset = PAGE_OFFSET(_linear);
+		m_cached_phy.len1 = 4096 - page_offset;
+		m_cached_phy.len2 = _len - m_cached_phy.len1;
+		m_cached_phy.lin1 = _linear;
+		m_cached_phy.phy1 = g_cpummu.TLB_lookup(m_cached_phy.lin1, m_cached_phy.len1, _user, _write);
+		m_cached_phy.lin2 = _linear + m_cached_phy.len1;
+		m_cached_phy.phy2 = g_cpummu.TLB_lookup(m_cached_phy.lin2, m_cached_phy.len2, _user, _write);
+		m_cached_phy.pages = 2;
 	} else {
 		m_cached_phy.lin1 = _linear;
 		m_cached_phy.phy1 = _linear;
@@ -57,7 +73,7 @@ uint8_t CPUExecutor::read_byte()
 	if(UNLIKELY(DR7_ENABLED_ANY)) {
 		g_cpucore.match_x86_data_breakpoint(m_cached_phy.lin1, 1, 0x3);
 	}
-	return g_cpubus.mem_read<1>(m_cached_phy.phy1);
+	return g_cpubus.mem_read<1>(m_cached_phy.phy1, m_cached_phy.host1);
 }
 
 uint16_t CPUExecutor::read_word()
@@ -66,7 +82,10 @@ uint16_t CPUExecutor::read_word()
 		if(UNLIKELY(DR7_ENABLED_ANY)) {
 			g_cpucore.match_x86_data_breakpoint(m_cached_phy.lin1, 2, 0x3);
 		}
-		return g_cpubus.mem_read<2>(m_cached_phy.phy1);
+		if(USE_IDLE_SKIP && UNLIKELY(m_cached_phy.phy1 - IDLE_BDA_KBPTR < 4)) {
+			g_cpuidle.BDA_read();
+		}
+		return g_cpubus.mem_read<2>(m_cached_phy.phy1, m_cached_phy.host1);
 	} else {
 		uint16_t value = g_cpubus.mem_read<1>(m_cached_phy.phy1) |
 		                 g_cpubus.mem_read<1>(m_cached_phy.phy2) << 8;
@@ -87,7 +106,10 @@ uint32_t CPUExecutor::read_dword()
 		if(UNLIKELY(DR7_ENABLED_ANY)) {
 			g_cpucore.match_x86_data_breakpoint(m_cached_phy.lin1, 4, 0x3);
 		}
-		return g_cpubus.mem_read<4>(m_cached_phy.phy1);
+		if(USE_IDLE_SKIP && UNLIKELY(m_cached_phy.phy1 - IDLE_BDA_KBPTR < 4)) {
+			g_cpuidle.BDA_read();
+		}
+		return g_cpubus.mem_read<4>(m_cached_phy.phy1, m_cached_phy.host1);
 	} else {
 		uint32_t value;
 		if(m_cached_phy.len1 == 1) {
@@ -187,7 +209,7 @@ void CPUExecutor::write_byte(uint8_t _data)
 	if(UNLIKELY(DR7_ENABLED_ANY)) {
 		g_cpucore.match_x86_data_breakpoint(m_cached_phy.lin1, 1, 0x1);
 	}
-	g_cpubus.mem_write<1>(m_cached_phy.phy1, _data);
+	g_cpubus.mem_write<1>(m_cached_phy.phy1, _data, m_cached_phy.host1);
 }
 
 void CPUExecutor::write_word(uint16_t _data)
@@ -196,7 +218,7 @@ void CPUExecutor::write_word(uint16_t _data)
 		if(UNLIKELY(DR7_ENABLED_ANY)) {
 			g_cpucore.match_x86_data_breakpoint(m_cached_phy.lin1, 2, 0x1);
 		}
-		g_cpubus.mem_write<2>(m_cached_phy.phy1, _data);
+		g_cpubus.mem_write<2>(m_cached_phy.phy1, _data, m_cached_phy.host1);
 	} else {
 		g_cpubus.mem_write<1>(m_cached_phy.phy1, _data);
 		g_cpubus.mem_write<1>(m_cached_phy.phy2, _data>>8);
@@ -216,7 +238,7 @@ void CPUExecutor::write_dword(uint32_t _data)
 		if(UNLIKELY(DR7_ENABLED_ANY)) {
 			g_cpucore.match_x86_data_breakpoint(m_cached_phy.lin1, 4, 0x1);
 		}
-		g_cpubus.mem_write<4>(m_cached_phy.phy1, _data);
+		g_cpubus.mem_write<4>(m_cached_phy.phy1, _data, m_cached_phy.host1);
 	} else {
 
 		if(m_cached_phy.len1 == 1) {
@@ -21,6 +21,7 @@
 #include "machine.h"
 #include "hardware/cpu/executor.h"
 #include "hardware/cpu/debugger.h"
+#include "hardware/cpu/idle.h"
 #include <cmath>
 
 /* the parity flag (PF) indicates whether the modulo 2 sum of the low-order
@@ -75,7 +76,7 @@ void CPUExecutor::check_CPL_privilege(bool _mode_cond, const char *_opstr)
 {
 	if(_mode_cond && CPL != 0) {
 		PDEBUGF(LOG_V2, LOG_CPU, "%s: privilege check failed\n", _opstr);
-		throw CPUException(CPU_GP_EXC, 0);
+		g_cpu.raise(CPU_GP_EXC, 0);
 	}
 }
 
@@ -177,7 +178,7 @@ void CPUExecutor::AAM()
 	// See http://www.rcollins.org/secrets/opcodes/AAM.html and current IA-32
 	// manual.
 	if(m_instr->ib == 0) {
-		throw CPUException(CPU_DIV_ER_EXC, 0);
+		g_cpu.raise(CPU_DIV_ER_EXC, 0);
 	}
 	uint8_t al = REG_AL;
 	REG_AH = al / m_instr->ib;
@@ -258,12 +259,7 @@ uint8_t CPUExecutor::ADC_b(uint8_t op1, uint8_t op2)
 	uint8_t cf = FLAG_CF;
 	uint8_t res = op1 + op2 + cf;
 
-	SET_FLAG(OF, ((op1 ^ op2 ^ 0x80) & (res ^ op2)) & 0x80);
-	SET_FLAG(SF, res & 0x80);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(AF, ((op1 ^ op2) ^ res) & 0x10);
-	SET_FLAG(PF, PARITY(res));
-	SET_FLAG(CF, (res < op1) || (cf && (res == op1)));
+	SET_LAZY_FLAGS(ADD, op1, op2, res, 0x80);
 
 	return res;
 }
@@ -273,12 +269,7 @@ uint16_t CPUExecutor::ADC_w(uint16_t op1, uint16_t op2)
 	uint16_t cf = FLAG_CF;
 	uint16_t res = op1 + op2 + cf;
 
-	SET_FLAG(OF, ((op1 ^ op2 ^ 0x8000) & (res ^ op2)) & 0x8000);
-	SET_FLAG(SF, res & 0x8000);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(AF, ((op1 ^ op2) ^ res) & 0x10);
-	SET_FLAG(PF, PARITY(res));
-	SET_FLAG(CF, (res < op1) || (cf && (res == op1)));
+	SET_LAZY_FLAGS(ADD, op1, op2, res, 0x8000);
 
 	return res;
 }
@@ -288,12 +279,7 @@ uint32_t CPUExecutor::ADC_d(uint32_t op1, uint32_t op2)
 	uint32_t cf = FLAG_CF;
 	uint32_t res = op1 + op2 + cf;
 
-	SET_FLAG(OF, ((op1 ^ op2 ^ 0x80000000) & (res ^ op2)) & 0x80000000);
-	SET_FLAG(SF, res & 0x80000000);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(AF, ((op1 ^ op2) ^ res) & 0x10);
-	SET_FLAG(PF, PARITY(res));
-	SET_FLAG(CF, (res < op1) || (cf && (res == op1)));
+	SET_LAZY_FLAGS(ADD, op1, op2, res, 0x80000000);
 
 	return res;
 }
@@ -317,12 +303,7 @@ uint8_t CPUExecutor::ADD_b(uint8_t op1, uint8_t op2)
 {
 	uint8_t res = op1 + op2;
 
-	SET_FLAG(OF, ((op1 ^ op2 ^ 0x80) & (res ^ op2)) & 0x80);
-	SET_FLAG(SF, res & 0x80);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(AF, ((op1 ^ op2) ^ res) & 0x10);
-	SET_FLAG(PF, PARITY(res));
-	SET_FLAG(CF, res < op1);
+	SET_LAZY_FLAGS(ADD, op1, op2, res, 0x80);
 
 	return res;
 }
@@ -331,12 +312,7 @@ uint16_t CPUExecutor::ADD_w(uint16_t op1, uint16_t op2)
 {
 	uint16_t res = op1 + op2;
 
-	SET_FLAG(OF, ((op1 ^ op2 ^ 0x8000) & (res ^ op2)) & 0x8000);
-	SET_FLAG(SF, res & 0x8000);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(AF, ((op1 ^ op2) ^ res) & 0x10);
-	SET_FLAG(PF, PARITY(res));
-	SET_FLAG(CF, res < op1);
+	SET_LAZY_FLAGS(ADD, op1, op2, res, 0x8000);
 
 	return res;
 }
@@ -345,12 +321,7 @@ uint32_t CPUExecutor::ADD_d(uint32_t op1, uint32_t op2)
 {
 	uint32_t res = op1 + op2;
 
-	SET_FLAG(OF, ((op1 ^ op2 ^ 0x80000000) & (res ^ op2)) & 0x80000000);
-	SET_FLAG(SF, res & 0x80000000);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(AF, ((op1 ^ op2) ^ res) & 0x10);
-	SET_FLAG(PF, PARITY(res));
-	SET_FLAG(CF, res < op1);
+	SET_LAZY_FLAGS(ADD, op1, op2, res, 0x80000000);
 
 	return res;
 }
@@ -379,12 +350,7 @@ uint8_t CPUExecutor::AND_b(uint8_t op1, uint8_t op2)
 {
 	uint8_t res = op1 & op2;
 
-	SET_FLAG(OF, false);
-	SET_FLAG(SF, res & 0x80);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(PF, PARITY(res));
-	SET_FLAG(CF, false);
-	SET_FLAG(AF, false); // unknown
+	SET_LAZY_FLAGS(LOGIC, op1, op2, res, 0x80);
 
 	return res;
 }
@@ -393,12 +359,7 @@ uint16_t CPUExecutor::AND_w(uint16_t op1, uint16_t op2)
 {
 	uint16_t res = op1 & op2;
 
-	SET_FLAG(OF, false);
-	SET_FLAG(SF, res & 0x8000);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(PF, PARITY(res));
-	SET_FLAG(CF, false);
-	SET_FLAG(AF, false); // unknown
+	SET_LAZY_FLAGS(LOGIC, op1, op2, res, 0x8000);
 
 	return res;
 }
@@ -407,12 +368,7 @@ uint32_t CPUExecutor::AND_d(uint32_t op1, uint32_t op2)
 {
 	uint32_t res = op1 & op2;
 
-	SET_FLAG(OF, false);
-	SET_FLAG(SF, res & 0x80000000);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(PF, PARITY(res));
-	SET_FLAG(CF, false);
-	SET_FLAG(AF, false); // unknown
+	SET_LAZY_FLAGS(LOGIC, op1, op2, res, 0x80000000);
 
 	return res;
 }
@@ -441,7 +397,7 @@ void CPUExecutor::ARPL_ew_rw()
 {
 	if(!IS_PMODE()) {
 		PDEBUGF(LOG_V2, LOG_CPU, "ARPL: not recognized in real or v8086 mode\n");
-		throw CPUException(CPU_UD_EXC, 0);
+		g_cpu.raise(CPU_UD_EXC, 0);
 	}
 
 	uint16_t op1 = load_ew();
@@ -469,7 +425,7 @@ void CPUExecutor::BOUND_rw_md()
 
 	if(op1 < int16_t(bound_min) || op1 > int16_t(bound_max)) {
 		PDEBUGF(LOG_V2,LOG_CPU, "BOUND: fails bounds test\n");
-		throw CPUException(CPU_BOUND_EXC, 0);
+		g_cpu.raise(CPU_BOUND_EXC, 0);
 	}
 }
 
@@ -481,7 +437,7 @@ void CPUExecutor::BOUND_rd_mq()
 
 	if(op1 < int32_t(bound_min) || op1 > int32_t(bound_max)) {
 		PDEBUGF(LOG_V2,LOG_CPU, "BOUND: fails bounds test\n");
-		throw CPUException(CPU_BOUND_EXC, 0);
+		g_cpu.raise(CPU_BOUND_EXC, 0);
 	}
 }
 
@@ -919,10 +875,10 @@ void CPUExecutor::CLI()
 {
 	if(IS_PMODE() && (FLAG_IOPL < CPL)) {
 		PDEBUGF(LOG_V2, LOG_CPU, "CLI: IOPL < CPL in protected mode\n");
-		throw CPUException(CPU_GP_EXC, 0);
+		g_cpu.raise(CPU_GP_EXC, 0);
 	} else if(IS_V8086() && (FLAG_IOPL != 3)) {
 		PDEBUGF(LOG_V2, LOG_CPU, "CLI: IOPL != 3 in V8086 mode\n");
-		throw CPUException(CPU_GP_EXC, 0);
+		g_cpu.raise(CPU_GP_EXC, 0);
 	}
 
 	SET_FLAG(IF, false);
@@ -953,36 +909,21 @@ void CPUExecutor::CMP_b(uint8_t op1, uint8_t op2)
 {
 	uint8_t res = op1 - op2;
 
-	SET_FLAG(OF, ((op1 ^ op2) & (op1 ^ res)) & 0x80);
-	SET_FLAG(SF, res & 0x80);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(AF, ((op1 ^ op2) ^ res) & 0x10);
-	SET_FLAG(PF, PARITY(res));
-	SET_FLAG(CF, op1<op2);
+	SET_LAZY_FLAGS(SUB, op1, op2, res, 0x80);
 }
 
 void CPUExecutor::CMP_w(uint16_t op1, uint16_t op2)
 {
 	uint16_t res = op1 - op2;
 
-	SET_FLAG(OF, ((op1 ^ op2) & (op1 ^ res)) & 0x8000);
-	SET_FLAG(SF, res & 0x8000);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(AF, ((op1 ^ op2) ^ res) & 0x10);
-	SET_FLAG(PF, PARITY(res));
-	SET_FLAG(CF, op1<op2);
+	SET_LAZY_FLAGS(SUB, op1, op2, res, 0x8000);
 }
 
 void CPUExecutor::CMP_d(uint32_t op1, uint32_t op2)
 {
 	uint32_t res = op1 - op2;
 
-	SET_FLAG(OF, ((op1 ^ op2) & (op1 ^ res)) & 0x80000000);
-	SET_FLAG(SF, res & 0x80000000);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(AF, ((op1 ^ op2) ^ res) & 0x10);
-	SET_FLAG(PF, PARITY(res));
-	SET_FLAG(CF, op1<op2);
+	SET_LAZY_FLAGS(SUB, op1, op2, res, 0x80000000);
 }
 
 void CPUExecutor::CMP_eb_rb() { CMP_b(load_eb(), load_rb()); }
@@ -1193,22 +1134,14 @@ void CPUExecutor::DEC_eb()
 	uint8_t res = op1 - 1;
 	store_eb(res);
 
-	SET_FLAG(OF, res == 0x7f);
-	SET_FLAG(SF, res & 0x80);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(AF, (res & 0x0f) == 0x0f);
-	SET_FLAG(PF, PARITY(res));
+	SET_LAZY_FLAGS(DEC, op1, 1, res, 0x80);
 }
 
 uint16_t CPUExecutor::DEC_w(uint16_t _op1)
 {
 	uint16_t res = _op1 - 1;
 
-	SET_FLAG(OF, res == 0x7fff);
-	SET_FLAG(SF, res & 0x8000);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(AF, (res & 0x0f) == 0x0f);
-	SET_FLAG(PF, PARITY(res));
+	SET_LAZY_FLAGS(DEC, _op1, 1, res, 0x8000);
 
 	return res;
 }
@@ -1217,11 +1150,7 @@ uint32_t CPUExecutor::DEC_d(uint32_t _op1)
 {
 	uint32_t res = _op1 - 1;
 
-	SET_FLAG(OF, res == 0x7fffffff);
-	SET_FLAG(SF, res & 0x80000000);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(AF, (res & 0x0f) == 0x0f);
-	SET_FLAG(PF, PARITY(res));
+	SET_LAZY_FLAGS(DEC, _op1, 1, res, 0x80000000);
 
 	return res;
 }
@@ -1240,7 +1169,7 @@ void CPUExecutor::DIV_eb()
 {
 	uint8_t op2 = load_eb();
 	if(op2 == 0) {
-		throw CPUException(CPU_DIV_ER_EXC, 0);
+		g_cpu.raise(CPU_DIV_ER_EXC, 0);
 	}
 
 	uint16_t op1 = REG_AX;
@@ -1250,7 +1179,7 @@ void CPUExecutor::DIV_eb()
 	uint8_t quotient_8l = quotient_16 & 0xFF;
 
 	if(quotient_16 != quotient_8l) {
-		throw CPUException(CPU_DIV_ER_EXC, 0);
+		g_cpu.raise(CPU_DIV_ER_EXC, 0);
 	}
 
 	/* now write quotient back to destination */
@@ -1262,7 +1191,7 @@ void CPUExecutor::DIV_ew()
 {
 	uint16_t op2_16 = load_ew();
 	if(op2_16 == 0) {
-		throw CPUException(CPU_DIV_ER_EXC, 0);
+		g_cpu.raise(CPU_DIV_ER_EXC, 0);
 	}
 
 	uint32_t op1_32 = (uint32_t(REG_DX) << 16) | uint32_t(REG_AX);
@@ -1272,7 +1201,7 @@ void CPUExecutor::DIV_ew()
 	uint16_t quotient_16l = quotient_32 & 0xFFFF;
 
 	if(quotient_32 != quotient_16l) {
-		throw CPUException(CPU_DIV_ER_EXC, 0);
+		g_cpu.raise(CPU_DIV_ER_EXC, 0);
 	}
 
 	/* now write quotient back to destination */
@@ -1284,7 +1213,7 @@ void CPUExecutor::DIV_ed()
 {
 	uint32_t op2_32 = load_ed();
 	if(op2_32 == 0) {
-		throw CPUException(CPU_DIV_ER_EXC, 0);
+		g_cpu.raise(CPU_DIV_ER_EXC, 0);
 	}
 
 	uint64_t op1_64 = (uint64_t(REG_EDX) << 32) | uint64_t(REG_EAX);
@@ -1294,7 +1223,7 @@ void CPUExecutor::DIV_ed()
 	uint32_t quotient_32l = quotient_64 & 0xFFFFFFFF;
 
 	if(quotient_64 != quotient_32l) {
-		throw CPUException(CPU_DIV_ER_EXC, 0);
+		g_cpu.raise(CPU_DIV_ER_EXC, 0);
 	}
 
 	/* now write quotient back to destination */
@@ -1412,7 +1341,7 @@ void CPUExecutor::ENTER_o32()
 void CPUExecutor::FPU_ESC()
 {
 	if(CR0_EM || CR0_TS) {
-		throw CPUException(CPU_NM_EXC, 0);
+		g_cpu.raise(CPU_NM_EXC, 0);
 	}
 }
 
@@ -1449,13 +1378,13 @@ void CPUExecutor::IDIV_eb()
 
 	/* check MIN_INT case */
 	if(op1 == int16_t(0x8000)) {
-		throw CPUException(CPU_DIV_ER_EXC, 0);
+		g_cpu.raise(CPU_DIV_ER_EXC, 0);
 	}
 
 	int8_t op2 = int8_t(load_eb());
 
 	if(op2 == 0) {
-		throw CPUException(CPU_DIV_ER_EXC, 0);
+		g_cpu.raise(CPU_DIV_ER_EXC, 0);
 	}
 
 	int16_t quotient_16 = op1 / op2;
@@ -1463,7 +1392,7 @@ void CPUExecutor::IDIV_eb()
 	int8_t quotient_8l = quotient_16 & 0xFF;
 
 	if (quotient_16 != quotient_8l) {
-		throw CPUException(CPU_DIV_ER_EXC, 0);
+		g_cpu.raise(CPU_DIV_ER_EXC, 0);
 	}
 
 	/* now write quotient back to destination */
@@ -1477,13 +1406,13 @@ void CPUExecutor::IDIV_ew()
 
 	/* check MIN_INT case */
 	if(op1_32 == int32_t(0x80000000)) {
-		throw CPUException(CPU_DIV_ER_EXC, 0);
+		g_cpu.raise(CPU_DIV_ER_EXC, 0);
 	}
 
 	int16_t op2_16 = int16_t(load_ew());
 
 	if(op2_16 == 0) {
-		throw CPUException(CPU_DIV_ER_EXC, 0);
+		g_cpu.raise(CPU_DIV_ER_EXC, 0);
 	}
 
 	int32_t quotient_32  = op1_32 / op2_16;
@@ -1491,7 +1420,7 @@ void CPUExecutor::IDIV_ew()
 	int16_t quotient_16l = quotient_32 & 0xFFFF;
 
 	if(quotient_32 != quotient_16l) {
-		throw CPUException(CPU_DIV_ER_EXC, 0);
+		g_cpu.raise(CPU_DIV_ER_EXC, 0);
 	}
 
 	/* now write quotient back to destination */
@@ -1505,13 +1434,13 @@ void CPUExecutor::IDIV_ed()
 
 	/* check MIN_INT case */
 	if(op1_64 == int64_t(0x8000000000000000LL)) {
-		throw CPUException(CPU_DIV_ER_EXC, 0);
+		g_cpu.raise(CPU_DIV_ER_EXC, 0);
 	}
 
 	int32_t op2_32 = int32_t(load_ed());
 
 	if(op2_32 == 0) {
-		throw CPUException(CPU_DIV_ER_EXC, 0);
+		g_cpu.raise(CPU_DIV_ER_EXC, 0);
 	}
 
 	int64_t quotient_64  = op1_64 / op2_32;
@@ -1519,7 +1448,7 @@ void CPUExecutor::IDIV_ed()
 	int32_t quotient_32l = quotient_64 & 0xFFFFFFFF;
 
 	if(quotient_64 != quotient_32l) {
-		throw CPUException(CPU_DIV_ER_EXC, 0);
+		g_cpu.raise(CPU_DIV_ER_EXC, 0);
 	}
 
 	/* now write quotient back to destination */
@@ -1755,22 +1684,14 @@ void CPUExecutor::INC_eb()
 	uint8_t res = op1 + 1;
 	store_eb(res);
 
-	SET_FLAG(OF, res == 0x80);
-	SET_FLAG(SF, res & 0x80);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(AF, (res & 0x0f) == 0);
-	SET_FLAG(PF, PARITY(res));
+	SET_LAZY_FLAGS(INC, op1, 1, res, 0x80);
 }
 
 uint16_t CPUExecutor::INC_w(uint16_t _op1)
 {
 	uint16_t res = _op1 + 1;
 
-	SET_FLAG(OF, res == 0x8000);
-	SET_FLAG(SF, res & 0x8000);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(AF, (res & 0x0f) == 0);
-	SET_FLAG(PF, PARITY(res));
+	SET_LAZY_FLAGS(INC, _op1, 1, res, 0x8000);
 
 	return res;
 }
@@ -1779,11 +1700,7 @@ uint32_t CPUExecutor::INC_d(uint32_t _op1)
 {
 	uint32_t res = _op1 + 1;
 
-	SET_FLAG(OF, res == 0x80000000);
-	SET_FLAG(SF, res & 0x80000000);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(AF, (res & 0x0f) == 0);
-	SET_FLAG(PF, PARITY(res));
+	SET_LAZY_FLAGS(INC, _op1, 1, res, 0x80000000);
 
 	return res;
 }
@@ -1926,6 +1843,10 @@ void CPUExecutor::INT(uint8_t _vector, unsigned _type)
 	uint32_t retaddr = REG_CS.desc.base + REG_EIP;
 	static bool in_windows = false;
 
+	if(USE_IDLE_SKIP && (_vector == 0x16 || _vector == 0x28)) {
+		g_cpuidle.INT_call(_vector, ah, retaddr);
+	}
+
 	if(INT_TRAPS) {
 		std::vector<inttrap_interval_t> results;
 		m_inttraps_tree.findOverlapping(_vector, _vector, results);
@@ -2035,7 +1956,7 @@ void CPUExecutor::IRET()
 		// real and v8086 modes
 		if(IS_V8086() && (FLAG_IOPL < 3)) {
 			PDEBUGF(LOG_V2, LOG_CPU, "IRET: IOPL!=3 in v8086 mode\n");
-			throw CPUException(CPU_GP_EXC, 0);
+			g_cpu.raise(CPU_GP_EXC, 0);
 		}
 
 		uint16_t ip     = stack_pop_word();
@@ -2046,7 +1967,7 @@ void CPUExecutor::IRET()
 		if(ip > REG_CS.desc.limit) {
 			PDEBUGF(LOG_V2, LOG_CPU,
 				"IRET: instruction pointer not within code segment limits\n");
-			throw CPUException(CPU_GP_EXC, 0);
+			g_cpu.raise(CPU_GP_EXC, 0);
 		}
 
 		SET_CS(cs_raw);
@@ -2080,7 +2001,7 @@ void CPUExecutor::IRETD()
 		// real and v8086 modes
 		if(IS_V8086() && (FLAG_IOPL < 3)) {
 			PDEBUGF(LOG_V2, LOG_CPU, "IRETD: IOPL!=3 in v8086 mode\n");
-			throw CPUException(CPU_GP_EXC, 0);
+			g_cpu.raise(CPU_GP_EXC, 0);
 		}
 
 		uint32_t eip    = stack_pop_dword();
@@ -2091,7 +2012,7 @@ void CPUExecutor::IRETD()
 		if(eip > REG_CS.desc.limit) {
 			PDEBUGF(LOG_V2, LOG_CPU,
 				"IRETD: instruction pointer not within code segment limits\n");
-			throw CPUException(CPU_GP_EXC, 0);
+			g_cpu.raise(CPU_GP_EXC, 0);
 		}
 
 		SET_CS(cs_raw);
@@ -2258,6 +2179,7 @@ uint32_t CPUExecutor::LAR(uint16_t _raw_selector)
 	selector = _raw_selector;
 
 	try {
+		CPUFaultScope fault_scope;
 		raw_descriptor = fetch_descriptor(selector,0);
 	} catch(CPUException &e) {
 		//this fetch does not throw an exception
@@ -2319,7 +2241,7 @@ void CPUExecutor::LAR_rw_ew()
 {
 	if(!IS_PMODE()) {
 		PDEBUGF(LOG_V2, LOG_CPU, "LAR: not recognized in real mode\n");
-		throw CPUException(CPU_UD_EXC, 0);
+		g_cpu.raise(CPU_UD_EXC, 0);
 	}
 
 	uint16_t raw_selector = load_ew();
@@ -2333,7 +2255,7 @@ void CPUExecutor::LAR_rd_ew()
 {
 	if(!IS_PMODE()) {
 		PDEBUGF(LOG_V2, LOG_CPU, "LAR: not recognized in real mode\n");
-		throw CPUException(CPU_UD_EXC, 0);
+		g_cpu.raise(CPU_UD_EXC, 0);
 	}
 
 	uint16_t raw_selector = load_ew();
@@ -2352,7 +2274,7 @@ void CPUExecutor::LEA_rw_m()
 {
 	if(m_instr->modrm.mod == 3) {
 		PDEBUGF(LOG_V2, LOG_CPU, "LEA second operand is a register\n");
-		throw CPUException(CPU_UD_EXC, 0);
+		g_cpu.raise(CPU_UD_EXC, 0);
 	}
 	uint16_t offset = (this->*EA_get_offset)();
 	store_rw(offset);
@@ -2362,7 +2284,7 @@ void CPUExecutor::LEA_rd_m()
 {
 	if(m_instr->modrm.mod == 3) {
 		PDEBUGF(LOG_V2, LOG_CPU, "LEA second operand is a register\n");
-		throw CPUException(CPU_UD_EXC, 0);
+		g_cpu.raise(CPU_UD_EXC, 0);
 	}
 	uint32_t offset = (this->*EA_get_offset)();
 	store_rd(offset);
@@ -2414,6 +2336,7 @@ void CPUExecutor::LGDT_o16()
 	uint32_t base; uint16_t limit;
 	LDT_m(base, limit);
 	SET_GDTR(base & 0x00FFFFFF, limit);
+	desc_cache_flush();
 }
 
 void CPUExecutor::LGDT_o32()
@@ -2421,6 +2344,7 @@ void CPUExecutor::LGDT_o32()
 	uint32_t base; uint16_t limit;
 	LDT_m(base, limit);
 	SET_GDTR(base, limit);
+	desc_cache_flush();
 }
 
 void CPUExecutor::LIDT_o16()
@@ -2428,6 +2352,7 @@ void CPUExecutor::LIDT_o16()
 	uint32_t base; uint16_t limit;
 	LDT_m(base, limit);
 	SET_IDTR(base & 0x00FFFFFF, limit);
+	desc_cache_flush();
 }
 
 void CPUExecutor::LIDT_o32()
@@ -2435,6 +2360,7 @@ void CPUExecutor::LIDT_o32()
 	uint32_t base; uint16_t limit;
 	LDT_m(base, limit);
 	SET_IDTR(base, limit);
+	desc_cache_flush();
 }
 
 void CPUExecutor::LLDT_ew()
@@ -2445,12 +2371,12 @@ void CPUExecutor::LLDT_ew()
 
 	if(!IS_PMODE()) {
 		PDEBUGF(LOG_V2, LOG_CPU,"LLDT: not recognized in real mode\n");
-		throw CPUException(CPU_UD_EXC, 0);
+		g_cpu.raise(CPU_UD_EXC, 0);
 	}
 
 	if(CPL != 0) {
 		PDEBUGF(LOG_V2, LOG_CPU,"LLDT: The current priveledge level is not 0\n");
-		throw CPUException(CPU_GP_EXC, 0);
+		g_cpu.raise(CPU_GP_EXC, 0);
 	}
 
 	selector = load_ew();
@@ -2465,7 +2391,7 @@ void CPUExecutor::LLDT_ew()
 	// #GP(selector) if the selector operand does not point into GDT
 	if(selector.ti != 0) {
 		PDEBUGF(LOG_V2, LOG_CPU,"LLDT: selector.ti != 0\n");
-		throw CPUException(CPU_GP_EXC, selector.value & SELECTOR_RPL_MASK);
+		g_cpu.raise(CPU_GP_EXC, selector.value & SELECTOR_RPL_MASK);
 	}
 
 	/* fetch descriptor; call handles out of limits checks */
@@ -2476,17 +2402,18 @@ void CPUExecutor::LLDT_ew()
          descriptor.type != DESC_TYPE_LDT_DESC)
 	{
 		PDEBUGF(LOG_V2, LOG_CPU,"LLDT: doesn't point to an LDT descriptor!\n");
-		throw CPUException(CPU_GP_EXC, selector.value & SELECTOR_RPL_MASK);
+		g_cpu.raise(CPU_GP_EXC, selector.value & SELECTOR_RPL_MASK);
 	}
 
 	/* #NP(selector) if LDT descriptor is not present */
 	if(!descriptor.present) {
 		PDEBUGF(LOG_V2, LOG_CPU,"LLDT: LDT descriptor not present!\n");
-		throw CPUException(CPU_NP_EXC, selector.value & SELECTOR_RPL_MASK);
+		g_cpu.raise(CPU_NP_EXC, selector.value & SELECTOR_RPL_MASK);
 	}
 
 	REG_LDTR.sel = selector;
 	REG_LDTR.desc = descriptor;
+	desc_cache_flush();
 }
 
 
@@ -2811,7 +2738,7 @@ uint32_t CPUExecutor::LSL()
 
 	if(!IS_PMODE()) {
 		PDEBUGF(LOG_V2, LOG_CPU, "LSL: not recognized in real mode\n");
-		throw CPUException(CPU_UD_EXC, 0);
+		g_cpu.raise(CPU_UD_EXC, 0);
 	}
 
 	selector = load_ew();
@@ -2823,6 +2750,7 @@ uint32_t CPUExecutor::LSL()
 	}
 
 	try {
+		CPUFaultScope fault_scope;
 		descriptor = fetch_descriptor(selector, CPU_GP_EXC);
 	} catch(CPUException &e) {
 		PDEBUGF(LOG_V2, LOG_CPU, "LSL: failed to fetch descriptor\n");
@@ -2889,24 +2817,24 @@ void CPUExecutor::LTR_ew()
 
 	if(!IS_PMODE()) {
 		PDEBUGF(LOG_V2, LOG_CPU, "LTR: not recognized in real mode\n");
-		throw CPUException(CPU_UD_EXC, 0);
+		g_cpu.raise(CPU_UD_EXC, 0);
 	}
 
 	if(CPL != 0) {
 		PDEBUGF(LOG_V2, LOG_CPU, "LTR: The current priveledge level is not 0\n");
-		throw CPUException(CPU_GP_EXC, 0);
+		g_cpu.raise(CPU_GP_EXC, 0);
 	}
 
 	selector = load_ew();
 
 	if((selector.value & SELECTOR_RPL_MASK) == 0) {
 		PDEBUGF(LOG_V2, LOG_CPU, "LTR: loading with NULL selector!\n");
-		throw CPUException(CPU_GP_EXC, 0);
+		g_cpu.raise(CPU_GP_EXC, 0);
 	}
 
 	if(selector.ti) {
 		PDEBUGF(LOG_V2, LOG_CPU, "LTR: selector.ti != 0\n");
-		throw CPUException(CPU_GP_EXC, selector.value & SELECTOR_RPL_MASK);
+		g_cpu.raise(CPU_GP_EXC, selector.value & SELECTOR_RPL_MASK);
 	}
 
 	/* fetch descriptor; call handles out of limits checks */
@@ -2918,13 +2846,13 @@ void CPUExecutor::LTR_ew()
 	    descriptor.type!=DESC_TYPE_AVAIL_386_TSS))
 	{
 		PDEBUGF(LOG_V2, LOG_CPU, "LTR: doesn't point to an available TSS descriptor!\n");
-		throw CPUException(CPU_GP_EXC, selector.value & SELECTOR_RPL_MASK);
+		g_cpu.raise(CPU_GP_EXC, selector.value & SELECTOR_RPL_MASK);
 	}
 
 	/* #NP(selector) if TSS descriptor is not present */
 	if(!descriptor.present) {
 		PDEBUGF(LOG_V2, LOG_CPU, "LTR: TSS descriptor not present!\n");
-		throw CPUException(CPU_NP_EXC, selector.value & SELECTOR_RPL_MASK);
+		g_cpu.raise(CPU_NP_EXC, selector.value & SELECTOR_RPL_MASK);
 	}
 
 	REG_TR.sel  = selector;
@@ -3127,7 +3055,7 @@ void CPUExecutor::MOV_DR_rd()
 {
 	if(REG_DRBIT(7, GD)) {
 		g_cpu.set_debug_trap_bit(CPU_DEBUG_DR_ACCESS_BIT);
-		throw CPUException(CPU_DEBUG_EXC, 0);
+		g_cpu.raise(CPU_DEBUG_EXC, 0);
 	}
 
 	check_CPL_privilege(!IS_RMODE(), "MOV_DR_rd");
@@ -3164,7 +3092,7 @@ void CPUExecutor::MOV_rd_DR()
 {
 	if(REG_DRBIT(7, GD)) {
 		g_cpu.set_debug_trap_bit(CPU_DEBUG_DR_ACCESS_BIT);
-		throw CPUException(CPU_DEBUG_EXC, 0);
+		g_cpu.raise(CPU_DEBUG_EXC, 0);
 	}
 
 	check_CPL_privilege(!IS_RMODE(), "MOV_rd_DR");
@@ -3300,12 +3228,7 @@ void CPUExecutor::NEG_eb()
 	uint8_t res = -(int8_t)(op1);
 	store_eb(res);
 
-	SET_FLAG(CF, op1);
-	SET_FLAG(AF, op1 & 0x0f);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(SF, res & 0x80);
-	SET_FLAG(OF, op1 == 0x80);
-	SET_FLAG(PF, PARITY(res));
+	SET_LAZY_FLAGS(SUB, 0, op1, res, 0x80);
 }
 
 void CPUExecutor::NEG_ew()
@@ -3314,12 +3237,7 @@ void CPUExecutor::NEG_ew()
 	uint16_t res = -(int16_t)(op1);
 	store_ew(res);
 
-	SET_FLAG(CF, op1);
-	SET_FLAG(AF, op1 & 0x0f);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(SF, res & 0x8000);
-	SET_FLAG(OF, op1 == 0x8000);
-	SET_FLAG(PF, PARITY(res));
+	SET_LAZY_FLAGS(SUB, 0, op1, res, 0x8000);
 }
 
 void CPUExecutor::NEG_ed()
@@ -3328,12 +3246,7 @@ void CPUExecutor::NEG_ed()
 	uint32_t res = -(int32_t)(op1);
 	store_ed(res);
 
-	SET_FLAG(CF, op1);
-	SET_FLAG(AF, op1 & 0x0f);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(SF, res & 0x80000000);
-	SET_FLAG(OF, op1 == 0x80000000);
-	SET_FLAG(PF, PARITY(res));
+	SET_LAZY_FLAGS(SUB, 0, op1, res, 0x80000000);
 }
 
 
@@ -3378,12 +3291,7 @@ uint8_t CPUExecutor::OR_b(uint8_t op1, uint8_t op2)
 {
 	uint8_t res = op1 | op2;
 
-	SET_FLAG(SF, res & 0x80);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(PF, PARITY(res));
-	SET_FLAG(OF, false);
-	SET_FLAG(CF, false);
-	SET_FLAG(AF, false); // unknown
+	SET_LAZY_FLAGS(LOGIC, op1, op2, res, 0x80);
 
 	return res;
 }
@@ -3392,12 +3300,7 @@ uint16_t CPUExecutor::OR_w(uint16_t op1, uint16_t op2)
 {
 	uint16_t res = op1 | op2;
 
-	SET_FLAG(SF, res & 0x8000);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(PF, PARITY(res));
-	SET_FLAG(OF, false);
-	SET_FLAG(CF, false);
-	SET_FLAG(AF, false); // unknown
+	SET_LAZY_FLAGS(LOGIC, op1, op2, res, 0x8000);
 
 	return res;
 }
@@ -3406,12 +3309,7 @@ uint32_t CPUExecutor::OR_d(uint32_t op1, uint32_t op2)
 {
 	uint32_t res = op1 | op2;
 
-	SET_FLAG(SF, res & 0x80000000);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(PF, PARITY(res));
-	SET_FLAG(OF, false);
-	SET_FLAG(CF, false);
-	SET_FLAG(AF, false); // unknown
+	SET_LAZY_FLAGS(LOGIC, op1, op2, res, 0x80000000);
 
 	return res;
 }
@@ -3656,7 +3554,7 @@ void CPUExecutor::POPF()
 {
 	if(IS_V8086() && (FLAG_IOPL < 3)) {
 		PDEBUGF(LOG_CPU, LOG_V2, "POPF: #GP(0) in v8086 mode\n");
-		throw CPUException(CPU_GP_EXC, 0);
+		g_cpu.raise(CPU_GP_EXC, 0);
 	}
 
 	uint16_t flags = stack_pop_word();
@@ -3671,7 +3569,7 @@ void CPUExecutor::POPFD()
 	 */
 	if(IS_V8086() && (FLAG_IOPL < 3)) {
 		PDEBUGF(LOG_CPU, LOG_V2, "POPFD: #GP(0) in v8086 mode\n");
-		throw CPUException(CPU_GP_EXC, 0);
+		g_cpu.raise(CPU_GP_EXC, 0);
 	}
 
 	uint16_t flags = uint16_t(stack_pop_dword());
@@ -3705,7 +3603,7 @@ void CPUExecutor::PUSHA()
 
 	if(!IS_PMODE()) {
 		if(sp == 7 || sp == 9 || sp == 11 || sp == 13 || sp == 15) {
-			throw CPUException(CPU_SEG_OVR_EXC,0);
+			g_cpu.raise(CPU_SEG_OVR_EXC,0);
 		}
 		if(sp == 1 || sp == 3 || sp == 5) {
 			throw CPUShutdown("SP=1,3,5 on stack push (PUSHA)");
@@ -3734,7 +3632,7 @@ void CPUExecutor::PUSHAD()
 
 	if(!IS_PMODE()) {
 		if(sp == 7 || sp == 9 || sp == 11 || sp == 13 || sp == 15) {
-			throw CPUException(CPU_SEG_OVR_EXC,0);
+			g_cpu.raise(CPU_SEG_OVR_EXC,0);
 		}
 		if(sp == 1 || sp == 3 || sp == 5) {
 			throw CPUShutdown("SP=1,3,5 on stack push (PUSHAD)");
@@ -3766,7 +3664,7 @@ void CPUExecutor::PUSHF()
 {
 	if(IS_V8086() && FLAG_IOPL < 3) {
 		PDEBUGF(LOG_V2, LOG_CPU, "Push Flags: general protection in v8086 mode\n");
-		throw CPUException(CPU_GP_EXC, 0);
+		g_cpu.raise(CPU_GP_EXC, 0);
 	}
 	uint16_t flags = GET_FLAGS();
 	stack_push_word(flags);
@@ -3776,7 +3674,7 @@ void CPUExecutor::PUSHFD()
 {
 	if(IS_V8086() && FLAG_IOPL < 3) {
 		PDEBUGF(LOG_V2, LOG_CPU, "Push Flags: general protection in v8086 mode\n");
-		throw CPUException(CPU_GP_EXC, 0);
+		g_cpu.raise(CPU_GP_EXC, 0);
 	}
 	// VM & RF flags cleared when pushed onto stack
 	uint32_t eflags = GET_EFLAGS() & ~(FMASK_RF | FMASK_VM);
@@ -4515,12 +4413,7 @@ uint8_t CPUExecutor::SBB_b(uint8_t _op1, uint8_t _op2)
 	uint8_t cf = FLAG_CF;
 	uint8_t res = _op1 - (_op2 + cf);
 
-	SET_FLAG(OF, ((_op1 ^ _op2) & (_op1 ^ res)) & 0x80);
-	SET_FLAG(SF, res & 0x80);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(AF, ((_op1 ^ _op2) ^ res) & 0x10);
-	SET_FLAG(PF, PARITY(res));
-	SET_FLAG(CF, (_op1 < res) || (cf && (_op2==0xff)));
+	SET_LAZY_FLAGS(SUB, _op1, _op2, res, 0x80);
 
 	return res;
 }
@@ -4530,12 +4423,7 @@ uint16_t CPUExecutor::SBB_w(uint16_t _op1, uint16_t _op2)
 	uint16_t cf = FLAG_CF;
 	uint16_t res = _op1 - (_op2 + cf);
 
-	SET_FLAG(OF, ((_op1 ^ _op2) & (_op1 ^ res)) & 0x8000);
-	SET_FLAG(SF, res & 0x8000);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(AF, ((_op1 ^ _op2) ^ res) & 0x10);
-	SET_FLAG(PF, PARITY(res));
-	SET_FLAG(CF, (_op1 < res) || (cf && (_op2==0xffff)));
+	SET_LAZY_FLAGS(SUB, _op1, _op2, res, 0x8000);
 
 	return res;
 }
@@ -4545,12 +4433,7 @@ uint32_t CPUExecutor::SBB_d(uint32_t _op1, uint32_t _op2)
 	uint32_t cf = FLAG_CF;
 	uint32_t res = _op1 - (_op2 + cf);
 
-	SET_FLAG(OF, ((_op1 ^ _op2) & (_op1 ^ res)) & 0x80000000);
-	SET_FLAG(SF, res & 0x80000000);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(AF, ((_op1 ^ _op2) ^ res) & 0x10);
-	SET_FLAG(PF, PARITY(res));
-	SET_FLAG(CF, (_op1 < res) || (cf && (_op2==0xffffffff)));
+	SET_LAZY_FLAGS(SUB, _op1, _op2, res, 0x80000000);
 
 	return res;
 }
@@ -4700,7 +4583,7 @@ void CPUExecutor::SLDT_ew()
 {
 	if(!IS_PMODE()) {
 		PDEBUGF(LOG_V2, LOG_CPU, "SLDT: not recognized in real mode\n");
-		throw CPUException(CPU_UD_EXC, 0);
+		g_cpu.raise(CPU_UD_EXC, 0);
 	}
 	uint16_t val16 = REG_LDTR.sel.value;
 	store_ew(val16);
@@ -4887,10 +4770,10 @@ void CPUExecutor::STI()
 {
 	if(IS_PMODE() && (FLAG_IOPL < CPL)) {
 		PDEBUGF(LOG_V2, LOG_CPU, "STI: IOPL < CPL  in protected mode\n");
-		throw CPUException(CPU_GP_EXC, 0);
+		g_cpu.raise(CPU_GP_EXC, 0);
     } else if(IS_V8086() && (FLAG_IOPL != 3)) {
 		PDEBUGF(LOG_V2, LOG_CPU, "STI: IOPL != 3 in V8086 mode\n");
-		throw CPUException(CPU_GP_EXC, 0);
+		g_cpu.raise(CPU_GP_EXC, 0);
     }
 
 	if(!FLAG_IF) {
@@ -4985,7 +4868,7 @@ void CPUExecutor::STR_ew()
 {
 	if(!IS_PMODE()) {
 		PDEBUGF(LOG_V2, LOG_CPU, "STR: not recognized in real mode\n");
-		throw CPUException(CPU_UD_EXC, 0);
+		g_cpu.raise(CPU_UD_EXC, 0);
 	}
 	uint16_t val = REG_TR.sel.value;
 	store_ew(val);
@@ -5006,12 +4889,7 @@ uint8_t CPUExecutor::SUB_b(uint8_t _op1, uint8_t _op2)
 {
 	uint8_t res = _op1 - _op2;
 
-	SET_FLAG(OF, ((_op1 ^ _op2) & (_op1 ^ res)) & 0x80);
-	SET_FLAG(SF, res & 0x80);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(AF, ((_op1 ^ _op2) ^ res) & 0x10);
-	SET_FLAG(PF, PARITY(res));
-	SET_FLAG(CF, _op1 < _op2);
+	SET_LAZY_FLAGS(SUB, _op1, _op2, res, 0x80);
 
 	return res;
 }
@@ -5020,12 +4898,7 @@ uint16_t CPUExecutor::SUB_w(uint16_t _op1, uint16_t _op2)
 {
 	uint16_t res = _op1 - _op2;
 
-	SET_FLAG(OF, ((_op1 ^ _op2) & (_op1 ^ res)) & 0x8000);
-	SET_FLAG(SF, res & 0x8000);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(AF, ((_op1 ^ _op2) ^ res) & 0x10);
-	SET_FLAG(PF, PARITY(res));
-	SET_FLAG(CF, _op1 < _op2);
+	SET_LAZY_FLAGS(SUB, _op1, _op2, res, 0x8000);
 
 	return res;
 }
@@ -5034,12 +4907,7 @@ uint32_t CPUExecutor::SUB_d(uint32_t _op1, uint32_t _op2)
 {
 	uint32_t res = _op1 - _op2;
 
-	SET_FLAG(OF, ((_op1 ^ _op2) & (_op1 ^ res)) & 0x80000000);
-	SET_FLAG(SF, res & 0x80000000);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(AF, ((_op1 ^ _op2) ^ res) & 0x10);
-	SET_FLAG(PF, PARITY(res));
-	SET_FLAG(CF, _op1 < _op2);
+	SET_LAZY_FLAGS(SUB, _op1, _op2, res, 0x80000000);
 
 	return res;
 }
@@ -5068,36 +4936,21 @@ void CPUExecutor::TEST_b(uint8_t _value1, uint8_t _value2)
 {
 	uint8_t res = _value1 & _value2;
 
-	SET_FLAG(OF, false);
-	SET_FLAG(CF, false);
-	SET_FLAG(SF, res & 0x80);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(PF, PARITY(res));
-	SET_FLAG(AF, false); // unknown
+	SET_LAZY_FLAGS(LOGIC, _value1, _value2, res, 0x80);
 }
 
 void CPUExecutor::TEST_w(uint16_t _value1, uint16_t _value2)
 {
 	uint16_t res = _value1 & _value2;
 
-	SET_FLAG(OF, false);
-	SET_FLAG(CF, false);
-	SET_FLAG(SF, res & 0x8000);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(PF, PARITY(res));
-	SET_FLAG(AF, false); // unknown
+	SET_LAZY_FLAGS(LOGIC, _value1, _value2, res, 0x8000);
 }
 
 void CPUExecutor::TEST_d(uint32_t _value1, uint32_t _value2)
 {
 	uint32_t res = _value1 & _value2;
 
-	SET_FLAG(OF, false);
-	SET_FLAG(CF, false);
-	SET_FLAG(SF, res & 0x80000000);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(PF, PARITY(res));
-	SET_FLAG(AF, false); // unknown
+	SET_LAZY_FLAGS(LOGIC, _value1, _value2, res, 0x80000000);
 }
 
 void CPUExecutor::TEST_eb_rb() { TEST_b(load_eb(), load_rb()); }
@@ -5122,7 +4975,7 @@ void CPUExecutor::VERR_ew()
 
 	if(!IS_PMODE()) {
 		PDEBUGF(LOG_V2, LOG_CPU, "VERR: not recognized in real mode\n");
-		throw CPUException(CPU_UD_EXC, 0);
+		g_cpu.raise(CPU_UD_EXC, 0);
 	}
 
 	selector = load_ew();
@@ -5135,6 +4988,7 @@ void CPUExecutor::VERR_ew()
 	}
 
 	try {
+		CPUFaultScope fault_scope;
 		descriptor = fetch_descriptor(selector,0);
 	} catch(CPUException &e) {
 	    PDEBUGF(LOG_V2, LOG_CPU, "VERR: not within descriptor table\n");
@@ -5197,7 +5051,7 @@ void CPUExecutor::VERW_ew()
 
 	if(!IS_PMODE()) {
 		PDEBUGF(LOG_V2, LOG_CPU, "VERW: not recognized in real mode\n");
-		throw CPUException(CPU_UD_EXC, 0);
+		g_cpu.raise(CPU_UD_EXC, 0);
 	}
 
 	selector = load_ew();
@@ -5215,6 +5069,7 @@ void CPUExecutor::VERW_ew()
 	 */
 
 	try {
+		CPUFaultScope fault_scope;
 		descriptor = fetch_descriptor(selector,0);
 	} catch(CPUException &e) {
 		PDEBUGF(LOG_V2, LOG_CPU, "VERW: not within descriptor table\n");
@@ -5262,7 +5117,7 @@ unmasked numeric error.
 */
 	//checks also MP
 	if(CR0_TS && CR0_MP) {
-		throw CPUException(CPU_NM_EXC, 0);
+		g_cpu.raise(CPU_NM_EXC, 0);
 	}
 }
 
@@ -5333,12 +5188,7 @@ uint8_t CPUExecutor::XOR_b(uint8_t _op1, uint8_t _op2)
 {
 	uint8_t res = _op1 ^ _op2;
 
-	SET_FLAG(CF, false);
-	SET_FLAG(OF, false);
-	SET_FLAG(SF, res & 0x80);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(PF, PARITY(res));
-	SET_FLAG(AF, false); // unknown
+	SET_LAZY_FLAGS(LOGIC, _op1, _op2, res, 0x80);
 
 	return res;
 }
@@ -5347,12 +5197,7 @@ uint16_t CPUExecutor::XOR_w(uint16_t _op1, uint16_t _op2)
 {
 	uint16_t res = _op1 ^ _op2;
 
-	SET_FLAG(CF, false);
-	SET_FLAG(OF, false);
-	SET_FLAG(SF, res & 0x8000);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(PF, PARITY(res));
-	SET_FLAG(AF, false); // unknown
+	SET_LAZY_FLAGS(LOGIC, _op1, _op2, res, 0x8000);
 
 	return res;
 }
@@ -5361,12 +5206,7 @@ uint32_t CPUExecutor::XOR_d(uint32_t _op1, uint32_t _op2)
 {
 	uint32_t res = _op1 ^ _op2;
 
-	SET_FLAG(CF, false);
-	SET_FLAG(OF, false);
-	SET_FLAG(SF, res & 0x80000000);
-	SET_FLAG(ZF, res == 0);
-	SET_FLAG(PF, PARITY(res));
-	SET_FLAG(AF, false); // unknown
+	SET_LAZY_FLAGS(LOGIC, _op1, _op2, res, 0x80000000);
 
 	return res;
 }
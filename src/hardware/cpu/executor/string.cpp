@@ -0,0 +1,293 @@
+/*
+ * Copyright (C) 2018  Marco Bortolin
+ *
+ * This file is part of IBMulator.
+ *
+ * IBMulator is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * IBMulator is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with IBMulator.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ibmulator.h"
+#include "hardware/cpu/executor.h"
+#include "hardware/cpu/mmu.h"
+#include "hardware/memory.h"
+#include "hardware/devices.h"
+#include <cstring>
+#include <algorithm>
+
+/* Bulk execution of REP MOVS/STOS/LODS/SCAS/CMPS/INS/OUTS.
+ * After an iteration executed the normal way, the following iterations can be
+ * executed directly on the RAM buffer, as long as their elements stay inside
+ * the segment limits and inside the same page of the elements just accessed
+ * (so the protection checks and the page translations are the same).
+ * The number of iterations is decided by the CPU, which charges their cycles.
+ * The operations never raise exceptions: if any condition is not satisfied no
+ * iteration is executed and the instruction continues the normal way.
+ * INS and OUTS are executed in bulk only if the device supports block
+ * transfers for the port (see IODevice::read_block()).
+ */
+
+static inline uint32_t bulk_get(const uint8_t *_p, unsigned _size)
+{
+	switch(_size) {
+		case 1: return *_p;
+		case 2: { uint16_t v; memcpy(&v, _p, 2); return v; }
+		default: { uint32_t v; memcpy(&v, _p, 4); return v; }
+	}
+}
+
+static inline void bulk_put(uint8_t *_p, uint32_t _value, unsigned _size)
+{
+	switch(_size) {
+		case 1: *_p = _value; break;
+		case 2: { uint16_t v = _value; memcpy(_p, &v, 2); break; }
+		default: memcpy(_p, &_value, 4); break;
+	}
+}
+
+uint8_t * CPUExecutor::rep_bulk_block(SegReg &_seg, uint32_t _offset, unsigned _size,
+		bool _write, unsigned &count_)
+{
+	if(_seg.desc.is_expand_down()) {
+		return nullptr;
+	}
+	bool df = FLAG_DF;
+	uint64_t count = count_;
+
+	// segment limit and address size wrap around
+	if(!df) {
+		uint64_t end = uint64_t(std::min(_seg.desc.limit, m_addr_mask)) + 1;
+		if(uint64_t(_offset) + _size > end) {
+			return nullptr;
+		}
+		count = std::min(count, (end - _offset) / _size);
+	} else {
+		if(uint64_t(_offset) + _size - 1 > _seg.desc.limit) {
+			return nullptr;
+		}
+		count = std::min(count, uint64_t(_offset / _size) + 1);
+	}
+
+	// the page of the previous element
+	uint32_t linear = _seg.desc.base + _offset;
+	uint32_t prev = _seg.desc.base + ((_offset + (df ? _size : -_size)) & m_addr_mask);
+	if(LPF_OF(prev) != LPF_OF(linear)
+	|| PAGE_OFFSET(linear) + _size > 4096
+	|| PAGE_OFFSET(prev) + _size > 4096)
+	{
+		return nullptr;
+	}
+	if(!df) {
+		count = std::min(count, uint64_t((4096 - PAGE_OFFSET(linear)) / _size));
+	} else {
+		count = std::min(count, uint64_t(PAGE_OFFSET(linear) / _size) + 1);
+	}
+	if(count == 0) {
+		return nullptr;
+	}
+
+	uint32_t phy = linear;
+	if(IS_PAGING()) {
+		// same page and access type of the previous element, can't fault
+		phy = g_cpummu.TLB_lookup(linear, _size, IS_USER_PL, _write);
+	}
+	uint32_t bytes = count * _size;
+	uint32_t lowest = df ? (phy - (bytes - _size)) : phy;
+	uint8_t *block = g_memory.get_ram_block(lowest, bytes, _write);
+	if(!block) {
+		return nullptr;
+	}
+	count_ = count;
+	return block + (phy - lowest);
+}
+
+unsigned CPUExecutor::rep_bulk(unsigned _count)
+{
+	if(UNLIKELY(DR7_ENABLED_ANY) || FLAG_TF) {
+		return 0;
+	}
+
+	// the store of the iteration just executed must be visible to the next
+	// ones (eg. a forward fill with DI = SI + 1)
+	g_cpubus.flush_write_queue();
+
+	bool a32 = m_instr->addr32;
+	uint32_t si = a32 ? REG_ESI : REG_SI;
+	uint32_t di = a32 ? REG_EDI : REG_DI;
+	unsigned size = (m_instr->opcode & 1) ? (m_instr->op32 ? 4 : 2) : 1;
+	int step = FLAG_DF ? -int(size) : int(size);
+	unsigned count = _count;
+	uint8_t *src = nullptr, *dst = nullptr;
+	uint32_t acc = REG_EAX;
+
+	switch(m_instr->opcode) {
+		case 0xA4: case 0xA5: { // MOVS
+			if(!(src = rep_bulk_block(SEG_REG(m_base_ds), si, size, false, count))) {
+				return 0;
+			}
+			if(!(dst = rep_bulk_block(REG_ES, di, size, true, count))) {
+				return 0;
+			}
+			/* Elements are moved one at a time in the DF direction; memmove
+			 * gives the same result unless the destination overlaps source
+			 * elements that are still to be read.
+			 */
+			uint32_t bytes = count * size;
+			uint8_t *slo = (step > 0) ? src : src - (bytes - size);
+			uint8_t *dlo = (step > 0) ? dst : dst - (bytes - size);
+			bool overlap = (dlo < slo + bytes) && (slo < dlo + bytes);
+			if(!overlap || (step > 0 && dlo <= slo) || (step < 0 && dlo >= slo)) {
+				memmove(dlo, slo, bytes);
+			} else {
+				for(unsigned i=0; i<count; i++) {
+					bulk_put(dst, bulk_get(src, size), size);
+					src += step;
+					dst += step;
+				}
+			}
+			break;
+		}
+		case 0xAA: case 0xAB: { // STOS
+			if(!(dst = rep_bulk_block(REG_ES, di, size, true, count))) {
+				return 0;
+			}
+			uint8_t *dlo = (step > 0) ? dst : dst - (count - 1) * size;
+			if(size == 1) {
+				memset(dlo, REG_AL, count);
+			} else {
+				for(unsigned i=0; i<count; i++) {
+					bulk_put(dlo + i*size, acc, size);
+				}
+			}
+			break;
+		}
+		case 0xAC: case 0xAD: { // LODS
+			if(!(src = rep_bulk_block(SEG_REG(m_base_ds), si, size, false, count))) {
+				return 0;
+			}
+			acc = bulk_get(src + int(count - 1) * step, size);
+			switch(size) {
+				case 1: REG_AL = acc; break;
+				case 2: REG_AX = acc; break;
+				default: REG_EAX = acc; break;
+			}
+			break;
+		}
+		case 0xAE: case 0xAF: { // SCAS
+			if(!(dst = rep_bulk_block(REG_ES, di, size, false, count))) {
+				return 0;
+			}
+			uint32_t mask = (size == 4) ? 0xFFFFFFFF : ((1 << (size*8)) - 1);
+			acc &= mask;
+			uint32_t op2 = 0;
+			unsigned i = 0;
+			if(size == 1 && step > 0 && !m_instr->rep_equal) {
+				// REPNE SCASB, the usual strlen/strchr
+				const uint8_t *found = (const uint8_t *)memchr(dst, acc, count);
+				i = found ? (found - dst) : (count - 1);
+				op2 = dst[i];
+			} else {
+				while(i < count) {
+					op2 = bulk_get(dst + int(i) * step, size);
+					if((op2 == acc) != m_instr->rep_equal) {
+						break;
+					}
+					i++;
+				}
+				if(i == count) {
+					i--;
+				}
+			}
+			count = i + 1;
+			switch(size) {
+				case 1: CMP_b(acc, op2); break;
+				case 2: CMP_w(acc, op2); break;
+				default: CMP_d(acc, op2); break;
+			}
+			break;
+		}
+		case 0xA6: case 0xA7: { // CMPS
+			if(!(src = rep_bulk_block(SEG_REG(m_base_ds), si, size, false, count))) {
+				return 0;
+			}
+			if(!(dst = rep_bulk_block(REG_ES, di, size, false, count))) {
+				return 0;
+			}
+			uint32_t op1 = 0, op2 = 0;
+			unsigned i = 0;
+			while(i < count) {
+				op1 = bulk_get(src + int(i) * step, size);
+				op2 = bulk_get(dst + int(i) * step, size);
+				if((op1 == op2) != m_instr->rep_equal) {
+					break;
+				}
+				i++;
+			}
+			if(i == count) {
+				i--;
+			}
+			count = i + 1;
+			switch(size) {
+				case 1: CMP_b(op1, op2); break;
+				case 2: CMP_w(op1, op2); break;
+				default: CMP_d(op1, op2); break;
+			}
+			break;
+		}
+		case 0x6C: case 0x6D: { // INS
+			if(size > 2 || step < 0) {
+				return 0;
+			}
+			if(!(dst = rep_bulk_block(REG_ES, di, size, true, count))) {
+				return 0;
+			}
+			if(!(count = g_devices.read_block(REG_DX, dst, count, size))) {
+				return 0;
+			}
+			break;
+		}
+		case 0x6E: case 0x6F: { // OUTS
+			if(size > 2 || step < 0) {
+				return 0;
+			}
+			if(!(src = rep_bulk_block(SEG_REG(m_base_ds), si, size, false, count))) {
+				return 0;
+			}
+			if(!(count = g_devices.write_block(REG_DX, src, count, size))) {
+				return 0;
+			}
+			break;
+		}
+		default:
+			return 0;
+	}
+
+	uint32_t delta = uint32_t(int(count) * step);
+	if(src) {
+		if(a32) {
+			REG_ESI += delta;
+		} else {
+			REG_SI += delta;
+		}
+	}
+	if(dst) {
+		if(a32) {
+			REG_EDI += delta;
+		} else {
+			REG_DI += delta;
+		}
+	}
+
+	m_rep_bulk_count = count;
+	return count;
+}
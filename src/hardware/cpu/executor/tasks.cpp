@@ -31,7 +31,7 @@ void CPUExecutor::get_SS_ESP_from_TSS(unsigned pl, uint16_t &ss_, uint32_t &esp_
 		uint32_t TSSstackaddr = 4 * pl + 2;
 		if((TSSstackaddr+3) > REG_TR.desc.limit) {
 			PDEBUGF(LOG_V2, LOG_CPU, "get_SS_ESP_from_TSS: TSSstackaddr > TSS.LIMIT\n");
-			throw CPUException(CPU_TS_EXC, REG_TR.sel.value & SELECTOR_RPL_MASK);
+			g_cpu.raise(CPU_TS_EXC, REG_TR.sel.value & SELECTOR_RPL_MASK);
 		}
 		ss_  = read_word(REG_TR.desc.base + TSSstackaddr + 2);
 		esp_ = read_word(REG_TR.desc.base + TSSstackaddr);
@@ -39,7 +39,7 @@ void CPUExecutor::get_SS_ESP_from_TSS(unsigned pl, uint16_t &ss_, uint32_t &esp_
 		uint32_t TSSstackaddr = 8 * pl + 4;
 		if((TSSstackaddr+7) > REG_TR.desc.limit) {
 			PDEBUGF(LOG_V2, LOG_CPU, "get_SS_ESP_from_TSS: TSSstackaddr > TSS.LIMIT\n");
-			throw CPUException(CPU_TS_EXC, REG_TR.sel.value & SELECTOR_RPL_MASK);
+			g_cpu.raise(CPU_TS_EXC, REG_TR.sel.value & SELECTOR_RPL_MASK);
 		}
 		ss_  = read_word(REG_TR.desc.base + TSSstackaddr + 4);
 		esp_ = read_dword(REG_TR.desc.base + TSSstackaddr);
@@ -55,6 +55,7 @@ void CPUExecutor::switch_tasks_load_selector(SegReg &_seg, uint8_t _cs_rpl)
 	// NULL selector is OK, will leave cache invalid
 	if((_seg.sel.value & SELECTOR_RPL_MASK) != 0) {
 		try {
+			CPUFaultScope fault_scope;
 			descriptor = fetch_descriptor(_seg.sel, CPU_TS_EXC);
 		} catch (CPUException &e) {
 			PERRF(LOG_CPU,"switch_tasks(%s): bad selector fetch\n", _seg.to_string());
@@ -64,7 +65,7 @@ void CPUExecutor::switch_tasks_load_selector(SegReg &_seg, uint8_t _cs_rpl)
 		/* AR byte must indicate data or readable code segment else #TS(selector) */
 		if(!descriptor.segment || (descriptor.is_code_segment() && !descriptor.is_readable())) {
 			PERRF(LOG_CPU,"switch_tasks(%s): not data or readable code\n", _seg.to_string());
-			throw CPUException(CPU_TS_EXC, _seg.sel.value & SELECTOR_RPL_MASK);
+			g_cpu.raise(CPU_TS_EXC, _seg.sel.value & SELECTOR_RPL_MASK);
 		}
 
 		/* If data or non-conforming code, then both the RPL and the CPL
@@ -72,13 +73,13 @@ void CPUExecutor::switch_tasks_load_selector(SegReg &_seg, uint8_t _cs_rpl)
 		if(descriptor.is_data_segment() || !descriptor.is_conforming()) {
 			if((_seg.sel.rpl > descriptor.dpl) || (_cs_rpl > descriptor.dpl)) {
 				PERRF(LOG_CPU,"switch_tasks(%s): RPL & CPL must be <= DPL\n", _seg.to_string());
-				throw CPUException(CPU_TS_EXC, _seg.sel.value & SELECTOR_RPL_MASK);
+				g_cpu.raise(CPU_TS_EXC, _seg.sel.value & SELECTOR_RPL_MASK);
 			}
 		}
 
 		if(!descriptor.present) {
 			PERRF(LOG_CPU,"switch_tasks(%s): descriptor not present\n", _seg.to_string());
-			throw CPUException(CPU_TS_EXC, _seg.sel.value & SELECTOR_RPL_MASK);
+			g_cpu.raise(CPU_TS_EXC, _seg.sel.value & SELECTOR_RPL_MASK);
 		}
 
 		touch_segment(_seg.sel, descriptor);
@@ -93,6 +94,9 @@ void CPUExecutor::switch_tasks(Selector &selector, Descriptor &descriptor,
 {
 	PDEBUGF(LOG_V2,LOG_CPU,"TASKING: ENTER\n");
 
+	// the new task can have a different LDT
+	desc_cache_flush();
+
 	// Discard any traps and inhibits for new context; traps will
 	// resume upon return.
 	g_cpu.clear_inhibit_mask();
@@ -122,7 +126,7 @@ void CPUExecutor::switch_tasks(Selector &selector, Descriptor &descriptor,
 
 	if(new_TSS_limit < new_TSS_max) {
 		PERRF(LOG_CPU,"switch_tasks(): new TSS limit < %d\n", new_TSS_max);
-		throw CPUException(CPU_TS_EXC, selector.value & SELECTOR_RPL_MASK);
+		g_cpu.raise(CPU_TS_EXC, selector.value & SELECTOR_RPL_MASK);
 	}
 
 	uint32_t old_TSS_max;
@@ -137,7 +141,7 @@ void CPUExecutor::switch_tasks(Selector &selector, Descriptor &descriptor,
 
 	if(old_TSS_limit < old_TSS_max) {
 		PERRF(LOG_CPU,"switch_tasks(): old TSS limit < %d\n", old_TSS_max);
-		throw CPUException(CPU_TS_EXC, REG_TR.sel.value & SELECTOR_RPL_MASK);
+		g_cpu.raise(CPU_TS_EXC, REG_TR.sel.value & SELECTOR_RPL_MASK);
 	}
 
 	if(obase32 == nbase32) {
@@ -406,13 +410,14 @@ void CPUExecutor::switch_tasks(Selector &selector, Descriptor &descriptor,
 	if(REG_LDTR.sel.ti) {
 		// LDT selector must be in GDT
 		PINFOF(LOG_V2,LOG_CPU,"switch_tasks(exception after commit point): bad LDT selector TI=1\n");
-		throw CPUException(CPU_TS_EXC, raw_ldt_selector & SELECTOR_RPL_MASK);
+		g_cpu.raise(CPU_TS_EXC, raw_ldt_selector & SELECTOR_RPL_MASK);
 	}
 
 	Descriptor cs_descriptor, ss_descriptor, ldt_descriptor;
 
 	if((raw_ldt_selector & SELECTOR_RPL_MASK) != 0) {
 		try {
+			CPUFaultScope fault_scope;
 			ldt_descriptor = fetch_descriptor(REG_LDTR.sel, CPU_TS_EXC);
 		} catch(CPUException &e) {
 			PERRF(LOG_CPU, "switch_tasks(exception after commit point): bad LDT fetch\n");
@@ -425,13 +430,13 @@ void CPUExecutor::switch_tasks(Selector &selector, Descriptor &descriptor,
 			ldt_descriptor.segment)
 		{
 			PERRF(LOG_CPU, "switch_tasks(exception after commit point): bad LDT segment\n");
-			throw CPUException(CPU_TS_EXC, raw_ldt_selector & SELECTOR_RPL_MASK);
+			g_cpu.raise(CPU_TS_EXC, raw_ldt_selector & SELECTOR_RPL_MASK);
 		}
 
 		// LDT of new task is present in memory, else #TS(new tasks's LDT)
 		if(ldt_descriptor.present == false) {
 			PERRF(LOG_CPU, "switch_tasks(exception after commit point): LDT not present\n");
-			throw CPUException(CPU_TS_EXC, raw_ldt_selector & SELECTOR_RPL_MASK);
+			g_cpu.raise(CPU_TS_EXC, raw_ldt_selector & SELECTOR_RPL_MASK);
 		}
 
 		// All checks pass, fill in LDTR shadow cache
@@ -454,6 +459,7 @@ void CPUExecutor::switch_tasks(Selector &selector, Descriptor &descriptor,
 		// SS
 		if((raw_ss_selector & SELECTOR_RPL_MASK) != 0) {
 			try {
+				CPUFaultScope fault_scope;
 				ss_descriptor = fetch_descriptor(REG_SS.sel, CPU_TS_EXC);
 			} catch(CPUException &e) {
 				PERRF(LOG_CPU, "switch_tasks(exception after commit point): bad SS fetch\n");
@@ -467,25 +473,25 @@ void CPUExecutor::switch_tasks(Selector &selector, Descriptor &descriptor,
 			   !ss_descriptor.is_writeable())
 			{
 				PERRF(LOG_CPU,"switch_tasks(exception after commit point): SS not valid or writeable segment\n");
-				throw CPUException(CPU_TS_EXC, raw_ss_selector & SELECTOR_RPL_MASK);
+				g_cpu.raise(CPU_TS_EXC, raw_ss_selector & SELECTOR_RPL_MASK);
 			}
 
 			// Stack segment is present in memory, else #SS(new stack segment)
 			if(ss_descriptor.present == false) {
 				PERRF(LOG_CPU,"switch_tasks(exception after commit point): SS not present\n");
-				throw CPUException(CPU_SS_EXC, raw_ss_selector & SELECTOR_RPL_MASK);
+				g_cpu.raise(CPU_SS_EXC, raw_ss_selector & SELECTOR_RPL_MASK);
 			}
 
 			// Stack segment DPL matches CS.RPL, else #TS(new stack segment)
 			if(ss_descriptor.dpl != save_CPL) {
 				PERRF(LOG_CPU,"switch_tasks(exception after commit point): SS.rpl != CS.RPL\n");
-				throw CPUException(CPU_TS_EXC, raw_ss_selector & SELECTOR_RPL_MASK);
+				g_cpu.raise(CPU_TS_EXC, raw_ss_selector & SELECTOR_RPL_MASK);
 			}
 
 			// Stack segment DPL matches selector RPL, else #TS(new stack segment)
 			if(ss_descriptor.dpl != REG_SS.sel.rpl) {
 				PERRF(LOG_CPU,"switch_tasks(exception after commit point): SS.dpl != SS.rpl\n");
-				throw CPUException(CPU_TS_EXC, raw_ss_selector & SELECTOR_RPL_MASK);
+				g_cpu.raise(CPU_TS_EXC, raw_ss_selector & SELECTOR_RPL_MASK);
 			}
 
 			touch_segment(REG_SS.sel, ss_descriptor);
@@ -495,7 +501,7 @@ void CPUExecutor::switch_tasks(Selector &selector, Descriptor &descriptor,
 		} else {
 			// SS selector is valid, else #TS(new stack segment)
 			PERRF(LOG_CPU,"switch_tasks(exception after commit point): SS NULL\n");
-			throw CPUException(CPU_TS_EXC, raw_ss_selector & SELECTOR_RPL_MASK);
+			g_cpu.raise(CPU_TS_EXC, raw_ss_selector & SELECTOR_RPL_MASK);
 		}
 
 		CPL = save_CPL;
@@ -517,6 +523,7 @@ void CPUExecutor::switch_tasks(Selector &selector, Descriptor &descriptor,
 		// CS
 		if((raw_cs_selector & SELECTOR_RPL_MASK) != 0) {
 			try {
+				CPUFaultScope fault_scope;
 				cs_descriptor = fetch_descriptor(REG_CS.sel, CPU_TS_EXC);
 			} catch(CPUException &e) {
 				PERRF(LOG_CPU, "switch_tasks(exception after commit point): bad CS fetch\n");
@@ -526,25 +533,25 @@ void CPUExecutor::switch_tasks(Selector &selector, Descriptor &descriptor,
 			// CS descriptor AR byte must indicate code segment else #TS(CS)
 			if(!cs_descriptor.valid || !cs_descriptor.is_code_segment()) {
 				PERRF(LOG_CPU,"switch_tasks(exception after commit point): CS not valid executable seg\n");
-				throw CPUException(CPU_TS_EXC, raw_cs_selector & SELECTOR_RPL_MASK);
+				g_cpu.raise(CPU_TS_EXC, raw_cs_selector & SELECTOR_RPL_MASK);
 			}
 
 			// if non-conforming then DPL must equal selector RPL else #TS(CS)
 			if(!cs_descriptor.is_conforming() && cs_descriptor.dpl != REG_CS.sel.rpl) {
 				PERRF(LOG_CPU,"switch_tasks(exception after commit point): non-conforming: CS.dpl!=CS.RPL\n");
-				throw CPUException(CPU_TS_EXC, raw_cs_selector & SELECTOR_RPL_MASK);
+				g_cpu.raise(CPU_TS_EXC, raw_cs_selector & SELECTOR_RPL_MASK);
 			}
 
 			// if conforming then DPL must be <= selector RPL else #TS(CS)
 			if(cs_descriptor.is_conforming() && cs_descriptor.dpl > REG_CS.sel.rpl) {
 				PERRF(LOG_CPU,"switch_tasks(exception after commit point): conforming: CS.dpl>RPL\n");
-				throw CPUException(CPU_TS_EXC, raw_cs_selector & SELECTOR_RPL_MASK);
+				g_cpu.raise(CPU_TS_EXC, raw_cs_selector & SELECTOR_RPL_MASK);
 			}
 
 			// Code segment is present in memory, else #NP(new code segment)
 			if(!cs_descriptor.present) {
 				PERRF(LOG_CPU,"switch_tasks(exception after commit point): CS.p==0\n");
-				throw CPUException(CPU_NP_EXC, raw_cs_selector & SELECTOR_RPL_MASK);
+				g_cpu.raise(CPU_NP_EXC, raw_cs_selector & SELECTOR_RPL_MASK);
 			}
 
 			touch_segment(REG_CS.sel, cs_descriptor);
@@ -555,7 +562,7 @@ void CPUExecutor::switch_tasks(Selector &selector, Descriptor &descriptor,
 		} else {
 			// If new cs selector is null #TS(CS)
 			PERRF(LOG_CPU,"switch_tasks(exception after commit point): CS NULL\n");
-			throw CPUException(CPU_TS_EXC, raw_cs_selector & SELECTOR_RPL_MASK);
+			g_cpu.raise(CPU_TS_EXC, raw_cs_selector & SELECTOR_RPL_MASK);
 		}
 	}
 
@@ -582,7 +589,7 @@ void CPUExecutor::switch_tasks(Selector &selector, Descriptor &descriptor,
 	// instruction pointer must be in CS limit, else #GP(0)
 	if(REG_EIP > REG_CS.desc.limit) {
 		PERRF(LOG_CPU,"switch_tasks: EIP > CS.limit\n");
-		throw CPUException(CPU_GP_EXC, 0);
+		g_cpu.raise(CPU_GP_EXC, 0);
 	}
 
 	g_cpubus.invalidate_pq();
@@ -596,7 +603,7 @@ void CPUExecutor::task_gate(Selector &selector, Descriptor &gate_descriptor, uns
 	// task gate must be present else #NP(gate selector)
 	if(!gate_descriptor.present) {
 		PERRF(LOG_CPU,"task_gate: task gate not present");
-		throw CPUException(CPU_NP_EXC, selector.value & SELECTOR_RPL_MASK);
+		g_cpu.raise(CPU_NP_EXC, selector.value & SELECTOR_RPL_MASK);
 	}
 
 	// examine selector to TSS, given in Task Gate descriptor
@@ -605,7 +612,7 @@ void CPUExecutor::task_gate(Selector &selector, Descriptor &gate_descriptor, uns
 
 	if(tss_selector.ti) {
 		PERRF(LOG_CPU,"task_gate: tss_selector.ti=1\n");
-		throw CPUException(CPU_GP_EXC, tss_selector.value & SELECTOR_RPL_MASK);
+		g_cpu.raise(CPU_GP_EXC, tss_selector.value & SELECTOR_RPL_MASK);
 	}
 
 	// index must be within GDT limits else #GP(TSS selector)
@@ -613,7 +620,7 @@ void CPUExecutor::task_gate(Selector &selector, Descriptor &gate_descriptor, uns
 
 	if(!tss_descriptor.valid || tss_descriptor.segment) {
 		PERRF(LOG_CPU,"task_gate: TSS selector points to bad TSS\n");
-		throw CPUException(CPU_GP_EXC, tss_selector.value & SELECTOR_RPL_MASK);
+		g_cpu.raise(CPU_GP_EXC, tss_selector.value & SELECTOR_RPL_MASK);
 	}
 	// descriptor AR byte must specify available TSS
 	//   else #GP(TSS selector)
@@ -621,13 +628,13 @@ void CPUExecutor::task_gate(Selector &selector, Descriptor &gate_descriptor, uns
 	   tss_descriptor.type != DESC_TYPE_AVAIL_386_TSS)
 	{
 		PERRF(LOG_CPU,"task_gate: TSS selector points to bad TSS\n");
-		throw CPUException(CPU_GP_EXC, tss_selector.value & SELECTOR_RPL_MASK);
+		g_cpu.raise(CPU_GP_EXC, tss_selector.value & SELECTOR_RPL_MASK);
 	}
 
 	// task state segment must be present, else #NP(tss selector)
 	if(!tss_descriptor.present) {
 		PERRF(LOG_CPU,"task_gate: TSS descriptor.p == 0\n");
-		throw CPUException(CPU_NP_EXC, tss_selector.value & SELECTOR_RPL_MASK);
+		g_cpu.raise(CPU_NP_EXC, tss_selector.value & SELECTOR_RPL_MASK);
 	}
 
 	// SWITCH_TASKS _without_ nesting to TSS
@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2018  Marco Bortolin
+ *
+ * This file is part of IBMulator.
+ *
+ * IBMulator is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * IBMulator is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with IBMulator.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ibmulator.h"
+#include "icache.h"
+#include "core.h"
+#include "mmu.h"
+#include "../memory.h"
+#include <cstring>
+
+CPUICache g_cpuicache;
+
+
+CPUICache::CPUICache()
+: m_entries(nullptr)
+{
+}
+
+CPUICache::~CPUICache()
+{
+	delete[] m_entries;
+}
+
+void CPUICache::init()
+{
+	if(!m_entries) {
+		m_entries = new Entry[ICACHE_SIZE];
+	}
+	memset(m_entries, 0, sizeof(Entry) * ICACHE_SIZE);
+	// generation 0 is never valid, so empty entries will never be hit
+	for(unsigned p=0; p<ICACHE_PAGES; p++) {
+		m_page_gen[p] = 1;
+		m_code_page[p] = false;
+	}
+}
+
+void CPUICache::flush()
+{
+	/* this function can be called by Memory before init(), it must only
+	 * operate on the pages arrays.
+	 */
+	for(unsigned p=0; p<ICACHE_PAGES; p++) {
+		if(m_code_page[p]) {
+			invalidate_page(p);
+		}
+	}
+}
+
+bool CPUICache::get_phyaddr(uint32_t _cseip, uint32_t &phy_)
+{
+	if(IS_PAGING()) {
+		// never walk the page tables, the bus will do it when fetching
+		if(!g_cpummu.TLB_peek(_cseip, phy_)) {
+			return false;
+		}
+	} else {
+		phy_ = _cseip;
+	}
+	phy_ &= g_memory.get_address_mask();
+	return true;
+}
+
+bool CPUICache::lookup(uint32_t _cseip, bool _big, Instruction &instr_)
+{
+	Entry &e = entry(_cseip);
+	if(e.cseip != _cseip || e.big != _big) {
+		return false;
+	}
+	uint32_t phy;
+	if(!get_phyaddr(_cseip, phy) || e.phy != phy) {
+		return false;
+	}
+	if(e.gen != m_page_gen[(phy & (MAX_MEM_SIZE-1)) >> ICACHE_PAGE_SHIFT]) {
+		return false;
+	}
+	instr_ = e.instr;
+	return true;
+}
+
+void CPUICache::insert(const Instruction &_instr, bool _big)
+{
+	if(!m_entries) {
+		return;
+	}
+	uint32_t phy;
+	if(!get_phyaddr(_instr.cseip, phy)) {
+		return;
+	}
+	uint32_t last = phy + _instr.size - 1;
+	if((phy >> ICACHE_PAGE_SHIFT) != (last >> ICACHE_PAGE_SHIFT)) {
+		// instructions crossing a page boundary are not cached
+		return;
+	}
+	if(_instr.size > CPU_MAX_INSTR_SIZE || !g_memory.is_code_cacheable(phy)) {
+		return;
+	}
+	/* The instruction could have been decoded from stale prefetch queue bytes
+	 * (code modified after it has been prefetched). Cache it only if its bytes
+	 * are those currently in memory.
+	 */
+	for(unsigned i=0; i<_instr.size; i++) {
+		if(_instr.bytes[i] != g_memory.dbg_read_byte(phy+i)) {
+			return;
+		}
+	}
+	unsigned page = (phy & (MAX_MEM_SIZE-1)) >> ICACHE_PAGE_SHIFT;
+	Entry &e = entry(_instr.cseip);
+	e.cseip = _instr.cseip;
+	e.phy = phy;
+	e.gen = m_page_gen[page];
+	e.big = _big;
+	e.instr = _instr;
+	m_code_page[page] = true;
+}
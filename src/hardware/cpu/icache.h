@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2018  Marco Bortolin
+ *
+ * This file is part of IBMulator.
+ *
+ * IBMulator is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * IBMulator is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with IBMulator.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef IBMULATOR_CPU_ICACHE_H
+#define IBMULATOR_CPU_ICACHE_H
+
+#include "decoder.h"
+
+class CPUICache;
+extern CPUICache g_cpuicache;
+
+#define ICACHE_SIZE       0x4000 // number of decoded instructions (direct mapped)
+#define ICACHE_PAGE_SHIFT 12
+#define ICACHE_PAGES      (MAX_MEM_SIZE >> ICACHE_PAGE_SHIFT)
+
+/* Decoded instructions cache.
+ * Instructions are indexed by their linear CS:EIP address, but every entry
+ * remembers the physical address it was decoded from, so that a change in
+ * the paging translation or a write into the physical page will invalidate
+ * it. Pages are invalidated in O(1) by incrementing their generation number.
+ * The prefetch queue is always updated as if the instruction was decoded
+ * (see CPUBus::skip()), so the bus timings are not affected.
+ */
+class CPUICache
+{
+private:
+	struct Entry {
+		uint32_t cseip;   // the linear address of the instruction
+		uint32_t phy;     // the physical address of the instruction
+		uint32_t gen;     // the generation of the physical page
+		bool     big;     // the CS default operand/address size
+		Instruction instr;
+	};
+
+	Entry   *m_entries;
+	uint32_t m_page_gen[ICACHE_PAGES];
+	bool     m_code_page[ICACHE_PAGES];
+
+public:
+	CPUICache();
+	~CPUICache();
+
+	void init();
+	void flush();
+
+	bool lookup(uint32_t _cseip, bool _big, Instruction &instr_);
+	void insert(const Instruction &_instr, bool _big);
+
+	// the generation number of a physical page, changes when the page is written
+	inline const uint32_t * page_gen(uint32_t _phy) const {
+		return &m_page_gen[(_phy & (MAX_MEM_SIZE-1)) >> ICACHE_PAGE_SHIFT];
+	}
+	// the generation of a page will change when the page is written
+	inline const uint32_t * watch_page(uint32_t _phy) {
+		unsigned page = (_phy & (MAX_MEM_SIZE-1)) >> ICACHE_PAGE_SHIFT;
+		m_code_page[page] = true;
+		return &m_page_gen[page];
+	}
+
+	// to be called for every write to physical memory
+	inline void write_notify(uint32_t _phy, unsigned _len) {
+		unsigned p0 = (_phy & (MAX_MEM_SIZE-1)) >> ICACHE_PAGE_SHIFT;
+		unsigned p1 = ((_phy + _len - 1) & (MAX_MEM_SIZE-1)) >> ICACHE_PAGE_SHIFT;
+		if(UNLIKELY(m_code_page[p0])) {
+			invalidate_page(p0);
+		}
+		if(UNLIKELY(m_code_page[p1])) {
+			invalidate_page(p1);
+		}
+	}
+
+private:
+	inline void invalidate_page(unsigned _page) {
+		m_page_gen[_page]++;
+		m_code_page[_page] = false;
+	}
+	inline Entry & entry(uint32_t _cseip) {
+		return m_entries[(_cseip ^ (_cseip >> 14)) & (ICACHE_SIZE-1)];
+	}
+	bool get_phyaddr(uint32_t _cseip, uint32_t &phy_);
+};
+
+#endif
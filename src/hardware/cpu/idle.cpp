@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2018  Marco Bortolin
+ *
+ * This file is part of IBMulator.
+ *
+ * IBMulator is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * IBMulator is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with IBMulator.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ibmulator.h"
+#include "program.h"
+#include "idle.h"
+#include "core.h"
+#include "hardware/cpu.h"
+#include "hardware/memory.h"
+#include <algorithm>
+#include <sstream>
+
+CPUIdleDetector g_cpuidle;
+
+
+CPUIdleDetector::CPUIdleDetector()
+: m_enabled(false),
+  m_active(false),
+  m_polls(0),
+  m_last_poll(0),
+  m_skip(false),
+  m_skipped(0),
+  m_int16_ret(IDLE_NO_RET),
+  m_int16_icount(0)
+{
+}
+
+void CPUIdleDetector::reset()
+{
+	m_polls = 0;
+	m_last_poll = 0;
+	m_skip = false;
+	m_int16_ret = IDLE_NO_RET;
+}
+
+void CPUIdleDetector::config_changed()
+{
+	m_enabled = g_program.config().get_bool(CPU_SECTION, CPU_IDLE_DETECT, true);
+
+	m_excluded.clear();
+	std::string list = g_program.config().get_string(CPU_SECTION, CPU_IDLE_EXCLUDE, "");
+	std::replace(list.begin(), list.end(), ',', ' ');
+	std::istringstream ss(list);
+	std::string name;
+	while(ss >> name) {
+		m_excluded.insert(program_basename(name.c_str()));
+	}
+
+	PINFOF(LOG_V1, LOG_CPU, "  Idle detection: %s\n", m_enabled?"yes":"no");
+
+	m_active = m_enabled;
+	reset();
+}
+
+std::string CPUIdleDetector::program_basename(const char *_name)
+{
+	std::string name(_name);
+	size_t pos = name.find_last_of("\\/:");
+	if(pos != std::string::npos) {
+		name = name.substr(pos + 1);
+	}
+	std::transform(name.begin(), name.end(), name.begin(), ::toupper);
+	return name;
+}
+
+void CPUIdleDetector::program_changed(const char *_name)
+{
+	bool excluded = m_excluded.count(program_basename(_name));
+	if(m_enabled && excluded == m_active) {
+		PDEBUGF(LOG_V1, LOG_CPU, "idle detection %s for '%s'\n",
+				excluded?"disabled":"enabled", _name);
+	}
+	m_active = m_enabled && !excluded;
+	m_polls = 0;
+	m_skip = false;
+	// the return of the previous program may never be reached
+	m_int16_ret = IDLE_NO_RET;
+}
+
+void CPUIdleDetector::poll(bool _empty)
+{
+	if(!m_active) {
+		return;
+	}
+	uint64_t icount = g_cpu.get_icount();
+	if(!_empty || icount - m_last_poll > IDLE_MAX_INSTR) {
+		// something happened or the program is busy doing something else
+		m_polls = 0;
+	}
+	m_last_poll = icount;
+	if(_empty && ++m_polls >= IDLE_MIN_POLLS) {
+		m_skip = true;
+	}
+}
+
+void CPUIdleDetector::INT_call(uint8_t _vector, uint8_t _ah, uint32_t _retaddr)
+{
+	if(!m_active) {
+		return;
+	}
+	if(_vector == 0x28) {
+		// DOS IDLE INTERRUPT
+		poll(true);
+	} else if(_vector == 0x16 && (_ah == 0x01 || _ah == 0x11)) {
+		// CHECK FOR KEYSTROKE, the result is known at the return
+		m_int16_ret = _retaddr;
+		m_int16_icount = g_cpu.get_icount();
+	}
+}
+
+void CPUIdleDetector::INT16_ret()
+{
+	m_int16_ret = IDLE_NO_RET;
+	if(g_cpu.get_icount() - m_int16_icount > IDLE_MAX_INSTR) {
+		// too late, this is not the return of a keyboard poll
+		return;
+	}
+	// ZF set if no keystroke available
+	poll(g_cpucore.get_FLAGS(FMASK_ZF));
+}
+
+void CPUIdleDetector::BDA_read()
+{
+	uint16_t head = g_memory.dbg_read_word(IDLE_BDA_KBPTR);
+	uint16_t tail = g_memory.dbg_read_word(IDLE_BDA_KBPTR + 2);
+	poll(head == tail);
+}
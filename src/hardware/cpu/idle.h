@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2018  Marco Bortolin
+ *
+ * This file is part of IBMulator.
+ *
+ * IBMulator is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * IBMulator is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with IBMulator.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef IBMULATOR_CPU_IDLE_H
+#define IBMULATOR_CPU_IDLE_H
+
+#include <set>
+#include <string>
+
+class CPUCore;
+class Memory;
+class CPUIdleDetector;
+extern CPUIdleDetector g_cpuidle;
+
+#define IDLE_MIN_POLLS 16   // consecutive polls before the guest is considered idle
+#define IDLE_MAX_INSTR 2000 // max number of instructions between two polls
+#define IDLE_NO_RET    0xFFFFFFFF // no INT 16h return pending
+#define IDLE_BDA_KBPTR 0x41A      // keyboard buffer head and tail pointers
+
+/* Guest idle-loop detector.
+ * Most DOS programs don't HLT while waiting for input, they poll the keyboard
+ * with INT 16h AH=01h/11h, call the DOS idle interrupt INT 28h, or compare the
+ * head and tail pointers of the BIOS keyboard buffer at 40:1Ah/40:1Ch. When
+ * enough polls happen close to each other and find nothing, the CPU spends the
+ * cycles until the next timer in one step (see CPU::step()), as nothing can
+ * change before a device raises an interrupt.
+ * The executor calls the detector directly (see INT() and execute()) instead
+ * of using the debugging INT and memory traps, so that release builds don't
+ * pay for them: only one INT 16h return can be pending and it's dropped when
+ * it's not reached soon or the program changes.
+ */
+class CPUIdleDetector
+{
+private:
+	bool m_enabled;         // from the ini file
+	bool m_active;          // enabled and the current program is not excluded
+	std::set<std::string> m_excluded;
+
+	unsigned m_polls;       // consecutive empty polls
+	uint64_t m_last_poll;   // the instruction count of the last poll
+	bool m_skip;            // the CPU can skip to the next timer
+	uint64_t m_skipped;     // total number of skipped cycles
+	uint32_t m_int16_ret;   // linear return address of the pending INT 16h
+	uint64_t m_int16_icount;// the instruction count of the INT 16h call
+
+public:
+	CPUIdleDetector();
+
+	void reset();
+	void config_changed();
+	void program_changed(const char *_name);
+
+	// called by the CPU after every instruction
+	inline bool skip_requested() const { return m_skip; }
+	inline void skip_done(int _cycles) { m_skip = false; m_skipped += _cycles; }
+	inline uint64_t skipped_cycles() const { return m_skipped; }
+
+	// called by the executor
+	void INT_call(uint8_t _vector, uint8_t _ah, uint32_t _retaddr);
+	inline uint32_t INT_pending_ret() const { return m_int16_ret; }
+	void INT16_ret();
+	void BDA_read();
+
+private:
+	void poll(bool _empty);
+
+	static std::string program_basename(const char *_name);
+};
+
+#endif
@@ -21,9 +21,24 @@
 #include "hardware/cpu.h"
 #include "mmu.h"
 #include "bus.h"
+#include "icache.h"
+#include <cstring>
 
 CPUMMU g_cpummu;
 
+
+CPUMMU::CPUMMU()
+: m_TLB_gen(1),
+  m_host_TLB_gen(1)
+{
+	// generation 0 is never valid
+	memset(m_TLB, 0, sizeof(m_TLB));
+	memset(m_host_TLB, 0, sizeof(m_host_TLB));
+	memset(m_PDE_cache, 0, sizeof(m_PDE_cache));
+	m_stats.flushes = 0;
+	m_stats.misses = 0;
+}
+
 #define PF_NOT_PRESENT  0x00
 #define PF_PROTECTION   0x01
 
@@ -45,7 +60,7 @@ void CPUMMU::page_fault(unsigned _prot, uint32_t _linear, bool _user, bool _writ
 		PDEBUGF(LOG_V2, LOG_MMU, "#PF at %08X, not present, %s, %s\n", _linear,
 			(_user)?"user":"supervisor", (_write)?"write":"read");
 	}
-	throw CPUException(CPU_PF_EXC, error_code);
+	g_cpu.raise(CPU_PF_EXC, error_code);
 }
 
 void CPUMMU::protection_check(unsigned _prot, uint32_t _linear, bool _write)
@@ -85,6 +100,8 @@ void CPUMMU::TLB_miss(uint32_t _linear, TLBEntry *_tlbent, bool _user, bool _wri
 
 	PDEBUGF(LOG_V2, LOG_MMU, "Page tables lookup for 0x%08x\n", _linear);
 
+	m_stats.misses++;
+
 	/*
 	Page Directory/Table Entry (PDE, PTE)
 	31                                   12 11          6 5     2 1 0
@@ -122,9 +139,16 @@ void CPUMMU::TLB_miss(uint32_t _linear, TLBEntry *_tlbent, bool _user, bool _wri
 	 */
 
 	// Read tables from memory
+	int pde_cycles = -1;
 	for(int table = PDIR; table>=PTBL; --table) {
 		entry_addr[table] = ppf + ((_linear >> (10 + 10*table)) & 0xFFC);
-		entry[table] = g_cpubus.mem_read<4>(entry_addr[table]);
+		if(table != PDIR || !PDE_cache_lookup(entry_addr[PDIR], entry[PDIR])) {
+			int c = g_cpubus.mem_r_cycles();
+			entry[table] = g_cpubus.mem_read<4>(entry_addr[table]);
+			if(table == PDIR) {
+				pde_cycles = g_cpubus.mem_r_cycles() - c;
+			}
+		}
 		if(!(entry[table] & 0x1)) {
 			// Raise not-present #PF
 			page_fault(PF_NOT_PRESENT, _linear, _user, _write);
@@ -141,13 +165,18 @@ void CPUMMU::TLB_miss(uint32_t _linear, TLBEntry *_tlbent, bool _user, bool _wri
 	// Update TLB entry
 	_tlbent->lpf = LPF_OF(_linear);
 	_tlbent->ppf = ppf;
+	_tlbent->gen = m_TLB_gen;
 	_tlbent->access |= _write | (_user<<1);
 
 	PDEBUGF(LOG_V2, LOG_MMU, "  %s %s access, page 0x%08x\n",
 			(_user?"user":"super"), (_write?"w":"r"), _tlbent->ppf);
 
 	// Update PDE A bit
-	if(!(entry[PDIR] & PAGE_ACCESSED)) {
+	if(entry[PDIR] & PAGE_ACCESSED) {
+		if(pde_cycles >= 0) {
+			PDE_cache_insert(entry_addr[PDIR], entry[PDIR], pde_cycles);
+		}
+	} else {
 		entry[PDIR] |= PAGE_ACCESSED;
 		g_cpubus.mem_write<4>(entry_addr[PDIR], entry[PDIR]);
 		PDEBUGF(LOG_V2, LOG_MMU, "Updating PDE %04x A bit, page 0x%08x at 0x%08x (0x%08x)\n",
@@ -178,7 +207,7 @@ uint32_t CPUMMU::TLB_lookup(uint32_t _linear, unsigned _len, bool _user, bool _w
 	*/
 
 	// check if TLB has page entry
-	if(tlbent->lpf == LPF_OF(_linear)) {
+	if(tlbent->lpf == LPF_OF(_linear) && tlbent->gen == m_TLB_gen) {
 		// check TLB bits for access, allow if:
 		//  on read: is supervisor or there was previous successful user access
 		//  on write: is supervisor or there was previous successful user access AND
@@ -189,6 +218,8 @@ uint32_t CPUMMU::TLB_lookup(uint32_t _linear, unsigned _len, bool _user, bool _w
 		}
 	} else {
 		tlbent->access = 0;
+		// the translation of the evicted page must be walked again
+		m_host_TLB[TLB_index(_linear, _len-1)].gen = 0;
 	}
 	// re-walk page tables and raise faults if necessary
 	TLB_miss(_linear, tlbent, _user, _write);
@@ -204,8 +235,97 @@ void CPUMMU::TLB_check(uint32_t _linear, bool _user, bool _write)
 
 void CPUMMU::TLB_flush()
 {
-	for(unsigned n=0; n<TLB_SIZE; n++) {
-		m_TLB[n].lpf = -1;
+	m_stats.flushes++;
+	if(UNLIKELY(++m_TLB_gen == 0)) {
+		memset(m_TLB, 0, sizeof(m_TLB));
+		m_TLB_gen = 1;
+	}
+	host_TLB_flush();
+}
+
+bool CPUMMU::PDE_cache_lookup(uint32_t _addr, uint32_t &pde_)
+{
+	PDECacheEntry &e = PDE_cache_entry(_addr);
+	if(e.addr != _addr || e.gen != m_TLB_gen
+	|| e.page_gen != *g_cpuicache.page_gen(_addr & g_memory.get_address_mask()))
+	{
+		return false;
+	}
+	pde_ = e.pde;
+	// the bus timings are the same of a memory read
+	g_cpubus.add_mem_r_cycles(e.cycles);
+	return true;
+}
+
+void CPUMMU::PDE_cache_insert(uint32_t _addr, uint32_t _pde, int _cycles)
+{
+	// entries in memory with traps or in devices memory are never cached
+	if(!g_memory.get_ram_page(_addr, false)) {
+		return;
+	}
+	PDECacheEntry &e = PDE_cache_entry(_addr);
+	e.addr = _addr;
+	e.pde = _pde;
+	e.gen = m_TLB_gen;
+	e.page_gen = *g_cpuicache.watch_page(_addr & g_memory.get_address_mask());
+	e.cycles = _cycles;
+}
+
+void CPUMMU::host_TLB_fill(uint32_t _linear, uint32_t _phy)
+{
+	/* To be called after a successful translation of _linear.
+	 * With paging enabled the allowed accesses are the same that TLB_lookup()
+	 * would let through without a page walk, so the A and D bits of the page
+	 * tables are always updated by the normal path.
+	 */
+	unsigned access = HTLB_READ | HTLB_WRITE;
+	if(IS_PAGING()) {
+		const TLBEntry *tlbent = &m_TLB[TLB_index(_linear, 0)];
+		if(tlbent->lpf != LPF_OF(_linear) || tlbent->gen != m_TLB_gen) {
+			return;
+		}
+		access = HTLB_ACCESS(0,0);
+		if(tlbent->access & 2) {
+			access |= HTLB_ACCESS(1,0);
+		}
+		if(tlbent->access & 1) {
+			access |= HTLB_ACCESS(0,1);
+			if(tlbent->access & 2) {
+				access |= HTLB_ACCESS(1,1);
+			}
+		}
+	}
+	HostTLBEntry *e = &m_host_TLB[TLB_index(_linear, 0)];
+	if(e->lpf == LPF_OF(_linear) && e->gen == m_host_TLB_gen
+	&& e->ppf == LPF_OF(_phy) && e->prot == access)
+	{
+		// already filled, the missing accesses are not to RAM
+		return;
+	}
+	e->lpf = LPF_OF(_linear);
+	e->ppf = LPF_OF(_phy);
+	e->prot = access;
+	e->gen = m_host_TLB_gen;
+
+	uint8_t *host = g_memory.get_ram_page(_phy, false);
+	if(!host) {
+		access &= ~HTLB_READ;
+	}
+	uint8_t *whost = g_memory.get_ram_page(_phy, true);
+	if(!whost || (host && whost != host)) {
+		access &= ~HTLB_WRITE;
+	} else {
+		host = whost;
+	}
+	e->access = access;
+	e->host = access ? host : nullptr;
+}
+
+void CPUMMU::host_TLB_flush()
+{
+	if(UNLIKELY(++m_host_TLB_gen == 0)) {
+		memset(m_host_TLB, 0, sizeof(m_host_TLB));
+		m_host_TLB_gen = 1;
 	}
 }
 
@@ -26,6 +26,7 @@ extern CPUMMU g_cpummu;
 
 
 #define TLB_SIZE 1024 // number of entries in the TLB
+#define PDE_CACHE_SIZE 32 // number of entries in the page directory entries cache
 
 #define LPF_MASK           0xFFFFF000
 #define LPF_OF(laddr)      ((laddr) & LPF_MASK)
@@ -33,22 +34,102 @@ extern CPUMMU g_cpummu;
 #define PAGE_DIR_ENTRY(laddr) ((laddr>>22) & 0x3FF)
 #define PAGE_TBL_ENTRY(laddr) ((laddr>>12) & 0x3FF)
 
+// host TLB access bits, one for every combination of user and write access
+#define HTLB_ACCESS(user,write) (1 << ((write) | ((user)<<1)))
+#define HTLB_READ  (HTLB_ACCESS(0,0) | HTLB_ACCESS(1,0))
+#define HTLB_WRITE (HTLB_ACCESS(0,1) | HTLB_ACCESS(1,1))
+
 
 class CPUMMU
 {
 private:
+	/* Entries are valid only if their generation is the current one, so a
+	 * flush is a counter increment. The arrays are cleared only when the
+	 * counter wraps around.
+	 */
 	typedef struct {
 		uint32_t lpf;   // linear page frame
 		uint32_t ppf;   // physical page frame
 		uint32_t access;
+		uint32_t gen;   // generation
 	} TLBEntry;
 
 	TLBEntry m_TLB[TLB_SIZE];
+	uint32_t m_TLB_gen;
+
+	/* The host TLB maps linear pages backed by system RAM directly to the RAM
+	 * buffer, so that data accesses to ordinary memory skip both the page
+	 * translation and the Memory mappings dispatch. It's indexed like the TLB
+	 * and it's used with paging disabled too (linear = physical).
+	 * Pages that are not (or not entirely) RAM get an entry too, with the
+	 * accesses that must take the slow path removed, so that they are not
+	 * looked up in the Memory mappings again at every access.
+	 */
+	typedef struct {
+		uint32_t lpf;     // linear page frame
+		uint32_t ppf;     // physical page frame
+		unsigned access;  // allowed accesses, see HTLB_ACCESS
+		unsigned prot;    // accesses allowed by the page protection at fill time
+		uint32_t gen;     // generation
+		uint8_t *host;    // the page in the RAM buffer
+	} HostTLBEntry;
+
+	HostTLBEntry m_host_TLB[TLB_SIZE];
+	uint32_t m_host_TLB_gen;
+
+	/* The PDE cache holds the page directory entries recently read by
+	 * TLB_miss(), so that the page walk can skip the first level. It's indexed
+	 * by the physical address of the entry. An entry is valid until the TLB
+	 * is flushed (CR3 writes included) or its page is written (the page is
+	 * watched through the decoded instructions cache page generations).
+	 * Only present entries with the A bit set are cached, so a walk that uses
+	 * the cache never needs to update the page directory.
+	 */
+	typedef struct {
+		uint32_t addr;     // physical address of the PDE
+		uint32_t pde;      // the PDE value
+		uint32_t gen;      // the TLB generation
+		uint32_t page_gen; // the generation of the page directory page
+		int cycles;        // the bus cycles needed to read the PDE
+	} PDECacheEntry;
+
+	PDECacheEntry m_PDE_cache[PDE_CACHE_SIZE];
+
+	struct {
+		uint64_t flushes;
+		uint64_t misses;
+	} m_stats;
 
 public:
+	CPUMMU();
+
 	uint32_t TLB_lookup(uint32_t _linear, unsigned _len, bool _user, bool _write);
 	void TLB_check(uint32_t _linear, bool _user, bool _write);
 	void TLB_flush();
+	inline bool TLB_peek(uint32_t _linear, uint32_t &phy_) const {
+		// like TLB_lookup but without page walks and protection checks
+		const TLBEntry *tlbent = &m_TLB[TLB_index(_linear, 0)];
+		if(tlbent->lpf == LPF_OF(_linear) && tlbent->gen == m_TLB_gen) {
+			phy_ = tlbent->ppf | PAGE_OFFSET(_linear);
+			return true;
+		}
+		return false;
+	}
+	inline uint8_t * host_TLB_lookup(uint32_t _linear, unsigned _len, bool _user, bool _write, uint32_t &phy_) const {
+		// _linear+_len must not cross the page boundary
+		const HostTLBEntry *e = &m_host_TLB[TLB_index(_linear, 0)];
+		if(e->lpf == LPF_OF(_linear) && e->gen == m_host_TLB_gen
+		&& (e->access & HTLB_ACCESS(_user, _write))) {
+			phy_ = e->ppf | PAGE_OFFSET(_linear);
+			return e->host + PAGE_OFFSET(_linear);
+		}
+		return nullptr;
+	}
+	void host_TLB_fill(uint32_t _linear, uint32_t _phy);
+	void host_TLB_flush();
+
+	inline uint64_t TLB_flushes() const { return m_stats.flushes; }
+	inline uint64_t TLB_misses() const { return m_stats.misses; }
 	static uint32_t dbg_translate_linear(uint32_t _linear_addr, uint32_t _pdbr, Memory *_memory);
 
 private:
@@ -57,6 +138,11 @@ private:
 	}
 
 	void TLB_miss(uint32_t _linear, TLBEntry *_tlbent, bool _user, bool _write);
+	bool PDE_cache_lookup(uint32_t _addr, uint32_t &pde_);
+	void PDE_cache_insert(uint32_t _addr, uint32_t _pde, int _cycles);
+	inline PDECacheEntry & PDE_cache_entry(uint32_t _addr) {
+		return m_PDE_cache[(_addr >> 2) & (PDE_CACHE_SIZE-1)];
+	}
 	void protection_check(unsigned _protection, uint32_t _linear, bool _write);
 	void page_fault(unsigned _fault, uint32_t _linear, bool _user, bool _write);
 };
@@ -21,9 +21,13 @@
 #include "devices.h"
 #include "iodevice.h"
 #include "hardware/cpu.h"
+#include "hardware/cpu/executor.h"
+#include "hardware/cpu/mmu.h"
+#include "hardware/memory.h"
 #include "machine.h"
 #include "program.h"
 #include <cstring>
+#include <algorithm>
 
 #include "devices/cmos.h"
 #include "devices/pic.h"
@@ -55,6 +59,7 @@ m_pit(nullptr),
 m_vga(nullptr),
 m_cmos(nullptr)
 {
+	memset(&m_io_poll, 0, sizeof(m_io_poll));
 }
 
 Devices::~Devices()
@@ -89,6 +94,7 @@ void Devices::reset(uint _signal)
 	}
 
 	m_last_io_time = 0;
+	memset(&m_io_poll, 0, sizeof(m_io_poll));
 }
 
 void Devices::config_changed()
@@ -262,6 +268,7 @@ void Devices::register_read_handler(IODevice *_iodev, uint16_t _port, uint _mask
 
 	m_read_handlers[_port].device = _iodev;
 	m_read_handlers[_port].mask = _mask;
+	m_read_handlers[_port].prof = g_hwprof.register_counter(std::string("I/O ") + _iodev->name());
 }
 
 void Devices::register_write_handler(IODevice *_iodev, uint16_t _port, uint _mask)
@@ -293,6 +300,7 @@ void Devices::register_write_handler(IODevice *_iodev, uint16_t _port, uint _mas
 	}
 	m_write_handlers[_port].device = _iodev;
 	m_write_handlers[_port].mask = _mask;
+	m_write_handlers[_port].prof = g_hwprof.register_counter(std::string("I/O ") + _iodev->name());
 }
 
 void Devices::unregister_read_handler(uint16_t _port)
@@ -323,7 +331,98 @@ uint8_t Devices::read_byte(uint16_t _port)
 		PDEBUGF(LOG_V2, LOG_MACHINE, "Unhandled read from port 0x%04X\n", _port);
 		return 0xFF;
 	}
-	return uint8_t(iohdl.device->read(_port, 1));
+	uint8_t value;
+	{
+		HWProfiler::Scope prof(iohdl.prof);
+		value = iohdl.device->read(_port, 1);
+	}
+	if(USE_IO_POLL_SKIP) {
+		io_poll(iohdl.device, _port);
+	}
+	return value;
+}
+
+void Devices::io_poll(IODevice *_iodev, uint16_t _port)
+{
+	/* Programs often wait for a status bit with a tight loop of IN and
+	 * conditional jump, for example on the VGA Input Status 1 register. If the
+	 * device knows that the port value won't change until a given time, every
+	 * iteration until then is the same and the loop can't exit, so the time is
+	 * charged to this read as if the loop had run. The skip is limited by the
+	 * next timer, as an interrupt or a device update could end the loop.
+	 * Only loops made exactly of IN, TEST/AND and a conditional jump back to
+	 * the IN are skipped, anything else could have other side effects.
+	 */
+	uint32_t cseip = g_cpuexecutor.m_instr ? g_cpuexecutor.m_instr->cseip : 0;
+	uint64_t icount = g_cpu.get_icount();
+	if(_port == m_io_poll.port && cseip == m_io_poll.cseip
+	&& icount - m_io_poll.icount == IO_POLL_LOOP_INSTR)
+	{
+		m_io_poll.count++;
+	} else {
+		m_io_poll.port = _port;
+		m_io_poll.cseip = cseip;
+		m_io_poll.count = 1;
+		m_io_poll.loop = false;
+	}
+	m_io_poll.icount = icount;
+
+	if(m_io_poll.count < IO_POLL_MIN_READS) {
+		return;
+	}
+	if(m_io_poll.count == IO_POLL_MIN_READS) {
+		// the code is checked once per loop
+		m_io_poll.loop = is_poll_loop(cseip);
+	}
+	if(!m_io_poll.loop || g_cpu.events_pending()) {
+		return;
+	}
+	uint64_t until = _iodev->read_stable_until(_port);
+	uint64_t now = m_machine->get_virt_time_ns();
+	until = std::min(until, m_machine->get_next_timer_time());
+	if(until <= now) {
+		return;
+	}
+	m_last_io_time += std::min(until - now, uint64_t(IO_POLL_MAX_SKIP));
+}
+
+bool Devices::is_poll_loop(uint32_t _cseip)
+{
+	uint8_t code[10];
+	for(unsigned i=0; i<sizeof(code); i++) {
+		uint32_t phy = _cseip + i;
+		if(IS_PAGING() && !g_cpummu.TLB_peek(_cseip + i, phy)) {
+			return false;
+		}
+		code[i] = g_memory.dbg_read_byte(phy);
+	}
+	unsigned pos;
+	switch(code[0]) {
+		case 0xEC: pos = 1; break; // IN AL,DX
+		case 0xE4: pos = 2; break; // IN AL,imm8
+		default: return false;
+	}
+	if(code[pos] == 0xA8 || code[pos] == 0x24) {
+		pos += 2; // TEST AL,imm8 / AND AL,imm8
+	} else if(code[pos] == 0x84 && code[pos+1] == 0xC0) {
+		pos += 2; // TEST AL,AL
+	} else if((code[pos] == 0xF6 && code[pos+1] == 0xC0)
+	       || (code[pos] == 0x80 && code[pos+1] == 0xE0)) {
+		pos += 3; // TEST AL,imm8 / AND AL,imm8 with modrm
+	} else {
+		return false;
+	}
+	int32_t disp;
+	if((code[pos] & 0xF0) == 0x70) {
+		disp = int8_t(code[pos+1]);
+		pos += 2;
+	} else if(code[pos] == 0x0F && (code[pos+1] & 0xF0) == 0x80 && !REG_CS.desc.big) {
+		disp = int16_t(code[pos+2] | code[pos+3] << 8);
+		pos += 4;
+	} else {
+		return false;
+	}
+	return (disp == -int32_t(pos));
 }
 
 uint16_t Devices::read_word(uint16_t _port)
@@ -340,6 +439,7 @@ uint16_t Devices::read_word(uint16_t _port)
 		m_last_io_time += io_time;
 		value = b0 | (b1<<8);
 	} else if(iohdl.mask & PORT_16BIT) {
+		HWProfiler::Scope prof(iohdl.prof);
 		value = iohdl.device->read(_port, 2);
 	}
 	return value;
@@ -354,6 +454,7 @@ uint32_t Devices::read_dword(uint16_t _port)
 	if((iohdl.mask & PORT_32BIT) && !(_port & 1)) {
 		// TODO stub, this depends on the bus width
 		// TODO this implementation requires that the device uses a buffer index
+		HWProfiler::Scope prof(iohdl.prof);
 		uint32_t w0 = iohdl.device->read(_port, 2);
 		uint32_t w1 = iohdl.device->read(_port, 2); // not _port+2, change this with proper 32bit support
 		value = w0 | (w1<<16);
@@ -377,6 +478,7 @@ void Devices::write_byte(uint16_t _port, uint8_t _value)
 		PDEBUGF(LOG_V2, LOG_MACHINE, "Unhandled write to port 0x%04X\n", _port);
 		return;
 	}
+	HWProfiler::Scope prof(iohdl.prof);
 	iohdl.device->write(_port, _value, 1);
 }
 
@@ -401,6 +503,7 @@ void Devices::write_word(uint16_t _port, uint16_t _value)
 		write_byte(_port+1, uint8_t(_value>>8));
 		m_last_io_time += io_time;
 	} else if(iohdl.mask & PORT_16BIT) {
+		HWProfiler::Scope prof(iohdl.prof);
 		iohdl.device->write(_port, _value, 2);
 	}
 }
@@ -413,6 +516,7 @@ void Devices::write_dword(uint16_t _port, uint32_t _value)
 	if((iohdl.mask & PORT_32BIT) && !(_port & 1)) {
 		// TODO stub, this depends on the bus width
 		// TODO this implementation requires that the device uses a buffer index
+		HWProfiler::Scope prof(iohdl.prof);
 		iohdl.device->write(_port, _value, 2);
 		iohdl.device->write(_port, _value>>16, 2); // not _port+2, change this with proper 32bit support
 	} else {
@@ -424,6 +528,53 @@ void Devices::write_dword(uint16_t _port, uint32_t _value)
 	}
 }
 
+unsigned Devices::read_block(uint16_t _port, uint8_t *_buf, unsigned _count, unsigned _io_len)
+{
+	/* Only transfers the device can handle with a single access per element
+	 * are moved in bulk. The device charges the I/O time of the whole block.
+	 */
+	io_handler_t &iohdl = m_read_handlers[_port];
+
+	if((_io_len == 1 && !(iohdl.mask & PORT_8BIT)) ||
+	   (_io_len == 2 && ((_port & 1) || !(iohdl.mask & PORT_16BIT))) ||
+	   _io_len > 2)
+	{
+		return 0;
+	}
+	// the I/O time of the block adds to the one of the normal iteration
+	unsigned io_time = m_last_io_time;
+	m_last_io_time = 0;
+	unsigned count;
+	{
+		HWProfiler::Scope prof(iohdl.prof);
+		count = iohdl.device->read_block(_port, _buf, _count, _io_len);
+	}
+	m_last_io_time += io_time;
+	return count;
+}
+
+unsigned Devices::write_block(uint16_t _port, const uint8_t *_buf, unsigned _count, unsigned _io_len)
+{
+	io_handler_t &iohdl = m_write_handlers[_port];
+
+	if((_io_len == 1 && !(iohdl.mask & PORT_8BIT)) ||
+	   (_io_len == 2 && ((_port & 1) || !(iohdl.mask & PORT_16BIT))) ||
+	   _io_len > 2)
+	{
+		return 0;
+	}
+	// the I/O time of the block adds to the one of the normal iteration
+	unsigned io_time = m_last_io_time;
+	m_last_io_time = 0;
+	unsigned count;
+	{
+		HWProfiler::Scope prof(iohdl.prof);
+		count = iohdl.device->write_block(_port, _buf, _count, _io_len);
+	}
+	m_last_io_time += io_time;
+	return count;
+}
+
 void Devices::remove(const char *_name)
 {
 	if(m_devices.find(_name) == m_devices.end()) {
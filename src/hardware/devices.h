@@ -45,14 +45,19 @@ extern Devices g_devices;
 
 #define PORT_MAX   0xFFFF
 
+#define IO_POLL_MIN_READS 8       // consecutive reads before a loop is considered polling
+#define IO_POLL_LOOP_INSTR 3      // instructions between two reads: IN, TEST/AND, Jcc
+#define IO_POLL_MAX_SKIP  1000000 // max amount of time (ns) skipped by a single read
+
 class Devices
 {
 private:
 	struct io_handler_t {
 		IODevice * device;
 		uint mask;
+		unsigned prof; // host time profiler counter
 
-		io_handler_t() : device(nullptr), mask(0) {}
+		io_handler_t() : device(nullptr), mask(0), prof(0) {}
 	};
 
 	io_handler_t m_read_handlers[PORT_MAX+1];
@@ -70,6 +75,14 @@ private:
 
 	unsigned m_last_io_time;
 
+	struct {
+		uint16_t port;
+		uint32_t cseip;
+		uint64_t icount;
+		unsigned count;
+		bool loop; // the code at cseip is a pure polling loop
+	} m_io_poll;
+
 public:
 	Devices();
 	~Devices();
@@ -108,6 +121,8 @@ public:
 	void write_byte(uint16_t _port, uint8_t _value);
 	void write_word(uint16_t _port, uint16_t _value);
 	void write_dword(uint16_t _port, uint32_t _value);
+	unsigned read_block(uint16_t _port, uint8_t *_buf, unsigned _count, unsigned _io_len);
+	unsigned write_block(uint16_t _port, const uint8_t *_buf, unsigned _count, unsigned _io_len);
 
 	inline void set_io_time(unsigned _io_time) {
 		m_last_io_time = _io_time;
@@ -126,6 +141,8 @@ private:
 	template<class T> T* install();
 	template<class T> T* install_only_if(bool _condition);
 	void remove(const char *);
+	void io_poll(IODevice *_iodev, uint16_t _port);
+	static bool is_poll_loop(uint32_t _cseip);
 };
 
 #endif
@@ -24,6 +24,7 @@
 #include "hardware/devices.h"
 #include "hardware/cpu.h"
 #include <cstring>
+#include <algorithm>
 
 
 #define DMA_MODE_DEMAND  0
@@ -543,50 +544,61 @@ void DMA::raise_HLDA(void)
 	           (m_s.dma[ma_sl].chan[channel].current_address << ma_sl);
 
 	if(!m_s.dma[ma_sl].chan[channel].mode.address_decrement) {
-		maxlen = (m_s.dma[ma_sl].chan[channel].current_count + 1) << ma_sl;
-		m_s.TC = (maxlen <= DMA_BUFFER_SIZE);
-		if(maxlen > DMA_BUFFER_SIZE) {
-			maxlen = DMA_BUFFER_SIZE;
-		}
+		/* A transfer can't cross a 64K (8-bit) or 128K (16-bit) page, the
+		 * current address wraps around within the page and the next transfer
+		 * starts from its beginning.
+		 */
+		uint32_t xferlen = uint32_t(m_s.dma[ma_sl].chan[channel].current_count + 1) << ma_sl;
+		uint32_t pagelen = uint32_t(0x10000 - m_s.dma[ma_sl].chan[channel].current_address) << ma_sl;
+		m_s.TC = (xferlen <= DMA_BUFFER_SIZE && xferlen <= pagelen);
+		maxlen = std::min(std::min(xferlen, pagelen), uint32_t(DMA_BUFFER_SIZE));
 	} else {
 		m_s.TC = (m_s.dma[ma_sl].chan[channel].current_count == 0);
 		maxlen = 1 << ma_sl;
 	}
 
+	/* When the block is in system RAM without traps the device handlers access
+	 * the guest memory directly, otherwise the data goes through the buffer.
+	 */
+	uint8_t *ram;
+
 	if(m_s.dma[ma_sl].chan[channel].mode.transfer_type == 1) { // write
 		// DMA controlled xfer of bytes from I/O to Memory
 
+		ram = g_memory.get_ram_block(phy_addr, maxlen, true);
 		if(!ma_sl) {
 			if(m_h[channel].dmaWrite8) {
-				len = m_h[channel].dmaWrite8(buffer, maxlen);
+				len = m_h[channel].dmaWrite8(ram ? ram : buffer, maxlen);
 			} else {
 				PERRF(LOG_DMA, "no dmaWrite handler for channel %u\n", channel);
 			}
-			g_memory.DMA_write(phy_addr, len, buffer);
-
+			if(!ram) {
+				g_memory.DMA_write(phy_addr, len, buffer);
+			}
 		} else {
 			if(m_h[channel].dmaWrite16) {
-				len = m_h[channel].dmaWrite16((uint16_t*)buffer, maxlen / 2);
+				len = m_h[channel].dmaWrite16((uint16_t*)(ram ? ram : buffer), maxlen / 2);
 			} else {
 				PERRF(LOG_DMA, "no dmaWrite handler for channel %u\n", channel);
 			}
-			g_memory.DMA_write(phy_addr, len, buffer);
-
+			if(!ram) {
+				g_memory.DMA_write(phy_addr, len * 2, buffer);
+			}
 		}
 	} else if(m_s.dma[ma_sl].chan[channel].mode.transfer_type == 2) { // read
 		// DMA controlled xfer of bytes from Memory to I/O
 
-		if(!ma_sl) {
+		ram = g_memory.get_ram_block(phy_addr, maxlen, false);
+		if(!ram) {
 			g_memory.DMA_read(phy_addr, maxlen, buffer);
-
+		}
+		if(!ma_sl) {
 			if(m_h[channel].dmaRead8) {
-				len = m_h[channel].dmaRead8(buffer, maxlen);
+				len = m_h[channel].dmaRead8(ram ? ram : buffer, maxlen);
 			}
 		} else {
-			g_memory.DMA_read(phy_addr, maxlen, buffer);
-
 			if(m_h[channel].dmaRead16){
-				len = m_h[channel].dmaRead16((uint16_t*)buffer, maxlen / 2);
+				len = m_h[channel].dmaRead16((uint16_t*)(ram ? ram : buffer), maxlen / 2);
 			}
 		}
 	} else if(m_s.dma[ma_sl].chan[channel].mode.transfer_type == 0) {
@@ -130,6 +130,25 @@ uint16_t GamePort::read(uint16_t _address, unsigned)
 	return uint16_t(value);
 }
 
+uint64_t GamePort::read_stable_until(uint16_t _address)
+{
+	if(_address != 0x201) {
+		return 0;
+	}
+	/* While the axes one-shots are running the programs measure the stick
+	 * positions counting the iterations of their polling loop, so the time
+	 * can't be skipped. After that the value changes only with a write or with
+	 * the buttons, which are not timed.
+	 */
+	double now_us = g_machine.get_virt_time_us();
+	for(auto &stick : m_s.stick) {
+		if(stick.x_us >= now_us || stick.y_us >= now_us) {
+			return 0;
+		}
+	}
+	return UINT64_MAX;
+}
+
 void GamePort::write(uint16_t _address, uint16_t _value, unsigned)
 {
 	if(_address != 0x201) {
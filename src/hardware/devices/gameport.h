@@ -50,6 +50,7 @@ public:
 	void power_off();
 	void config_changed();
 	uint16_t read(uint16_t _address, unsigned _io_len);
+	uint64_t read_stable_until(uint16_t _address);
 	void write(uint16_t _address, uint16_t _value, unsigned _io_len);
 
 	void save_state(StateBuf &_state);
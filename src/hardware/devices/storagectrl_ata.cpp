@@ -801,6 +801,85 @@ uint16_t StorageCtrl_ATA::read(uint16_t _address, unsigned _len)
 	return value;
 }
 
+int StorageCtrl_ATA::data_channel(uint16_t _address) const
+{
+	for(int channel=0; channel<ATA_MAX_CHANNEL; channel++) {
+		if(_address == m_channels[channel].ioaddr1) {
+			return channel;
+		}
+	}
+	return -1;
+}
+
+unsigned StorageCtrl_ATA::read_block(uint16_t _address, uint8_t *_buf, unsigned _count,
+		unsigned _io_len)
+{
+	/* Bulk read of the data register for the READ SECTORS commands.
+	 * The last word of the buffer is always left to read(), which completes
+	 * the block and loads the next one, so the command timings don't change.
+	 */
+	int channel = data_channel(_address);
+	if(channel < 0 || _io_len != 2) {
+		return 0;
+	}
+	Controller &controller = selected_ctrl(channel);
+	if(!controller.status.drq) {
+		return 0;
+	}
+	switch(controller.current_command) {
+		case 0x20: // READ SECTORS, with retries
+		case 0x21: // READ SECTORS, without retries
+		case 0xC4: // READ MULTIPLE SECTORS
+		case 0x24: // READ SECTORS EXT
+		case 0x29: // READ MULTIPLE EXT
+			break;
+		default:
+			return 0;
+	}
+	if(controller.buffer_index + 2 >= controller.buffer_size) {
+		return 0;
+	}
+	unsigned count = std::min(_count, (controller.buffer_size - controller.buffer_index) / 2 - 1);
+	memcpy(_buf, &controller.buffer[controller.buffer_index], count * 2);
+	controller.buffer_index += count * 2;
+
+	PDEBUGF(LOG_V2, LOG_HDD, "READ data %04d/%04d bulk %u words\n",
+			controller.buffer_index, (controller.buffer_size-1), count);
+
+	return count;
+}
+
+unsigned StorageCtrl_ATA::write_block(uint16_t _address, const uint8_t *_buf, unsigned _count,
+		unsigned _io_len)
+{
+	// same as read_block(), the last word is left to write()
+	int channel = data_channel(_address);
+	if(channel < 0 || _io_len != 2) {
+		return 0;
+	}
+	Controller &controller = selected_ctrl(channel);
+	switch(controller.current_command) {
+		case 0x30: // WRITE SECTORS
+		case 0xC5: // WRITE MULTIPLE SECTORS
+		case 0x34: // WRITE SECTORS EXT
+		case 0x39: // WRITE MULTIPLE EXT
+			break;
+		default:
+			return 0;
+	}
+	if(controller.buffer_index + 2 >= controller.buffer_size) {
+		return 0;
+	}
+	unsigned count = std::min(_count, (controller.buffer_size - controller.buffer_index) / 2 - 1);
+	memcpy(&controller.buffer[controller.buffer_index], _buf, count * 2);
+	controller.buffer_index += count * 2;
+
+	PDEBUGF(LOG_V2, LOG_HDD, "WRITE data %04d/%04d bulk %u words\n",
+			controller.buffer_index, (controller.buffer_size-1), count);
+
+	return count;
+}
+
 void StorageCtrl_ATA::write(uint16_t _address, uint16_t _value, unsigned _len)
 {
 	bool prev_control_reset;
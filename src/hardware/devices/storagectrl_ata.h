@@ -170,6 +170,8 @@ public:
 	void power_off();
 	uint16_t read(uint16_t _address, unsigned _len);
 	void write(uint16_t _address, uint16_t _value, unsigned _len);
+	unsigned read_block(uint16_t _address, uint8_t *_buf, unsigned _count, unsigned _io_len);
+	unsigned write_block(uint16_t _address, const uint8_t *_buf, unsigned _count, unsigned _io_len);
 
 	void save_state(StateBuf &_state);
 	void restore_state(StateBuf &_state);
@@ -180,6 +182,7 @@ public:
 	}
 
 private:
+	int data_channel(uint16_t _address) const;
 	void reset_channel(int _ch);
 	void raise_interrupt(int _ch);
 	void lower_interrupt(int _ch);
@@ -28,6 +28,7 @@
 #include "gui/gui.h"
 #include "filesys.h"
 #include <cstring>
+#include <array>
 
 using namespace std::placeholders;
 
@@ -105,6 +106,7 @@ m_memory(nullptr),
 m_rom(nullptr),
 m_tile_updated(nullptr),
 m_timer_id(NULL_TIMER_HANDLE),
+m_retrace_timer_id(NULL_TIMER_HANDLE),
 m_display(nullptr),
 m_mem_mapping(0),
 m_rom_mapping(0),
@@ -135,7 +137,9 @@ void VGA::install()
 	m_memory = new uint8_t[m_memsize];
 	m_rom = new uint8_t[0x10000];
 	m_tile_updated = new bool[m_num_x_tiles * m_num_y_tiles];
-	m_timer_id = g_machine.register_timer(nullptr, name());
+	m_timer_id = g_machine.register_timer(std::bind(&VGA::update,this,_1), name());
+	m_retrace_timer_id = g_machine.register_timer(std::bind(&VGA::vertical_retrace,this,_1),
+			(std::string(name()) + " retrace").c_str());
 	/*
 	g_memory.register_trap(0xA0000, 0xBFFFF, MEM_TRAP_READ|MEM_TRAP_WRITE,
 	[this] (uint32_t addr, uint8_t rw, uint16_t value, uint8_t len) {
@@ -174,6 +178,13 @@ void VGA::config_changed()
 	PINFOF(LOG_V2, LOG_VGA, "VRAM speed: %d/%d/%d cycles\n",
 			byte, word, dword);
 
+	int threads = g_program.config().get_int(DISPLAY_SECTION, DISPLAY_RENDER_THREADS, 0);
+	if(threads <= 0) {
+		threads = std::min(std::thread::hardware_concurrency(), unsigned(VGA_WORKERS));
+	}
+	m_workers.start(threads);
+	PINFOF(LOG_V2, LOG_VGA, "Rendering threads: %u\n", m_workers.count());
+
 	g_memory.enable_mapping(m_rom_mapping, false);
 	std::string romfile = g_program.config().find_file(SYSTEM_SECTION, SYSTEM_VGAROM);
 	if(!romfile.empty()) {
@@ -192,6 +203,7 @@ void VGA::remove()
 	IODevice::remove();
 	g_machine.unregister_irq(VGA_IRQ);
 	g_machine.unregister_timer(m_timer_id);
+	g_machine.unregister_timer(m_retrace_timer_id);
 
 	if(m_memory != nullptr) {
 		delete[] m_memory;
@@ -207,6 +219,8 @@ void VGA::remove()
 	}
 
 	g_memory.remove_mapping(m_mem_mapping);
+
+	m_workers.stop();
 }
 
 void VGA::reset(unsigned _type)
@@ -259,6 +273,7 @@ void VGA::power_off()
 {
 	clear_screen();
 	g_machine.deactivate_timer(m_timer_id);
+	g_machine.deactivate_timer(m_retrace_timer_id);
 }
 
 void VGA::save_state(StateBuf &_state)
@@ -313,12 +328,13 @@ void VGA::restore_state(StateBuf &_state)
 
 	double vfreq = 1000000.0 / m_s.vtotal_usec;
 	if(vfreq > 0.0 && vfreq <= 75.0) {
-		g_machine.set_timer_callback(m_timer_id, std::bind(&VGA::update,this,_1));
+		g_machine.deactivate_timer(m_retrace_timer_id);
 		g_machine.activate_timer(m_timer_id, uint64_t(m_s.vtotal_usec)*1_us, false);
 		g_machine.set_heartbeat(m_s.vtotal_usec);
 		g_program.set_heartbeat(m_s.vtotal_usec);
 	} else {
 		g_machine.deactivate_timer(m_timer_id);
+		g_machine.deactivate_timer(m_retrace_timer_id);
 	}
 
 	update_mem_mapping();
@@ -438,11 +454,13 @@ void VGA::calculate_retrace_timing()
 
 	if(vfreq > 0.0 && vfreq <= 75.0) {
 		PDEBUGF(LOG_V1, LOG_VGA, "vfreq = %.4f Hz (%u us)\n", vfreq, m_s.vtotal_usec);
+		g_machine.deactivate_timer(m_retrace_timer_id);
 		vertical_retrace(g_machine.get_virt_time_ns());
 		g_machine.set_heartbeat(m_s.vtotal_usec);
 		g_program.set_heartbeat(m_s.vtotal_usec);
 	} else {
 		g_machine.deactivate_timer(m_timer_id);
+		g_machine.deactivate_timer(m_retrace_timer_id);
 		PDEBUGF(LOG_V2, LOG_VGA, "vfreq = %.2f Hz: out of range\n", vfreq);
 	}
 }
@@ -714,6 +732,40 @@ uint16_t VGA::read(uint16_t address, uint /*io_len*/)
 	}
 }
 
+uint64_t VGA::read_stable_until(uint16_t address)
+{
+	// the Input Status 1 retrace bits change at the same times they are
+	// computed in read(), the other registers don't depend on time
+	if(address != (m_s.misc_output.color_emulation ? 0x03da : 0x03ba)) {
+		return 0;
+	}
+	if(m_s.htotal_usec == 0) {
+		return 0;
+	}
+	uint64_t now_usec = g_machine.get_virt_time_us();
+	uint64_t vbend_usec = m_s.vblank_time_usec + m_s.vbspan_usec;
+	uint64_t next_usec;
+	if(now_usec <= vbend_usec) {
+		uint64_t vrend_usec = m_s.vretrace_time_usec + m_s.vrspan_usec;
+		if(now_usec <= vrend_usec) {
+			next_usec = vrend_usec + 1;
+		} else {
+			next_usec = vbend_usec + 1;
+		}
+	} else {
+		uint64_t line_usec = (now_usec - vbend_usec) % m_s.htotal_usec;
+		if(line_usec < m_s.hbstart_usec) {
+			next_usec = now_usec + (m_s.hbstart_usec - line_usec);
+		} else if(line_usec <= m_s.hbend_usec) {
+			next_usec = now_usec + (m_s.hbend_usec - line_usec) + 1;
+		} else {
+			next_usec = now_usec + (m_s.htotal_usec - line_usec) + m_s.hbstart_usec;
+		}
+	}
+	// the start of the next vertical blank is signaled by the update timer
+	return next_usec * 1000;
+}
+
 void VGA::write(uint16_t address, uint16_t value, uint /*io_len*/)
 {
 	uint8_t charmap1, charmap2;
@@ -1232,55 +1284,89 @@ void VGA::write(uint16_t address, uint16_t value, uint /*io_len*/)
 	}
 }
 
-uint8_t VGA::get_vga_pixel(uint16_t x, uint16_t y, uint16_t saddr, uint16_t lc,
-		bool bs, uint8_t * const *plane)
+/* Bit transposition table for the planar modes: every bit of a plane byte is
+ * spread to a byte of the result, the leftmost pixel (bit 7) in the first
+ * byte in memory. Or-ing the entries of the 4 planes shifted by the plane
+ * number gives the attributes of 8 pixels at once.
+ */
+static const std::array<uint64_t,256> s_planar_spread = []() {
+	std::array<uint64_t,256> table;
+	for(unsigned v=0; v<256; v++) {
+		uint8_t bytes[8];
+		for(unsigned b=0; b<8; b++) {
+			bytes[b] = (v >> (7-b)) & 1;
+		}
+		memcpy(&table[v], bytes, 8);
+	}
+	return table;
+}();
+
+void VGA::get_vga_dac_table(bool bs, uint8_t *dac_)
+{
+	// the attribute to DAC register mapping of the planar modes, for a frame
+	for(unsigned a=0; a<16; a++) {
+		uint8_t attribute = a & m_s.attribute_ctrl.color_plane_enable;
+		// undocumented feature ???: colors 0..7 high intensity, colors 8..15 blinking
+		if(m_s.attribute_ctrl.mode_ctrl.blink_intensity) {
+			if(bs) {
+				attribute |= 0x08;
+			} else {
+				attribute ^= 0x08;
+			}
+		}
+		uint8_t palette_reg_val = m_s.attribute_ctrl.palette_reg[attribute];
+		if(m_s.attribute_ctrl.mode_ctrl.internal_palette_size) {
+			// use 4 lower bits from palette register
+			// use 4 higher bits from color select register
+			// 16 banks of 16-color registers
+			dac_[a] = (palette_reg_val & 0x0f) | (m_s.attribute_ctrl.color_select << 4);
+		} else {
+			// use 6 lower bits from palette register
+			// use 2 higher bits from color select register
+			// 4 banks of 64-color registers
+			dac_[a] = (palette_reg_val & 0x3f) | ((m_s.attribute_ctrl.color_select & 0x0c) << 4);
+		}
+		// DAC_regno &= video DAC mask register ???
+	}
+}
+
+void VGA::get_vga_row(uint16_t x, uint16_t y, uint16_t saddr, uint16_t lc,
+		uint8_t * const *plane, const uint8_t *dac, uint8_t *dst_, unsigned count)
 {
-	uint8_t attribute, bit_no, palette_reg_val, DAC_regno;
-	uint32_t byte_offset;
+	/* Renders count pixels of a planar mode scanline. The plane bytes are
+	 * converted to attributes 8 pixels at a time, then mapped to the DAC.
+	 */
 	int pan = m_s.attribute_ctrl.horiz_pel_panning;
 	if((pan >= 8) || ((y > lc) && (m_s.attribute_ctrl.mode_ctrl.pixel_panning_mode == 1))) {
 		pan = 0;
 	}
-	if(m_s.x_dotclockdiv2) {
-		x >>= 1;
-	}
-	x += pan;
-	bit_no = 7 - (x % 8);
+	uint32_t line_offset;
 	if(y > lc) {
-		byte_offset = x / 8 + ((y - lc - 1) * m_s.line_offset);
+		line_offset = (y - lc - 1) * m_s.line_offset;
 	} else {
-		byte_offset = saddr + x / 8 + (y * m_s.line_offset);
+		line_offset = saddr + (y * m_s.line_offset);
 	}
-	byte_offset %= 0x10000;
-	attribute =
-		(((plane[0][byte_offset] >> bit_no) & 0x01) << 0) |
-		(((plane[1][byte_offset] >> bit_no) & 0x01) << 1) |
-		(((plane[2][byte_offset] >> bit_no) & 0x01) << 2) |
-		(((plane[3][byte_offset] >> bit_no) & 0x01) << 3);
-
-	attribute &= m_s.attribute_ctrl.color_plane_enable;
-	// undocumented feature ???: colors 0..7 high intensity, colors 8..15 blinking
-	if(m_s.attribute_ctrl.mode_ctrl.blink_intensity) {
-		if(bs) {
-			attribute |= 0x08;
-		} else {
-			attribute ^= 0x08;
-		}
+	unsigned shift = m_s.x_dotclockdiv2;
+	unsigned first = (x >> shift) + pan;
+	unsigned last = ((x + count - 1) >> shift) + pan;
+
+	uint8_t attributes[VGA_X_TILESIZE + 16];
+	assert(((last/8 - first/8 + 1) * 8) <= sizeof(attributes));
+	uint8_t *attr = attributes;
+	for(unsigned byte = first/8; byte <= last/8; byte++, attr += 8) {
+		uint32_t byte_offset = (line_offset + byte) % 0x10000;
+		uint64_t pixels =
+			(s_planar_spread[plane[0][byte_offset]] << 0) |
+			(s_planar_spread[plane[1][byte_offset]] << 1) |
+			(s_planar_spread[plane[2][byte_offset]] << 2) |
+			(s_planar_spread[plane[3][byte_offset]] << 3);
+		memcpy(attr, &pixels, 8);
 	}
-	palette_reg_val = m_s.attribute_ctrl.palette_reg[attribute];
-	if(m_s.attribute_ctrl.mode_ctrl.internal_palette_size) {
-		// use 4 lower bits from palette register
-		// use 4 higher bits from color select register
-		// 16 banks of 16-color registers
-		DAC_regno = (palette_reg_val & 0x0f) | (m_s.attribute_ctrl.color_select << 4);
-	} else {
-		// use 6 lower bits from palette register
-		// use 2 higher bits from color select register
-		// 4 banks of 64-color registers
-		DAC_regno = (palette_reg_val & 0x3f) | ((m_s.attribute_ctrl.color_select & 0x0c) << 4);
+	const uint8_t *src = &attributes[first % 8];
+	unsigned x0 = x >> shift;
+	for(unsigned i=0; i<count; i++) {
+		dst_[i] = dac[src[((x + i) >> shift) - x0]];
 	}
-	// DAC_regno &= video DAC mask register ???
-	return DAC_regno;
 }
 
 void VGA::raise_interrupt()
@@ -1333,40 +1419,39 @@ bool VGA::skip_update()
 }
 
 template<typename FN>
-void VGA::gfx_update_core(FN _get_pixel, bool _force_upd, int id, int pool_size)
+void VGA::gfx_update_tile(FN _get_row, unsigned _xti, unsigned _yti)
 {
-	unsigned xc, yc, xti, yti, r, row, col, pixelx, pixely;
-	unsigned ystart = VGA_Y_TILESIZE * id;
-	unsigned ystep = VGA_Y_TILESIZE * pool_size;
-
+	unsigned xc = _xti * VGA_X_TILESIZE;
+	unsigned yc = _yti * VGA_Y_TILESIZE;
 	uint8_t tile[VGA_X_TILESIZE * VGA_Y_TILESIZE * 4];
 
-	for(yc=ystart, yti=id; yc<m_s.last_yres; yc+=ystep, yti+=pool_size) {
-		for(xc=0, xti=0; xc<m_s.last_xres; xc+=VGA_X_TILESIZE, xti++) {
-			if(_force_upd || GET_TILE_UPDATED (xti, yti)) {
-				for(r=0; r<VGA_Y_TILESIZE; r++) {
-					pixely = (yc + r) >> m_s.y_doublescan;
-					row = r * VGA_X_TILESIZE;
-					for(col=0; col<VGA_X_TILESIZE; col++) {
-						pixelx = xc + col;
-						tile[row + col] = _get_pixel(pixelx, pixely);
-					}
-				}
-				SET_TILE_UPDATED(xti, yti, false, this);
-				m_display->graphics_tile_update(tile, xc, yc);
-			}
-		}
+	for(unsigned r=0; r<VGA_Y_TILESIZE; r++) {
+		unsigned pixely = (yc + r) >> m_s.y_doublescan;
+		_get_row(xc, pixely, &tile[r * VGA_X_TILESIZE], VGA_X_TILESIZE);
 	}
+	SET_TILE_UPDATED(_xti, _yti, false, this);
+	m_display->graphics_tile_update(tile, xc, yc);
 }
 
 template<typename FN>
-void VGA::gfx_update(FN _get_pixel, bool _force_upd)
+void VGA::gfx_update(FN _get_row, bool _force_upd)
 {
-	std::future<void> w0 = std::async(std::launch::async, [&]() {
-		gfx_update_core(_get_pixel, _force_upd, 0, 2);
-	});
-	gfx_update_core(_get_pixel, _force_upd, 1, 2);
-	w0.wait();
+	/* _get_row(x, y, dst, count) renders count pixels of the scanline y,
+	 * starting at x (always a multiple of VGA_X_TILESIZE).
+	 * The dirty tiles are rendered by the workers pool.
+	 */
+	m_dirty_tiles.clear();
+	for(unsigned yc=0, yti=0; yc<m_s.last_yres; yc+=VGA_Y_TILESIZE, yti++) {
+		for(unsigned xc=0, xti=0; xc<m_s.last_xres; xc+=VGA_X_TILESIZE, xti++) {
+			if(_force_upd || GET_TILE_UPDATED(xti, yti)) {
+				m_dirty_tiles.push_back(xti + yti * m_num_x_tiles);
+			}
+		}
+	}
+	VGAWorkers::job_fun_t job = [&](unsigned _tile) {
+		gfx_update_tile(_get_row, _tile % m_num_x_tiles, _tile / m_num_x_tiles);
+	};
+	m_workers.run(m_dirty_tiles, job);
 }
 
 template <typename FN>
@@ -1374,20 +1459,23 @@ void VGA::update_mode13(FN _pixel_x, unsigned _pan)
 {
 	uint16_t line_compare = m_s.line_compare >> m_s.y_doublescan;
 
-	gfx_update([=] (unsigned pixelx, unsigned pixely)
+	gfx_update([=] (unsigned pixelx, unsigned pixely, uint8_t *dst, unsigned count)
 	{
-		pixelx >>= 1;
-		if(pixely <= line_compare || m_s.attribute_ctrl.mode_ctrl.pixel_panning_mode == 0) {
-			pixelx += _pan;
-		}
-		unsigned plane = (pixelx % 4);
-		unsigned byte_offset = (plane * 65536) + _pixel_x(pixelx);
+		unsigned line_offset, pan = 0;
 		if(pixely > line_compare) {
-			byte_offset += ((pixely - line_compare - 1) * m_s.line_offset);
+			line_offset = (pixely - line_compare - 1) * m_s.line_offset;
 		} else {
-			byte_offset += m_s.CRTC.start_address + (pixely * m_s.line_offset);
+			line_offset = m_s.CRTC.start_address + (pixely * m_s.line_offset);
+		}
+		if(pixely <= line_compare || m_s.attribute_ctrl.mode_ctrl.pixel_panning_mode == 0) {
+			pan = _pan;
+		}
+		// every pixel is doubled, x and count are even
+		for(unsigned i=0; i<count; i+=2) {
+			unsigned px = ((pixelx + i) >> 1) + pan;
+			unsigned byte_offset = ((px % 4) * 65536) + _pixel_x(px) + line_offset;
+			dst[i] = dst[i+1] = m_memory[byte_offset % m_memsize];
 		}
-		return m_memory[byte_offset % m_memsize];
 	},
 	false);
 }
@@ -1395,10 +1483,12 @@ void VGA::update_mode13(FN _pixel_x, unsigned _pan)
 void VGA::update(uint64_t _time)
 {
 	//this is "vertical blank start"
-	if(THREADS_WAIT && g_program.threads_sync()) {
+	if(THREADS_WAIT && g_program.threads_sync() && !g_machine.is_max_speed()) {
 		m_display->wait();
 	}
 
+	HWProfiler::Scope prof(HWProfiler::VGA_RENDER);
+
 	uint iHeight, iWidth;
 	static uint cs_counter = 1; //cursor blink counter
 	static bool cs_visible = false;
@@ -1409,9 +1499,7 @@ void VGA::update(uint64_t _time)
 
 	//next is the "vertical retrace start"
 	uint64_t vrdist = m_s.vrstart_usec - m_s.vblank_usec;
-	using namespace std::placeholders;
-	g_machine.set_timer_callback(m_timer_id, std::bind(&VGA::vertical_retrace,this, _1));
-	g_machine.activate_timer(m_timer_id, vrdist*1_us, false);
+	g_machine.activate_timer(m_retrace_timer_id, vrdist*1_us, false);
 
 	cs_counter--;
 	/* no screen update necessary */
@@ -1483,19 +1571,21 @@ void VGA::update(uint64_t _time)
 			case 0: // interleaved shift
 				if((m_s.CRTC.reg[CRTC_MODE_CONTROL] & CRTC_MAP13) == 0) { // CGA 640x200x2
 
-					gfx_update([=] (unsigned pixelx, unsigned pixely)
+					gfx_update([=] (unsigned pixelx, unsigned pixely, uint8_t *dst, unsigned count)
 					{
-						pixelx += pan;
 						/* 0 or 0x2000 */
-						unsigned byte_offset = m_s.CRTC.start_address + ((pixely & 1) << 13);
+						unsigned line_offset = m_s.CRTC.start_address + ((pixely & 1) << 13);
 						/* to the start of the line */
-						byte_offset += (320 / 4) * (pixely / 2);
-						/* to the byte start */
-						byte_offset += (pixelx / 8);
-
-						unsigned bit_no = 7 - (pixelx % 8);
-						uint8_t palette_reg_val = (((m_memory[byte_offset%m_memsize]) >> bit_no) & 1);
-						return m_s.attribute_ctrl.palette_reg[palette_reg_val];
+						line_offset += (320 / 4) * (pixely / 2);
+
+						for(unsigned i=0; i<count; i++) {
+							unsigned px = pixelx + i + pan;
+							/* to the byte start */
+							unsigned byte_offset = line_offset + (px / 8);
+							unsigned bit_no = 7 - (px % 8);
+							uint8_t palette_reg_val = (((m_memory[byte_offset%m_memsize]) >> bit_no) & 1);
+							dst[i] = m_s.attribute_ctrl.palette_reg[palette_reg_val];
+						}
 					},
 					false);
 
@@ -1508,10 +1598,12 @@ void VGA::update(uint64_t _time)
 					plane[2] = &m_memory[2 << m_s.plane_shift];
 					plane[3] = &m_memory[3 << m_s.plane_shift];
 					uint16_t line_compare = m_s.line_compare >> m_s.y_doublescan;
+					uint8_t dac[16];
+					get_vga_dac_table(cs_visible, dac);
 
-					gfx_update([=] (unsigned pixelx, unsigned pixely)
+					gfx_update([=] (unsigned pixelx, unsigned pixely, uint8_t *dst, unsigned count)
 					{
-						return get_vga_pixel(pixelx, pixely, m_s.CRTC.start_address, line_compare, cs_visible, plane);
+						get_vga_row(pixelx, pixely, m_s.CRTC.start_address, line_compare, plane, dac, dst, count);
 					},
 					cs_toggle);
 
@@ -1521,20 +1613,22 @@ void VGA::update(uint64_t _time)
 			case 1:
 				// output the data in a CGA-compatible 320x200 4 color graphics
 				// mode.  (planar shift, modes 4 & 5)
-				gfx_update([=] (unsigned pixelx, unsigned pixely)
+				gfx_update([=] (unsigned pixelx, unsigned pixely, uint8_t *dst, unsigned count)
 				{
-					pixelx = (pixelx >> m_s.x_dotclockdiv2) + pan;
 					/* 0 or 0x2000 */
-					unsigned byte_offset = m_s.CRTC.start_address + ((pixely & 1) << 13);
+					unsigned line_offset = m_s.CRTC.start_address + ((pixely & 1) << 13);
 					/* to the start of the line */
-					byte_offset += (320 / 4) * (pixely / 2);
-					/* to the byte start */
-					byte_offset += (pixelx / 4);
-
-					uint8_t attribute = 6 - 2*(pixelx % 4);
-					uint8_t palette_reg_val = (m_memory[byte_offset%m_memsize]) >> attribute;
-					palette_reg_val &= 3;
-					return m_s.attribute_ctrl.palette_reg[palette_reg_val];
+					line_offset += (320 / 4) * (pixely / 2);
+
+					for(unsigned i=0; i<count; i++) {
+						unsigned px = ((pixelx + i) >> m_s.x_dotclockdiv2) + pan;
+						/* to the byte start */
+						unsigned byte_offset = line_offset + (px / 4);
+						uint8_t attribute = 6 - 2*(px % 4);
+						uint8_t palette_reg_val = (m_memory[byte_offset%m_memsize]) >> attribute;
+						palette_reg_val &= 3;
+						dst[i] = m_s.attribute_ctrl.palette_reg[palette_reg_val];
+					}
 				},
 				false);
 				break;
@@ -1728,7 +1822,6 @@ void VGA::vertical_retrace(uint64_t _time)
 
 	//next is the "vblank start"
 	uint64_t vbstart = (m_s.vtotal_usec - m_s.vrstart_usec) + m_s.vblank_usec;
-	g_machine.set_timer_callback(m_timer_id, std::bind(&VGA::update,this,_1));
 	g_machine.activate_timer(m_timer_id, vbstart*1_us, false);
 }
 
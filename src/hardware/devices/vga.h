@@ -23,6 +23,7 @@
 
 #include "vgacrtc.h"
 #include "vgadisplay.h"
+#include "vgaworkers.h"
 #include "hardware/iodevice.h"
 
 /* Video timings - values taken from PCem
@@ -69,7 +70,7 @@ enum VGATimings {
 	VGA_32BIT_FAST
 };
 
-#define VGA_WORKERS 4
+#define VGA_WORKERS 4 // max number of rendering threads when not configured
 
 // text mode blink feature
 #define TEXT_BLINK_MODE      0x01
@@ -234,7 +235,10 @@ protected:
 	uint8_t *m_memory;
 	uint8_t *m_rom;
 	bool *m_tile_updated;
-	int m_timer_id;
+	std::vector<unsigned> m_dirty_tiles;
+	VGAWorkers m_workers;
+	int m_timer_id;         // vertical blank start
+	int m_retrace_timer_id; // vertical retrace start
 	VGADisplay * m_display;
 	int m_mem_mapping;
 	int m_rom_mapping;
@@ -251,6 +255,7 @@ public:
 	void reset(unsigned type);
 	uint16_t read(uint16_t address, uint io_len);
 	void write(uint16_t address, uint16_t value, uint io_len);
+	uint64_t read_stable_until(uint16_t address);
 	void power_off();
 
 	void set_timings(double _bus, VGATimings _vga) {
@@ -268,7 +273,9 @@ protected:
 	void redraw_area(uint x0, uint y0, uint width, uint height);
 	void init_iohandlers();
 	void init_systemtimer();
-	uint8_t get_vga_pixel(uint16_t x, uint16_t y, uint16_t saddr, uint16_t lc, bool bs, uint8_t * const *plane);
+	void get_vga_dac_table(bool bs, uint8_t *dac_);
+	void get_vga_row(uint16_t x, uint16_t y, uint16_t saddr, uint16_t lc,
+			uint8_t * const *plane, const uint8_t *dac, uint8_t *dst_, unsigned count);
 	void update(uint64_t _time);
 	void vertical_retrace(uint64_t _time);
 	void determine_screen_dimensions(uint *piHeight, uint *piWidth);
@@ -279,9 +286,9 @@ protected:
 	void clear_screen();
 
 	template<typename FN>
-	void gfx_update(FN _get_pixel, bool _force_upd);
+	void gfx_update(FN _get_row, bool _force_upd);
 	template<typename FN>
-	void gfx_update_core(FN _get_pixel, bool _force_upd, int id, int pool_size);
+	void gfx_update_tile(FN _get_row, unsigned _xti, unsigned _yti);
 	template <typename FN>
 	void update_mode13(FN _pixel_x, unsigned _pan);
 
@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2018  Marco Bortolin
+ *
+ * This file is part of IBMulator.
+ *
+ * IBMulator is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * IBMulator is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with IBMulator.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ibmulator.h"
+#include "vgaworkers.h"
+#include <algorithm>
+
+
+VGAWorkers::VGAWorkers()
+:
+m_generation(0),
+m_pending(0),
+m_quit(false),
+m_count(1),
+m_items(nullptr),
+m_job(nullptr)
+{
+	void *buf = m_ranges_buf;
+	size_t space = sizeof(m_ranges_buf);
+	buf = std::align(VGA_CACHE_LINE, sizeof(Range) * VGA_MAX_WORKERS, buf, space);
+	assert(buf);
+	m_ranges = static_cast<Range*>(buf);
+	for(unsigned i=0; i<VGA_MAX_WORKERS; i++) {
+		Range *range = new(&m_ranges[i]) Range;
+		range->next = 0;
+		range->end = 0;
+	}
+}
+
+VGAWorkers::~VGAWorkers()
+{
+	stop();
+}
+
+void VGAWorkers::start(unsigned _count)
+{
+	_count = std::max(1u, std::min(_count, unsigned(VGA_MAX_WORKERS)));
+	if(_count == m_count && m_threads.size() == _count - 1) {
+		return;
+	}
+	stop();
+	m_count = _count;
+	m_quit = false;
+	for(unsigned id=1; id<m_count; id++) {
+		m_threads.emplace_back(&VGAWorkers::thread_loop, this, id, m_generation);
+	}
+	PDEBUGF(LOG_V1, LOG_VGA, "rendering threads: %u\n", m_count);
+}
+
+void VGAWorkers::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_quit = true;
+	}
+	m_start_cv.notify_all();
+	for(auto &thread : m_threads) {
+		thread.join();
+	}
+	m_threads.clear();
+	m_count = 1;
+}
+
+void VGAWorkers::run(const std::vector<unsigned> &_items, const job_fun_t &_job)
+{
+	unsigned size = _items.size();
+	if(m_threads.empty() || size < 2) {
+		for(auto item : _items) {
+			_job(item);
+		}
+		return;
+	}
+
+	unsigned chunk = (size + m_count - 1) / m_count;
+	for(unsigned id=0; id<m_count; id++) {
+		m_ranges[id].next = std::min(size, id * chunk);
+		m_ranges[id].end = std::min(size, (id + 1) * chunk);
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_items = &_items;
+		m_job = &_job;
+		m_pending = m_count - 1;
+		m_generation++;
+	}
+	m_start_cv.notify_all();
+
+	process(0);
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_done_cv.wait(lock, [this]{ return m_pending == 0; });
+	m_items = nullptr;
+	m_job = nullptr;
+}
+
+void VGAWorkers::thread_loop(unsigned _id, uint64_t _generation)
+{
+	// the generation is the one of start(), any later job must be processed
+	uint64_t generation = _generation;
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while(true) {
+		m_start_cv.wait(lock, [&]{ return m_quit || m_generation != generation; });
+		if(m_quit) {
+			return;
+		}
+		generation = m_generation;
+		lock.unlock();
+
+		process(_id);
+
+		lock.lock();
+		if(--m_pending == 0) {
+			m_done_cv.notify_one();
+		}
+	}
+}
+
+void VGAWorkers::process(unsigned _id)
+{
+	// own range first, then steal from the others
+	for(unsigned r=0; r<m_count; r++) {
+		Range &range = m_ranges[(_id + r) % m_count];
+		unsigned i;
+		while((i = range.next.fetch_add(1)) < range.end) {
+			(*m_job)((*m_items)[i]);
+		}
+	}
+}
@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2018  Marco Bortolin
+ *
+ * This file is part of IBMulator.
+ *
+ * IBMulator is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * IBMulator is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with IBMulator.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef IBMULATOR_HW_VGAWORKERS_H
+#define IBMULATOR_HW_VGAWORKERS_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#define VGA_MAX_WORKERS 32
+#define VGA_CACHE_LINE  64
+
+/* Persistent pool of threads for the VGA rendering.
+ * The items of a job (the dirty tiles of a frame) are split in one contiguous
+ * range per worker. A worker renders the items of its own range, then steals
+ * the remaining ones from the ranges of the other workers, so uneven dirty
+ * regions are balanced. The calling thread is worker 0 and run() returns when
+ * every item has been processed.
+ */
+class VGAWorkers
+{
+public:
+	typedef std::function<void(unsigned)> job_fun_t;
+
+private:
+	// one cache line per range; the VGA is allocated with new, which doesn't
+	// honour alignas, so the ranges are placed in an over-allocated buffer
+	struct Range {
+		std::atomic<unsigned> next;
+		unsigned end;
+		uint8_t pad[VGA_CACHE_LINE - sizeof(std::atomic<unsigned>) - sizeof(unsigned)];
+	};
+	uint8_t m_ranges_buf[sizeof(Range) * VGA_MAX_WORKERS + VGA_CACHE_LINE];
+	Range *m_ranges;
+
+	std::vector<std::thread> m_threads;
+	std::mutex m_mutex;
+	std::condition_variable m_start_cv;
+	std::condition_variable m_done_cv;
+	uint64_t m_generation;
+	unsigned m_pending;
+	bool m_quit;
+	unsigned m_count;
+
+	const std::vector<unsigned> *m_items;
+	const job_fun_t *m_job;
+
+public:
+	VGAWorkers();
+	~VGAWorkers();
+
+	void start(unsigned _count);
+	void stop();
+	inline unsigned count() const { return m_count; }
+
+	void run(const std::vector<unsigned> &_items, const job_fun_t &_job);
+
+private:
+	void thread_loop(unsigned _id, uint64_t _generation);
+	void process(unsigned _id);
+};
+
+#endif
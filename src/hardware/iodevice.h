@@ -63,6 +63,17 @@ public:
 	virtual void config_changed() {}
 	virtual uint16_t read(uint16_t /*_address*/, unsigned /*_io_len*/) { return ~0; }
 	virtual void write(uint16_t /*_address*/, uint16_t /*_value*/, unsigned /*_io_len*/) {}
+	// the virtual time (ns) until which reads of the port return the same
+	// value, 0 if the value is not a function of the virtual time only
+	virtual uint64_t read_stable_until(uint16_t /*_address*/) { return 0; }
+	// bulk transfer of up to _count elements of _io_len bytes through a data
+	// register (REP INS/OUTS), returns the number of elements transferred, 0
+	// if not supported; the device state must be the same as if the elements
+	// were transferred with read()/write()
+	virtual unsigned read_block(uint16_t /*_address*/, uint8_t */*_buf*/,
+			unsigned /*_count*/, unsigned /*_io_len*/) { return 0; }
+	virtual unsigned write_block(uint16_t /*_address*/, const uint8_t */*_buf*/,
+			unsigned /*_count*/, unsigned /*_io_len*/) { return 0; }
 	virtual void save_state(StateBuf &) {}
 	virtual void restore_state(StateBuf &) {}
 
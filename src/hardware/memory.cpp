@@ -24,6 +24,7 @@
 #include "machine.h"
 #include "hardware/cpu.h"
 #include "hardware/cpu/mmu.h"
+#include "hardware/cpu/icache.h"
 #include "hardware/devices/vga.h"
 #include <fstream>
 #include <cstring>
@@ -37,6 +38,8 @@ Memory g_memory;
 
 Memory::Memory()
 :
+m_traps_namecnt(0),
+m_traps_checking(0),
 m_mappings_namecnt(0)
 {
 	/* The 286 and the 386SX both have a 24-bit address bus. The 386DX has a
@@ -81,6 +84,7 @@ void Memory::init()
 void Memory::reset()
 {
 	memset(m_ram.buffer, 0, m_ram.buffer_size);
+	g_cpuicache.flush();
 	set_A20_line(true);
 }
 
@@ -285,11 +289,13 @@ void Memory::set_A20_line(bool _enabled)
 		m_s.A20_enabled = true;
 		m_s.mask = 0x00ffffff; // 24-bit address bus
 		g_cpummu.TLB_flush();
+		g_cpuicache.flush();
 	} else if(!_enabled && m_s.A20_enabled) {
 		PDEBUGF(LOG_V2, LOG_MEM, "A20 line DISABLED\n");
 		m_s.A20_enabled = false;
 		m_s.mask = 0x00efffff; // 24-bit address bus with A20 masked
 		g_cpummu.TLB_flush();
+		g_cpuicache.flush();
 	}
 }
 
@@ -350,6 +356,7 @@ template<>
 void Memory::write_mapped<1>(uint32_t _addr, uint32_t _data, int &_cycles) noexcept
 {
 	_addr &= m_s.mask;
+	g_cpuicache.write_notify(_addr, 1);
 	MemMapping *map = m_map[_addr / MEM_MAP_GRANULARITY].write;
 	if(map->write.byte) {
 		_cycles += map->cycles.byte;
@@ -361,6 +368,7 @@ template<>
 void Memory::write_mapped<2>(uint32_t _addr, uint32_t _data, int &_cycles) noexcept
 {
 	_addr &= m_s.mask;
+	g_cpuicache.write_notify(_addr, 2);
 	MemMapping *map = m_map[_addr / MEM_MAP_GRANULARITY].write;
 	if(map->write.word) {
 		if((_addr&0x1) && (map->flags&MEM_MAPPING_EXTERNAL)) {
@@ -385,6 +393,7 @@ template<>
 void Memory::write_mapped<4>(uint32_t _addr, uint32_t _data, int &_cycles) noexcept
 {
 	_addr &= m_s.mask;
+	g_cpuicache.write_notify(_addr, 4);
 	MemMapping *map = m_map[_addr / MEM_MAP_GRANULARITY].write;
 	if(map->write.dword) {
 		_cycles += map->cycles.dword;
@@ -395,6 +404,19 @@ void Memory::write_mapped<4>(uint32_t _addr, uint32_t _data, int &_cycles) noexc
 	write_mapped<2>(_addr+2, (_data>>16), _cycles);
 }
 
+bool Memory::is_code_cacheable(uint32_t _addr) const noexcept
+{
+	/* Code can be cached only if its content can change exclusively through
+	 * write_mapped(), ie. system RAM or read-only memory (ROMs).
+	 */
+	_addr &= m_s.mask;
+	const MemMapping *map = m_map[_addr / MEM_MAP_GRANULARITY].read;
+	if(map->name == m_ram.low_mapping || map->name == m_ram.high_mapping) {
+		return true;
+	}
+	return (!map->write.byte && !map->write.word && !map->write.dword);
+}
+
 uint8_t * Memory::get_buffer_ptr(uint32_t _addr)
 {
 	_addr &= m_s.mask;
@@ -404,19 +426,88 @@ uint8_t * Memory::get_buffer_ptr(uint32_t _addr)
 	return &m_ram.buffer[_addr];
 }
 
+uint8_t * Memory::get_ram_ptr(uint32_t _addr, uint32_t _len, bool _write) const noexcept
+{
+	/* Returns nullptr if the block is not entirely mapped to RAM or if memory
+	 * traps are registered on any of its pages.
+	 */
+	_addr &= m_s.mask;
+	if(_len == 0 || (_addr / MEM_MAP_GRANULARITY) != ((_addr+_len-1) / MEM_MAP_GRANULARITY)) {
+		return nullptr;
+	}
+	const MapEntry &entry = m_map[_addr / MEM_MAP_GRANULARITY];
+	const MemMapping *map = _write ? entry.write : entry.read;
+	if(map->name != m_ram.low_mapping && map->name != m_ram.high_mapping) {
+		return nullptr;
+	}
+	#if MEMORY_TRAPS
+	if(has_traps(_addr, _len, _write ? MEM_TRAP_WRITE : MEM_TRAP_READ)) {
+		return nullptr;
+	}
+	#endif
+	return &m_ram.buffer[_addr];
+}
+
+uint8_t * Memory::get_ram_block(uint32_t _addr, uint32_t _len, bool _write) noexcept
+{
+	/* Direct access to a block of system RAM for bulk operations.
+	 * When _write is true the block is considered written and the decoded
+	 * instructions cache is notified.
+	 */
+	uint8_t *block = get_ram_ptr(_addr, _len, _write);
+	if(block && _write) {
+		g_cpuicache.write_notify(_addr & m_s.mask, _len);
+	}
+	return block;
+}
+
+uint8_t * Memory::get_ram_page(uint32_t _addr, bool _write) const noexcept
+{
+	/* Direct access to a 4K page of system RAM for the host TLB (see CPUMMU).
+	 * The returned pointer is valid until the next remap() or trap
+	 * registration, which flush the TLBs.
+	 */
+	return get_ram_ptr(_addr & ~0xFFF, 4096, _write);
+}
+
 void Memory::DMA_read(uint32_t _addr, uint16_t _len, uint8_t *_buf)
 {
+	/* The transfer is split at the mapping granularity, blocks of RAM without
+	 * traps are copied in one go, anything else goes through the mappings.
+	 */
 	int c;
-	for(uint16_t i=0; i<_len; i++) {
-		_buf[i] = read<1>(_addr+i, c);
+	while(_len) {
+		uint16_t chunk = std::min(uint32_t(_len), MEM_MAP_GRANULARITY - (_addr % MEM_MAP_GRANULARITY));
+		uint8_t *block = get_ram_block(_addr, chunk, false);
+		if(block) {
+			memcpy(_buf, block, chunk);
+		} else {
+			for(uint16_t i=0; i<chunk; i++) {
+				_buf[i] = read_t<1>(_addr+i, 1, c);
+			}
+		}
+		_addr += chunk;
+		_buf += chunk;
+		_len -= chunk;
 	}
 }
 
 void Memory::DMA_write(uint32_t _addr, uint16_t _len, uint8_t *_buf)
 {
 	int c;
-	for(uint16_t i=0; i<_len; i++) {
-		write<1>(_addr+i, _buf[i], c);
+	while(_len) {
+		uint16_t chunk = std::min(uint32_t(_len), MEM_MAP_GRANULARITY - (_addr % MEM_MAP_GRANULARITY));
+		uint8_t *block = get_ram_block(_addr, chunk, true);
+		if(block) {
+			memcpy(block, _buf, chunk);
+		} else {
+			for(uint16_t i=0; i<chunk; i++) {
+				write_t<1>(_addr+i, _buf[i], 1, c);
+			}
+		}
+		_addr += chunk;
+		_buf += chunk;
+		_len -= chunk;
 	}
 }
 
@@ -461,6 +552,7 @@ void Memory::remap(uint32_t _start, uint32_t _end)
 		}
 	}
 	g_cpummu.TLB_flush();
+	g_cpuicache.flush();
 }
 
 bool Memory::MemMapping::read_is_allowed(unsigned _state)
@@ -568,27 +660,104 @@ void Memory::dump(const std::string &_filename, uint32_t _address, uint _len)
 	file.close();
 }
 
+bool Memory::has_traps(uint32_t _addr, uint32_t _len, uint8_t _mask) const noexcept
+{
+	unsigned first = (_addr & m_s.mask) >> MEM_TRAP_PAGE_SHIFT;
+	unsigned last = ((_addr + _len - 1) & m_s.mask) >> MEM_TRAP_PAGE_SHIFT;
+	for(unsigned p = first; p <= last; p++) {
+		const TrapPage &page = m_trap_pages[p];
+		if(((_mask & MEM_TRAP_READ) && page.read) || ((_mask & MEM_TRAP_WRITE) && page.write)) {
+			return true;
+		}
+	}
+	return false;
+}
+
 void Memory::check_trap(uint32_t _address, uint8_t _mask, uint32_t _value, unsigned _len)
 const noexcept
 {
 	if(MEMORY_TRAPS) {
-		std::vector<memtrap_interval_t> results;
-		m_traps_tree.findOverlapping(_address, _address, results);
-		for(auto t : results) {
-			if(t.value.mask & _mask) {
-				t.value.func(_address, _mask, _value, _len);
+		/* The page counters filter out the vast majority of accesses without
+		 * looking at the traps. The traps list is indexed every iteration
+		 * because a trap function can register traps. Traps unregistered by a
+		 * trap function are only marked as removed and are deleted when the
+		 * outermost check ends, as they could be the one being executed.
+		 */
+		const TrapPage &page = m_trap_pages[(_address & m_s.mask) >> MEM_TRAP_PAGE_SHIFT];
+		if(!((_mask & MEM_TRAP_READ) ? page.read : page.write)) {
+			return;
+		}
+		m_traps_checking++;
+		for(size_t i = 0; i < page.traps.size(); i++) {
+			const memtrap_t *t = page.traps[i];
+			if(!t->removed && (t->mask & _mask) && _address >= t->lo && _address <= t->hi) {
+				t->func(_address, _mask, _value, _len);
 				if(STOP_AT_MEM_TRAPS) {
 					g_machine.set_single_step(true);
 				}
 			}
 		}
+		m_traps_checking--;
+		if(!m_traps_checking && !m_traps_removed.empty()) {
+			Memory *self = const_cast<Memory*>(this);
+			for(int id : self->m_traps_removed) {
+				self->remove_trap(id);
+			}
+			self->m_traps_removed.clear();
+		}
 	}
 }
 
-void Memory::register_trap(uint32_t _lo, uint32_t _hi, uint _mask, memtrap_fun_t _fn)
+int Memory::register_trap(uint32_t _lo, uint32_t _hi, uint _mask, memtrap_fun_t _fn)
 {
-	m_traps_intervals.push_back(memtrap_interval_t(_lo, _hi, memtrap_t(_mask, _fn)));
-	m_traps_tree = memtrap_intervalTree_t(m_traps_intervals);
+	/* Traps are added to and removed from the pages they overlap, so the cost
+	 * of a (un)registration is proportional to the size of the trap.
+	 */
+	_lo &= m_s.mask;
+	_hi &= m_s.mask;
+	if(_hi < _lo) {
+		PERRF(LOG_MEM, "invalid memory trap [0x%06X,0x%06X]\n", _lo, _hi);
+		throw std::exception();
+	}
+	int id = m_traps_namecnt++;
+	const memtrap_t &trap = m_traps.emplace(id, memtrap_t(_lo, _hi, _mask, _fn)).first->second;
+	for(unsigned p = _lo >> MEM_TRAP_PAGE_SHIFT; p <= (_hi >> MEM_TRAP_PAGE_SHIFT); p++) {
+		m_trap_pages[p].traps.push_back(&trap);
+		m_trap_pages[p].read += bool(_mask & MEM_TRAP_READ);
+		m_trap_pages[p].write += bool(_mask & MEM_TRAP_WRITE);
+	}
+	// RAM pages with traps can't be accessed directly anymore
+	g_cpummu.host_TLB_flush();
+	return id;
+}
+
+void Memory::unregister_trap(int _trap)
+{
+	auto it = m_traps.find(_trap);
+	if(it == m_traps.end() || it->second.removed) {
+		return;
+	}
+	if(m_traps_checking) {
+		it->second.removed = true;
+		m_traps_removed.push_back(_trap);
+		return;
+	}
+	remove_trap(_trap);
+}
+
+void Memory::remove_trap(int _trap)
+{
+	auto it = m_traps.find(_trap);
+	assert(it != m_traps.end());
+	const memtrap_t &trap = it->second;
+	for(unsigned p = trap.lo >> MEM_TRAP_PAGE_SHIFT; p <= (trap.hi >> MEM_TRAP_PAGE_SHIFT); p++) {
+		auto &traps = m_trap_pages[p].traps;
+		traps.erase(std::find(traps.begin(), traps.end(), &trap));
+		m_trap_pages[p].read -= bool(trap.mask & MEM_TRAP_READ);
+		m_trap_pages[p].write -= bool(trap.mask & MEM_TRAP_WRITE);
+	}
+	m_traps.erase(it);
+	g_cpummu.host_TLB_flush();
 }
 
 void Memory::s_debug_trap(uint32_t _address,  // address
@@ -22,8 +22,9 @@
 
 #include "model.h"
 #include "statebuf.h"
-#include "interval_tree.h"
 #include "devices/hddparams.h"
+#include <map>
+#include <vector>
 
 #define KEBIBYTE           1024u
 #define MEBIBYTE           (1024u * KEBIBYTE)
@@ -72,16 +73,19 @@ typedef std::function<void(
 	)> memtrap_fun_t;
 
 struct memtrap_t {
+	uint32_t lo, hi;
 	uint mask;
 	memtrap_fun_t func;
+	bool removed; // unregistered while the traps were being checked
 
-	memtrap_t() : mask(0) {};
-	memtrap_t(uint _mask, memtrap_fun_t _func)
-	:  mask(_mask), func(_func) {}
+	memtrap_t() : lo(0), hi(0), mask(0), removed(false) {};
+	memtrap_t(uint32_t _lo, uint32_t _hi, uint _mask, memtrap_fun_t _func)
+	:  lo(_lo), hi(_hi), mask(_mask), func(_func), removed(false) {}
 };
 
-typedef Interval<memtrap_t> memtrap_interval_t;
-typedef IntervalTree<memtrap_t> memtrap_intervalTree_t;
+// traps are filtered with a 4K page granularity before being looked up
+#define MEM_TRAP_PAGE_SHIFT 12
+#define MEM_TRAP_PAGES      (MAX_MEM_SIZE >> MEM_TRAP_PAGE_SHIFT)
 
 typedef uint32_t (*mem_read_fn_t)(uint32_t _address, void *_privdata);
 typedef void (*mem_write_fn_t)(uint32_t _address, uint32_t _value, void *_privdata);
@@ -106,8 +110,14 @@ protected:
 		unsigned mapstate[MEM_MAP_SIZE];
 	} m_s;
 
-	memtrap_intervalTree_t m_traps_tree;
-	std::vector<memtrap_interval_t> m_traps_intervals;
+	std::map<int, memtrap_t> m_traps;
+	int m_traps_namecnt;
+	mutable unsigned m_traps_checking; // check_trap() nesting level
+	std::vector<int> m_traps_removed;  // removals deferred until the check ends
+	struct TrapPage {
+		uint16_t read, write;                 // number of read and write traps
+		std::vector<const memtrap_t*> traps; // the traps overlapping the page
+	} m_trap_pages[MEM_TRAP_PAGES];
 
 	struct MemMapping
 	{
@@ -177,8 +187,12 @@ public:
 
 	void set_A20_line(bool _enabled);
 	inline bool get_A20_line() const { return m_s.A20_enabled; }
+	inline uint32_t get_address_mask() const { return m_s.mask; }
+	bool is_code_cacheable(uint32_t _address) const noexcept;
 
 	uint8_t *get_buffer_ptr(uint32_t _address);
+	uint8_t *get_ram_block(uint32_t _address, uint32_t _len, bool _write) noexcept;
+	uint8_t *get_ram_page(uint32_t _address, bool _write) const noexcept;
 	uint32_t get_buffer_size() { return m_ram.buffer_size; }
 
 	inline int dram_cycles() const { return m_ram.cycles; }
@@ -195,13 +209,17 @@ public:
 	uint32_t dbg_read_dword(uint32_t _addr) const noexcept;
 	uint64_t dbg_read_qword(uint32_t _addr) const noexcept;
 	void dump(const std::string &_filename, uint32_t _address, uint _len);
-	void register_trap(uint32_t _lo, uint32_t _hi, uint _mask, memtrap_fun_t _fn);
+	int register_trap(uint32_t _lo, uint32_t _hi, uint _mask, memtrap_fun_t _fn);
+	void unregister_trap(int _trap);
 	static void s_debug_trap(uint32_t _address, uint8_t _rw, uint32_t _value, uint8_t _len);
 	static void s_debug_trap_ASCII(uint32_t _address, uint8_t _rw, uint32_t _value, uint8_t _len);
 	static void s_debug_40h_trap(uint32_t _address, uint8_t _rw, uint32_t _value, uint8_t _len);
 
 private:
 	void remap(uint32_t _start, uint32_t _end);
+	uint8_t *get_ram_ptr(uint32_t _address, uint32_t _len, bool _write) const noexcept;
+	bool has_traps(uint32_t _address, uint32_t _len, uint8_t _mask) const noexcept;
+	void remove_trap(int _trap);
 
 	// read functions for CPUBus
 	template<unsigned LEN> inline
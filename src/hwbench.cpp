@@ -22,6 +22,8 @@
 #include <iostream>
 #include <cfloat>
 #include <climits>
+#include <cstring>
+#include <algorithm>
 #include "chrono.h"
 #include "hwbench.h"
 
@@ -35,6 +37,8 @@ m_upd_interval(1000),
 m_reset(true),
 m_icount(0),
 m_ccount(0),
+m_icount_total(0),
+m_ccount_total(0),
 
 ustart(0),
 uend(0),
@@ -77,6 +81,8 @@ void HWBench::beat_start()
 		m_beat_count = 0;
 		m_min_btime = UINT_MAX;
 		m_max_btime = 0;
+		m_icount_total += m_icount;
+		m_ccount_total += m_ccount;
 		m_icount = 0;
 		m_ccount = 0;
 		m_reset = false;
@@ -125,6 +131,84 @@ void HWBench::data_update()
 }
 
 
+void HWBench::sample(const std::string &_phase, uint64_t _virt_ns)
+{
+	if(_phase.empty() && (m_samples.empty() || m_samples.back().phase.empty())) {
+		// there's no phase to end
+		return;
+	}
+	m_samples.push_back({
+		_phase, _virt_ns, m_chrono->get_usec(), get_icount(), get_ccount()
+	});
+}
+
+
+static std::string json_escape(const std::string &_str)
+{
+	static const char *hex = "0123456789abcdef";
+	std::string res;
+	for(unsigned char c : _str) {
+		switch(c) {
+			case '"':  res += "\\\""; break;
+			case '\\': res += "\\\\"; break;
+			case '\n': res += "\\n"; break;
+			case '\r': res += "\\r"; break;
+			case '\t': res += "\\t"; break;
+			default:
+				if(c < 0x20) {
+					res += "\\u00";
+					res += hex[c >> 4];
+					res += hex[c & 0xF];
+				} else {
+					res += c;
+				}
+				break;
+		}
+	}
+	return res;
+}
+
+void HWBench::write_json(std::ostream &_os) const
+{
+	auto write_phase = [&](const std::string &_name, const Sample &_s0, const Sample &_s1) {
+		uint64_t host_us = _s1.host_us - _s0.host_us;
+		uint64_t icount = _s1.icount - _s0.icount;
+		uint64_t ccount = _s1.ccount - _s0.ccount;
+		double secs = double(host_us) / 1.0e6;
+		_os << "    {\n";
+		_os << "      \"name\": \"" << json_escape(_name) << "\",\n";
+		_os << "      \"virtual_time_ms\": " << (_s1.virt_ns - _s0.virt_ns) / 1000000 << ",\n";
+		_os << "      \"wall_time_ms\": " << host_us / 1000 << ",\n";
+		_os << "      \"instructions\": " << icount << ",\n";
+		_os << "      \"cycles\": " << ccount << ",\n";
+		_os << "      \"instructions_per_sec\": " << (secs>0 ? uint64_t(icount/secs) : 0) << ",\n";
+		_os << "      \"cycles_per_sec\": " << (secs>0 ? uint64_t(ccount/secs) : 0) << "\n";
+		_os << "    }";
+	};
+
+	_os << "{\n";
+	_os << "  \"version\": \"" PACKAGE_VERSION "\",\n";
+	_os << "  \"phases\": [\n";
+	bool first = true;
+	for(size_t i=1; i<m_samples.size(); i++) {
+		if(m_samples[i-1].phase.empty()) {
+			continue;
+		}
+		if(!first) {
+			_os << ",\n";
+		}
+		first = false;
+		write_phase(m_samples[i-1].phase, m_samples[i-1], m_samples[i]);
+	}
+	_os << "\n  ]";
+	if(m_samples.size() > 1) {
+		_os << ",\n  \"total\":\n";
+		write_phase("total", m_samples.front(), m_samples.back());
+	}
+	_os << "\n}\n";
+}
+
+
 void operator<<(std::ostream& _os, const HWBench &_bench)
 {
 	_os << "Sim time (us): " << _bench.time_elapsed << _bench.endl;
@@ -148,3 +232,84 @@ void operator<<(std::ostream& _os, const HWBench &_bench)
 }
 
 
+HWProfiler g_hwprof;
+thread_local uint64_t HWProfiler::ms_measured = 0;
+
+
+HWProfiler::HWProfiler()
+:
+m_count(FIXED_COUNTERS),
+m_enabled(false)
+{
+	for(auto &c : m_counters) {
+		c.name[0] = 0;
+		c.ns = 0;
+		c.calls = 0;
+	}
+	snprintf(m_counters[OTHER].name, HWPROF_NAME_LEN, "other");
+	snprintf(m_counters[CPU_DECODE].name, HWPROF_NAME_LEN, "CPU decode");
+	snprintf(m_counters[CPU_EXECUTE].name, HWPROF_NAME_LEN, "CPU execute");
+	snprintf(m_counters[VGA_RENDER].name, HWPROF_NAME_LEN, "VGA render");
+	snprintf(m_counters[MIXER].name, HWPROF_NAME_LEN, "mixer");
+}
+
+
+unsigned HWProfiler::register_counter(const std::string &_name)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	char name[HWPROF_NAME_LEN];
+	snprintf(name, HWPROF_NAME_LEN, "%s", _name.c_str());
+	for(unsigned i=1; i<m_count; i++) {
+		if(strcmp(m_counters[i].name, name) == 0) {
+			return i;
+		}
+	}
+	if(m_count >= HWPROF_MAX_COUNTERS) {
+		return OTHER;
+	}
+	unsigned id = m_count;
+	memcpy(m_counters[id].name, name, HWPROF_NAME_LEN);
+	m_count++;
+	return id;
+}
+
+
+void HWProfiler::reset()
+{
+	for(unsigned i=0; i<m_count; i++) {
+		m_counters[i].ns = 0;
+		m_counters[i].calls = 0;
+	}
+}
+
+
+void HWProfiler::get_counters(std::vector<CounterData> &_data) const
+{
+	_data.clear();
+	for(unsigned i=0; i<m_count; i++) {
+		_data.push_back({ m_counters[i].name, m_counters[i].ns, m_counters[i].calls });
+	}
+}
+
+
+void HWProfiler::write_csv(std::ostream &_os) const
+{
+	std::vector<CounterData> data;
+	get_counters(data);
+	std::sort(data.begin(), data.end(), [](const CounterData &_a, const CounterData &_b) {
+		return _a.ns > _b.ns;
+	});
+	uint64_t total = 0;
+	for(auto &c : data) {
+		total += c.ns;
+	}
+	_os << "name,calls,total_ns,avg_ns,percent\n";
+	for(auto &c : data) {
+		if(c.calls == 0) {
+			continue;
+		}
+		_os << '"' << c.name << "\"," << c.calls << "," << c.ns << ","
+		    << (c.ns / c.calls) << "," << (total ? (double(c.ns) * 100.0 / total) : 0.0) << "\n";
+	}
+}
@@ -24,6 +24,8 @@
 
 #include <iostream>
 #include <vector>
+#include <atomic>
+#include <mutex>
 #include "chrono.h"
 
 class HWBench
@@ -36,9 +38,20 @@ protected:
 	bool m_reset;
 	uint64_t m_icount;
 	uint64_t m_ccount;
+	uint64_t m_icount_total;
+	uint64_t m_ccount_total;
 
 	const Chrono *m_chrono;
 
+	struct Sample {
+		std::string phase;
+		uint64_t virt_ns;
+		uint64_t host_us;
+		uint64_t icount;
+		uint64_t ccount;
+	};
+	std::vector<Sample> m_samples;
+
 public:
 	uint64_t   init_time;
 
@@ -69,15 +82,119 @@ public:
 	void beat_start();
 	void beat_end();
 	inline void cpu_step() { m_icount++; }
+	inline void cpu_steps(uint _count) { m_icount += _count; }
 	inline void cpu_cycles(uint _cycles) { m_ccount += _cycles; }
 
 	void data_update();
+
+	inline uint64_t get_icount() const { return m_icount_total + m_icount; }
+	inline uint64_t get_ccount() const { return m_ccount_total + m_ccount; }
+
+	/* Benchmark phases: a sample ends the current phase and starts a new one
+	 * called _phase (an empty name only ends the current phase).
+	 */
+	void sample(const std::string &_phase, uint64_t _virt_ns);
+	void write_json(std::ostream &_os) const;
 };
 
 
 void operator<<(std::ostream& _os, const HWBench &_bench);
 
 
+class HWProfiler;
+extern HWProfiler g_hwprof;
+
+#define HWPROF_MAX_COUNTERS 128
+#define HWPROF_NAME_LEN     32
+
+/* Host time profiler.
+ * Attributes the host time spent by the emulator to named counters (CPU
+ * decode and execute, every timer callback, every I/O device, VGA rendering,
+ * the mixer). The time is exclusive: the time of a nested measure (eg. an I/O
+ * handler called by an instruction) is subtracted from the enclosing one.
+ * Nesting is tracked with a per-thread sum of the measured time, not with a
+ * stack of scopes, so a measure that is abandoned by a CPU fault longjmp
+ * doesn't corrupt anything, its time is simply charged to its parent.
+ * The profiler costs two clock reads per measure, so it's enabled only while
+ * the stats window is open or a benchmark is running.
+ */
+class HWProfiler
+{
+public:
+	struct Mark {
+		uint64_t start;
+		uint64_t nested;
+	};
+
+	class Scope {
+		unsigned m_id;
+		Mark m_mark;
+	public:
+		inline Scope(unsigned _id) : m_id(_id) { g_hwprof.begin(m_mark); }
+		inline ~Scope() { g_hwprof.end(m_id, m_mark); }
+	};
+
+	struct CounterData {
+		std::string name;
+		uint64_t ns;
+		uint64_t calls;
+	};
+
+private:
+	struct Counter {
+		char name[HWPROF_NAME_LEN];
+		std::atomic<uint64_t> ns;
+		std::atomic<uint64_t> calls;
+	};
+	Counter m_counters[HWPROF_MAX_COUNTERS];
+	std::atomic<unsigned> m_count;
+	std::mutex m_mutex;
+	std::atomic<bool> m_enabled;
+
+	static thread_local uint64_t ms_measured;
+
+	static inline uint64_t now() {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+public:
+	// fixed counters, OTHER collects the time of the counters that don't fit
+	enum {
+		OTHER, CPU_DECODE, CPU_EXECUTE, VGA_RENDER, MIXER,
+		FIXED_COUNTERS
+	};
+
+	HWProfiler();
+
+	unsigned register_counter(const std::string &_name);
+	inline void set_enabled(bool _enabled) { m_enabled = _enabled; }
+	inline bool is_enabled() const { return m_enabled; }
+	void reset();
+
+	inline void begin(Mark &_mark) {
+		if(m_enabled) {
+			_mark.start = now();
+			_mark.nested = ms_measured;
+		} else {
+			_mark.start = 0;
+		}
+	}
+	inline void end(unsigned _id, const Mark &_mark) {
+		if(_mark.start) {
+			uint64_t elapsed = now() - _mark.start;
+			uint64_t nested = ms_measured - _mark.nested;
+			m_counters[_id].ns += (elapsed > nested) ? (elapsed - nested) : 0;
+			m_counters[_id].calls++;
+			ms_measured = _mark.nested + elapsed;
+		}
+	}
+
+	void get_counters(std::vector<CounterData> &_data) const;
+	void write_csv(std::ostream &_os) const;
+};
+
+
 
 
 #endif
@@ -25,6 +25,12 @@
 #define THREADS_WAIT         false
 #define CHRONO_RDTSC         false
 #define USE_PREFETCH_QUEUE   true
+#define USE_ICACHE           true // decoded instructions cache, needs the prefetch queue
+#define USE_REP_BULK         true // bulk execution of REP string instructions
+#define USE_HOST_TLB         true // direct accesses to RAM pages, see CPUMMU
+#define USE_FAULT_UNWIND     true // CPU faults unwind with longjmp, see CPU::raise()
+#define USE_IDLE_SKIP        true // a halted CPU jumps to the next timer, see CPU::idle_cycles()
+#define USE_IO_POLL_SKIP     true // port polling loops jump to the next transition, see Devices::read_byte()
 #define PIT_CNT1_AUTO_UPDATE false
 
 
@@ -0,0 +1,179 @@
+/*
+ * Copyright (C) 2018  Marco Bortolin
+ *
+ * This file is part of IBMulator.
+ *
+ * IBMulator is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * IBMulator is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with IBMulator.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ibmulator.h"
+#include "inputscript.h"
+#include "machine.h"
+#include "mixer.h"
+#include "keys.h"
+#include "gui/keymap.h"
+#include <fstream>
+#include <sstream>
+#include <cstring>
+
+
+InputScript::InputScript()
+: m_next(0)
+{
+}
+
+void InputScript::load(const std::string &_path)
+{
+	std::ifstream file(_path.c_str());
+	if(!file.is_open()) {
+		PERRF(LOG_PROGRAM, "Unable to open the input script '%s'\n", _path.c_str());
+		throw std::exception();
+	}
+
+	m_commands.clear();
+	m_next = 0;
+
+	std::string line;
+	unsigned lineno = 0;
+	while(std::getline(file, line)) {
+		lineno++;
+		std::istringstream ss(line);
+		std::string cmd;
+		if(!(ss >> cmd) || cmd[0] == '#') {
+			continue;
+		}
+		if(cmd == "wait") {
+			unsigned ms;
+			if(!(ss >> ms)) {
+				PERRF(LOG_PROGRAM, "%s:%u: invalid wait time\n", _path.c_str(), lineno);
+				throw std::exception();
+			}
+			m_commands.push_back({CMD_WAIT, lineno, uint64_t(ms)*1000000, {}, ""});
+		} else if(cmd == "key") {
+			std::vector<uint32_t> keys;
+			std::string name;
+			while(ss >> name) {
+				uint32_t key = g_keymap.convert_string_to_key(name.c_str());
+				if(key == KEYMAP_UNKNOWN) {
+					PERRF(LOG_PROGRAM, "%s:%u: unknown key '%s'\n", _path.c_str(), lineno, name.c_str());
+					throw std::exception();
+				}
+				keys.push_back(key);
+			}
+			if(keys.empty()) {
+				PERRF(LOG_PROGRAM, "%s:%u: no keys specified\n", _path.c_str(), lineno);
+				throw std::exception();
+			}
+			add_keys(lineno, keys);
+		} else if(cmd == "type") {
+			std::string text;
+			std::getline(ss >> std::ws, text);
+			for(char c : text) {
+				std::vector<uint32_t> keys;
+				if(!char_to_keys(c, keys)) {
+					PERRF(LOG_PROGRAM, "%s:%u: can't type '%c'\n", _path.c_str(), lineno, c);
+					throw std::exception();
+				}
+				add_keys(lineno, keys);
+			}
+		} else if(cmd == "audio_capture") {
+			m_commands.push_back({CMD_AUDIO_CAPTURE, lineno, 0, {}, ""});
+		} else if(cmd == "phase") {
+			std::string name;
+			if(!(ss >> name)) {
+				PERRF(LOG_PROGRAM, "%s:%u: no phase name specified\n", _path.c_str(), lineno);
+				throw std::exception();
+			}
+			m_commands.push_back({CMD_PHASE, lineno, 0, {}, name});
+		} else if(cmd == "quit") {
+			m_commands.push_back({CMD_QUIT, lineno, 0, {}, ""});
+		} else {
+			PERRF(LOG_PROGRAM, "%s:%u: unknown command '%s'\n", _path.c_str(), lineno, cmd.c_str());
+			throw std::exception();
+		}
+	}
+
+	PINFOF(LOG_V1, LOG_PROGRAM, "Input script '%s': %u commands\n", _path.c_str(),
+			unsigned(m_commands.size()));
+}
+
+void InputScript::add_keys(unsigned _line, std::vector<uint32_t> _keys)
+{
+	Command cmd = {CMD_KEYS, _line, 0, _keys, ""};
+	for(auto key = _keys.rbegin(); key != _keys.rend(); key++) {
+		cmd.keys.push_back(*key | KEY_RELEASED);
+	}
+	m_commands.push_back(cmd);
+	m_commands.push_back({CMD_WAIT, _line, uint64_t(INPUTSCRIPT_KEY_DELAY)*1000000, {}, ""});
+}
+
+bool InputScript::char_to_keys(char _c, std::vector<uint32_t> &keys_)
+{
+	static const char *unshifted = "`1234567890-=[]\\;',./";
+	static const char *shifted   = "~!@#$%^&*()_+{}|:\"<>?";
+	static const uint32_t symbols[] = {
+		KEY_GRAVE, KEY_1, KEY_2, KEY_3, KEY_4, KEY_5, KEY_6, KEY_7, KEY_8,
+		KEY_9, KEY_0, KEY_MINUS, KEY_EQUALS, KEY_LEFT_BRACKET,
+		KEY_RIGHT_BRACKET, KEY_BACKSLASH, KEY_SEMICOLON, KEY_SINGLE_QUOTE,
+		KEY_COMMA, KEY_PERIOD, KEY_SLASH
+	};
+
+	if(_c >= 'a' && _c <= 'z') {
+		keys_.push_back(KEY_A + (_c - 'a'));
+	} else if(_c >= 'A' && _c <= 'Z') {
+		keys_.push_back(KEY_SHIFT_L);
+		keys_.push_back(KEY_A + (_c - 'A'));
+	} else if(_c == ' ') {
+		keys_.push_back(KEY_SPACE);
+	} else if(_c && strchr(unshifted, _c)) {
+		keys_.push_back(symbols[strchr(unshifted, _c) - unshifted]);
+	} else if(_c && strchr(shifted, _c)) {
+		keys_.push_back(KEY_SHIFT_L);
+		keys_.push_back(symbols[strchr(shifted, _c) - shifted]);
+	} else {
+		return false;
+	}
+	return true;
+}
+
+bool InputScript::run(Machine *_machine, Mixer *_mixer, uint64_t &wait_ns_)
+{
+	wait_ns_ = 0;
+	while(m_next < m_commands.size()) {
+		const Command &cmd = m_commands[m_next++];
+		switch(cmd.type) {
+			case CMD_WAIT:
+				if(cmd.wait_ns) {
+					wait_ns_ = cmd.wait_ns;
+					return true;
+				}
+				break;
+			case CMD_KEYS:
+				for(auto key : cmd.keys) {
+					_machine->send_key_to_kbctrl(key);
+				}
+				break;
+			case CMD_AUDIO_CAPTURE:
+				_mixer->cmd_toggle_capture();
+				break;
+			case CMD_PHASE:
+				_machine->bench_sample(cmd.name);
+				break;
+			case CMD_QUIT:
+				PINFOF(LOG_V1, LOG_PROGRAM, "Input script: quit at line %u\n", cmd.line);
+				return false;
+		}
+	}
+	return true;
+}
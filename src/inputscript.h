@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2018  Marco Bortolin
+ *
+ * This file is part of IBMulator.
+ *
+ * IBMulator is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * IBMulator is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with IBMulator.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef IBMULATOR_INPUTSCRIPT_H
+#define IBMULATOR_INPUTSCRIPT_H
+
+#include <string>
+#include <vector>
+
+class Machine;
+class Mixer;
+
+#define INPUTSCRIPT_KEY_DELAY 50 // ms of virtual time between two typed keys
+
+/* Scripted input for the headless mode.
+ * A script is a text file with one command per line:
+ *   wait <ms>         wait for <ms> milliseconds of virtual time
+ *   key <KEY_*> ...   press the keys in order then release them in reverse
+ *                     order (eg. "key KEY_CTRL_L KEY_C")
+ *   type <text>       type the text using the US keyboard layout
+ *   audio_capture     start/stop the audio capture to a wave file
+ *   phase <name>      start a new benchmark phase (see the -j option)
+ *   quit              stop the program
+ * Empty lines and lines starting with '#' are ignored. The key names are the
+ * same used in the keymap files.
+ */
+class InputScript
+{
+private:
+	enum CmdType {
+		CMD_WAIT, CMD_KEYS, CMD_AUDIO_CAPTURE, CMD_PHASE, CMD_QUIT
+	};
+	struct Command {
+		CmdType type;
+		unsigned line;
+		uint64_t wait_ns;
+		std::vector<uint32_t> keys;
+		std::string name;
+	};
+	std::vector<Command> m_commands;
+	size_t m_next;
+
+public:
+	InputScript();
+
+	void load(const std::string &_path);
+	/* Executes the commands up to the next wait, on the machine thread.
+	 * wait_ns_ is the virtual time to wait before the next call (0 when the
+	 * script is finished); returns false on quit.
+	 */
+	bool run(Machine *_machine, Mixer *_mixer, uint64_t &wait_ns_);
+	inline bool is_finished() const { return m_next >= m_commands.size(); }
+
+private:
+	void add_keys(unsigned _line, std::vector<uint32_t> _keys);
+	static bool char_to_keys(char _c, std::vector<uint32_t> &keys_);
+};
+
+#endif
@@ -20,9 +20,11 @@
 #include "ibmulator.h"
 #include "program.h"
 #include "machine.h"
+#include "inputscript.h"
 #include "statebuf.h"
 #include "hardware/cpu.h"
 #include "hardware/cpu/debugger.h"
+#include "hardware/cpu/idle.h"
 #include "hardware/memory.h"
 #include "hardware/devices.h"
 #include "hardware/devices/keyboard.h"
@@ -50,6 +52,11 @@ m_on(false),
 m_cpu_single_step(false),
 m_breakpoint_cs(0),
 m_breakpoint_eip(0),
+m_max_speed(false),
+m_block_deadline(0),
+m_script_timer(NULL_TIMER_HANDLE),
+m_script(nullptr),
+m_script_mixer(nullptr),
 m_mouse_fun(nullptr)
 {
 	memset(&m_s, 0, sizeof(m_s));
@@ -61,7 +68,6 @@ Machine::~Machine()
 }
 
 #define MACHINE_STATE_NAME "Machine state"
-#define MACHINE_TIMERS_NAME "Machine timers"
 
 void Machine::save_state(StateBuf &_state)
 {
@@ -75,9 +81,7 @@ void Machine::save_state(StateBuf &_state)
 	h.data_size = sizeof(m_s);
 	_state.write(&m_s, h);
 
-	h.name = MACHINE_TIMERS_NAME;
-	h.data_size = sizeof(Timer)*MAX_TIMERS;
-	_state.write(m_timers, h);
+	m_timers.save_state(_state);
 
 	g_cpu.save_state(_state);
 	g_memory.save_state(_state);
@@ -98,38 +102,13 @@ void Machine::restore_state(StateBuf &_state)
 	h.name = MACHINE_STATE_NAME;
 	h.data_size = sizeof(m_s);
 	_state.read(&m_s, h);
-	m_mt_virt_time.store(m_s.virt_time);
 
 	//timers
-	h.name = MACHINE_TIMERS_NAME;
-	h.data_size = sizeof(Timer) * MAX_TIMERS;
-	_state.check(h);
-
-	//for every timer in the savestate
-	for(uint t=0; t<MAX_TIMERS; t++) {
-		Timer *savtimer = (Timer*)_state.get_buf();
-		if(savtimer->in_use) {
-			uint mchtidx;
-			//find the correct machine timer, which must be already registered
-			for(mchtidx=0; mchtidx<MAX_TIMERS; mchtidx++) {
-				if(strcmp(m_timers[mchtidx].name, savtimer->name) == 0) {
-					break;
-				}
-			}
-			if(mchtidx>=MAX_TIMERS) {
-				PERRF(LOG_MACHINE, "cant find timer %s\n", savtimer->name);
-				throw std::exception();
-			}
-			if(!m_timers[mchtidx].in_use) {
-				PERRF(LOG_MACHINE, "timer %s is not in use\n", m_timers[mchtidx].name);
-				throw std::exception();
-			}
-			m_timers[mchtidx].period = savtimer->period;
-			m_timers[mchtidx].time_to_fire = savtimer->time_to_fire;
-			m_timers[mchtidx].active = savtimer->active;
-			m_timers[mchtidx].continuous = savtimer->continuous;
-		}
-		_state.advance(sizeof(Timer));
+	try {
+		m_timers.restore_state(_state);
+	} catch(std::exception &e) {
+		PERRF(LOG_MACHINE, "error restoring timers\n");
+		throw;
 	}
 
 	//exceptions will be thrown if the buffer size is smaller than expected
@@ -183,7 +162,13 @@ void Machine::init()
 	m_main_chrono.start();
 	m_bench.init(&m_main_chrono, 1000);
 	m_s.curr_prgname[0] = 0;
-	m_num_timers = 0;
+	m_timers.init();
+	// registered even when there's no script, so that the timers of a state
+	// saved while running headless match those of any other session
+	m_script_timer = register_timer(
+		std::bind(&Machine::run_script, this, std::placeholders::_1),
+		"Input script");
+	m_max_speed = g_program.config().get_bool(PROGRAM_SECTION, PROGRAM_MAX_SPEED, false);
 
 	g_cpu.init();
 	g_cpu.set_shutdown_trap([this] () {
@@ -223,14 +208,7 @@ void Machine::reset(uint _signal)
 			throw std::exception();
 	}
 	if(_signal == MACHINE_POWER_ON || _signal == MACHINE_HARD_RESET) {
-		m_s.virt_time       = 0;
-		m_s.next_timer_time = 0;
-		m_mt_virt_time      = 0;
-		for(unsigned i = 0; i < m_num_timers; i++) {
-			if(m_timers[i].in_use && m_timers[i].active && m_timers[i].continuous) {
-				m_timers[i].time_to_fire = m_timers[i].period;
-			}
-		}
+		m_timers.reset();
 	}
 	m_s.cycles_left = 0;
 	g_memory.reset();
@@ -282,12 +260,16 @@ void Machine::config_changed()
 	g_devices.config_changed();
 
 	m_cycles_factor = 1.0;
+	// m_max_speed is set in init(), a config reload must not undo the runtime toggle
+	if(m_max_speed) {
+		PINFOF(LOG_V0, LOG_MACHINE, "Running at maximum speed\n");
+	}
 
 	set_heartbeat(MACHINE_HEARTBEAT);
 
-	PDEBUGF(LOG_V1, LOG_MACHINE, "Registered timers: %u\n", m_num_timers);
-	for(unsigned i=0; i<m_num_timers; i++) {
-		PDEBUGF(LOG_V1, LOG_MACHINE, "   %u: %s\n", i, m_timers[i].name);
+	PDEBUGF(LOG_V1, LOG_MACHINE, "Registered timers: %u\n", m_timers.get_num_timers());
+	for(unsigned i=0; i<m_timers.get_num_timers(); i++) {
+		PDEBUGF(LOG_V1, LOG_MACHINE, "   %u: %s\n", i, m_timers.get_timer_name(i));
 	}
 	PINFOF(LOG_V1, LOG_MACHINE, "IRQ channels:\n");
 	for(unsigned i=0; i<16; i++) {
@@ -322,7 +304,12 @@ bool Machine::main_loop()
 
 	while(true) {
 		uint64_t time = m_main_chrono.elapsed_usec();
-		if(time < m_heartbeat) {
+		if(m_max_speed) {
+			// run as fast as the host allows, the GUI and the mixer follow at
+			// their own pace
+			m_main_chrono.start();
+			next_beat_diff = 0;
+		} else if(time < m_heartbeat) {
 			uint64_t sleep = m_heartbeat - time;
 			uint64_t t0 = m_main_chrono.get_usec();
 			std::this_thread::sleep_for( std::chrono::microseconds(sleep + next_beat_diff) );
@@ -369,21 +356,26 @@ void Machine::core_step(int32_t _cpu_cycles)
 	uint32_t cycle_time = g_cpu.cycle_time_ns();
 	while(cycles_left>0) {
 
-		int32_t c = g_cpu.step();
+		if(g_cpu.exec_mode() == CPU_EXEC_BLOCK && !m_breakpoint_cs && !m_cpu_single_step) {
+			cycles_left -= core_block(cycles_left, cycle_time);
+			continue;
+		}
+
+		int32_t c = g_cpu.step(cycles_left);
 		if(c>0) {
 			//c is 0 only if (REP && CX==0)
 			m_bench.cpu_step();
 
 			uint32_t elapsed_ns = c * cycle_time;
-			uint64_t cpu_time = m_s.virt_time + elapsed_ns;
+			uint64_t cpu_time = m_timers.get_time() + elapsed_ns;
 
-			if(cpu_time >= m_s.next_timer_time) {
-				while(!update_timers(cpu_time));
+			if(cpu_time >= m_timers.get_next_timer_time()) {
+				m_timers.update(cpu_time);
 			}
 
 			cycles_left -= c;
-			m_s.virt_time = cpu_time;
-			m_mt_virt_time.store(cpu_time);
+			m_timers.set_time(cpu_time);
+			m_timers.set_time_mt();
 		}
 
 		if(m_breakpoint_cs > 0) {
@@ -402,6 +394,50 @@ void Machine::core_step(int32_t _cpu_cycles)
 	m_s.cycles_left = cycles_left;
 }
 
+int32_t Machine::core_block(int32_t _cpu_cycles, uint32_t _cycle_time)
+{
+	/* Steps the CPU back to back until a control transfer (the prefetch
+	 * queue is invalidated) or the block deadline, which is the earliest
+	 * between the next timer and the end of the cycles budget.
+	 * Every instruction still goes through CPU::step(); only the timers
+	 * comparison and the machine bookkeeping are batched. The deadline is
+	 * computed once and activate_timer() moves it back if an instruction
+	 * activates an earlier timer, so timers fire after the same instruction
+	 * as in step mode. The virtual time is still advanced per instruction,
+	 * as devices read it during I/O.
+	 */
+	uint64_t start = m_timers.get_time();
+	uint64_t time = start;
+	m_block_deadline = std::min(m_timers.get_next_timer_time(),
+			start + uint64_t(_cpu_cycles) * _cycle_time);
+	int32_t cycles = 0;
+	uint icount = 0;
+	do {
+		int32_t c = g_cpu.step(_cpu_cycles - cycles);
+		if(c>0) {
+			icount++;
+			cycles += c;
+			time += c * _cycle_time;
+			if(time >= m_block_deadline) {
+				// as in core_step(), the timers are updated while the current
+				// time is still the one before the instruction
+				if(time >= m_timers.get_next_timer_time()) {
+					m_timers.update(time);
+				} else {
+					m_timers.set_time(time);
+				}
+				break;
+			}
+			m_timers.set_time(time);
+		}
+	} while(g_cpubus.pq_is_valid());
+
+	m_timers.set_time_mt();
+	m_bench.cpu_steps(icount);
+
+	return cycles;
+}
+
 void Machine::pause()
 {
 	set_single_step(true);
@@ -414,70 +450,6 @@ void Machine::resume()
 	g_mixer.cmd_resume();
 }
 
-bool Machine::update_timers(uint64_t _cpu_time)
-{
-	// We need to service all the active timers, and invoke callbacks
-	// from those timers which have fired.
-	m_s.next_timer_time = (uint64_t) -1;
-	std::multimap<uint64_t, ushort> triggered;
-	for(uint i = 0; i < m_num_timers; i++) {
-		//triggered[i] = false; // Reset triggered flag.
-		if(m_timers[i].active) {
-			if(m_timers[i].time_to_fire <= _cpu_time) {
-
-				//timers need to fire in an ordered manner
-				triggered.insert(std::pair<uint64_t,ushort>(m_timers[i].time_to_fire,i));
-
-			} else {
-
-				// This timer is not ready to fire yet.
-				if(m_timers[i].time_to_fire < m_s.next_timer_time) {
-					m_s.next_timer_time = m_timers[i].time_to_fire;
-				}
-
-			}
-		}
-	}
-
-	uint64_t prevtimer_time = 0;
-	for(auto timer : triggered) {
-		unsigned thistimer = timer.second;
-		uint64_t thistimer_time = timer.first;
-		uint64_t system_time = m_s.virt_time;
-		assert(thistimer_time >= prevtimer_time);
-		assert(thistimer_time <= _cpu_time);
-		assert(thistimer_time >= system_time);
-
-		// Call requested timer function.  It may request a different
-		// timer period or deactivate etc.
-		// it can even reactivate the same timer and set it to fire BEFORE the next vtime
-		if(!m_timers[thistimer].continuous) {
-			// If triggered timer is one-shot, deactive.
-			m_timers[thistimer].active = false;
-		} else {
-			// Continuous timer, increment time-to-fire by period.
-			m_timers[thistimer].time_to_fire += m_timers[thistimer].period;
-			if(m_timers[thistimer].time_to_fire < m_s.next_timer_time) {
-				m_s.next_timer_time = m_timers[thistimer].time_to_fire;
-			}
-		}
-		if(m_timers[thistimer].fire != nullptr) {
-			//the current time is when the timer fires
-			//virt_time must advance in a monotonic way (that's why we use a map)
-			m_s.virt_time = thistimer_time;
-			m_mt_virt_time = thistimer_time;
-			m_timers[thistimer].fire(m_s.virt_time);
-			if(m_timers[thistimer].time_to_fire <= _cpu_time) {
-				// the timer set itself to fire again before or at the time point
-				// we need to reorder
-				return false;
-			}
-		}
-		prevtimer_time = thistimer_time;
-	}
-	return true;
-}
-
 void Machine::set_single_step(bool _val)
 {
 	m_cpu_single_step = _val;
@@ -485,40 +457,10 @@ void Machine::set_single_step(bool _val)
 
 int Machine::register_timer(timer_fun_t _func, const char *_name)
 {
-	unsigned timer = NULL_TIMER_HANDLE;
-
-	if(m_num_timers >= MAX_TIMERS) {
-    	PERRF(LOG_MACHINE, "register_timer: too many registered timers\n");
-    	throw std::exception();
-	}
-
-	// search for new timer
-	for(unsigned i = 0; i < m_num_timers; i++) {
-		//check if there's another timer with the same name
-		if(m_timers[i].in_use && strcmp(m_timers[i].name, _name)==0) {
-			//cannot be 2 timers with the same name
-			return NULL_TIMER_HANDLE;
-		}
-		if((!m_timers[i].in_use) && (timer==NULL_TIMER_HANDLE)) {
-			//free timer found
-			timer = i;
-		}
-	}
-	if(timer == NULL_TIMER_HANDLE) {
-		// If we didn't find a free slot, increment the bound m_num_timers.
-		timer = m_num_timers;
-		m_num_timers++;
+	unsigned timer = m_timers.register_timer(_func, _name);
+	if(timer != NULL_TIMER_HANDLE) {
+		PDEBUGF(LOG_V2,LOG_MACHINE,"timer id %d registered for '%s'\n", timer, _name);
 	}
-	m_timers[timer].in_use = true;
-	m_timers[timer].period = 0;
-	m_timers[timer].time_to_fire = 0;
-	m_timers[timer].active = false;
-	m_timers[timer].continuous = false;
-	m_timers[timer].fire = _func;
-	snprintf(m_timers[timer].name, TIMER_NAME_LEN, "%s", _name);
-
-	PDEBUGF(LOG_V2,LOG_MACHINE,"timer id %d registered for '%s'\n", timer, _name);
-
 	return timer;
 }
 
@@ -527,55 +469,31 @@ void Machine::unregister_timer(int &_timer)
 	if(_timer == NULL_TIMER_HANDLE) {
 		return;
 	}
-	assert(_timer < MAX_TIMERS);
-	m_timers[_timer].in_use = false;
-	m_timers[_timer].active = false;
-	m_timers[_timer].fire = nullptr;
+	m_timers.unregister_timer(_timer);
 	_timer = NULL_TIMER_HANDLE;
 }
 
 void Machine::activate_timer(unsigned _timer, uint64_t _nsecs, bool _continuous)
 {
-	assert(_timer<m_num_timers);
-
 	// if _nsecs = 0, use default stored in period field
-	if(_nsecs == 0) {
-		_nsecs = m_timers[_timer].period;
-	}
-
-	m_timers[_timer].active = true;
-	m_timers[_timer].period = _nsecs;
-	m_timers[_timer].time_to_fire = m_s.virt_time + _nsecs;
-	m_timers[_timer].continuous = _continuous;
-
-	if(m_timers[_timer].time_to_fire < m_s.next_timer_time) {
-		m_s.next_timer_time = m_timers[_timer].time_to_fire;
-	}
+	m_timers.activate_timer(_timer, _nsecs, _continuous);
+	// a running block must stop at the new timer
+	m_block_deadline = std::min(m_block_deadline, m_timers.get_next_timer_time());
 }
 
 void Machine::deactivate_timer(unsigned _timer)
 {
-	assert(_timer<m_num_timers);
-
-	m_timers[_timer].active = false;
+	m_timers.deactivate_timer(_timer);
 }
 
 uint64_t Machine::get_timer_eta(unsigned _timer) const
 {
-	assert(_timer<m_num_timers);
-
-	if(!m_timers[_timer].active) {
-		return 0;
-	}
-	assert(m_timers[_timer].time_to_fire >= m_s.virt_time);
-	return (m_timers[_timer].time_to_fire - m_s.virt_time);
+	return m_timers.get_timer_eta(_timer);
 }
 
 void Machine::set_timer_callback(unsigned _timer, timer_fun_t _func)
 {
-	assert(_timer<m_num_timers);
-
-	m_timers[_timer].fire = _func;
+	m_timers.set_timer_callback(_timer, _func);
 }
 
 void Machine::register_irq(uint8_t _irq, const char* _name)
@@ -772,6 +690,59 @@ void Machine::cmd_cycles_adjust(double _factor)
 	});
 }
 
+void Machine::cmd_toggle_max_speed()
+{
+	m_cmd_fifo.push([=] () {
+		m_max_speed = !m_max_speed;
+		std::string mex = std::string("maximum speed ") + (m_max_speed?"on":"off");
+		PINFOF(LOG_V0, LOG_MACHINE, "%s\n", mex.c_str());
+		g_gui.show_message(mex.c_str());
+	});
+}
+
+void Machine::bench_sample(const std::string &_phase)
+{
+	m_bench.sample(_phase, m_timers.get_time());
+	if(!_phase.empty()) {
+		PINFOF(LOG_V1, LOG_MACHINE, "benchmark phase '%s'\n", _phase.c_str());
+	}
+}
+
+void Machine::cmd_bench_sample(std::string _phase)
+{
+	m_cmd_fifo.push([=] () {
+		bench_sample(_phase);
+	});
+}
+
+void Machine::cmd_run_script(InputScript *_script, Mixer *_mixer, std::function<void()> _quit)
+{
+	m_cmd_fifo.push([=] () {
+		m_script = _script;
+		m_script_mixer = _mixer;
+		m_script_quit = _quit;
+		run_script(m_timers.get_time());
+	});
+}
+
+void Machine::run_script(uint64_t)
+{
+	/* The waits are timer events, so the commands of the script (and the
+	 * benchmark samples of the phases) are executed at exact virtual times.
+	 */
+	if(!m_script) {
+		// a state saved with a pending wait restored without a script
+		return;
+	}
+	uint64_t wait_ns = 0;
+	if(!m_script->run(this, m_script_mixer, wait_ns)) {
+		bench_sample("");
+		m_script_quit();
+	} else if(wait_ns) {
+		activate_timer(m_script_timer, wait_ns, false);
+	}
+}
+
 void Machine::cmd_save_state(StateBuf &_state, std::mutex &_mutex, std::condition_variable &_cv)
 {
 	m_cmd_fifo.push([&] () {
@@ -875,6 +846,7 @@ void Machine::set_DOS_program_name(const char *_name)
 	strncpy(m_s.curr_prgname, _name, PRG_NAME_LEN);
 	m_s.curr_prgname[PRG_NAME_LEN-1] = 0;
 	m_curr_prgname_changed = true;
+	g_cpuidle.program_changed(_name);
 }
 
 void Machine::DOS_program_launch(std::string _name)
@@ -20,6 +20,7 @@
 #ifndef IBMULATOR_MACHINE_H
 #define IBMULATOR_MACHINE_H
 
+#include <atomic>
 #include <functional>
 #include <mutex>
 #include "circular_fifo.h"
@@ -34,6 +35,8 @@
 class CPU;
 class Memory;
 class IODevice;
+class InputScript;
+class Mixer;
 class Machine;
 extern Machine g_machine;
 
@@ -72,28 +75,23 @@ private:
 	double m_cpu_cycles;
 	uint m_cpu_cycle_time;
 	double m_cycles_factor;
+	std::atomic<bool> m_max_speed; // read by the mixer thread
 
-	struct Timer {
-		bool        in_use;       // Timer slot is in-use (currently registered).
-		uint64_t    period;       // Timer periodocity in nsecs.
-		uint64_t    time_to_fire; // Time to fire next (in nsecs).
-		bool        active;       // false=inactive, true=active.
-		bool        continuous;   // false=one-shot timer, true=continuous periodicity.
-		timer_fun_t fire;         // A callback function for when the timer fires.
-		char        name[TIMER_NAME_LEN];
-	} m_timers[MAX_TIMERS];
+	uint64_t m_block_deadline; // virtual time at which the current block ends
 
-	uint m_num_timers;
+	// the input script runs on the machine thread, driven by a timer
+	int m_script_timer;
+	InputScript *m_script;
+	Mixer *m_script_mixer;
+	std::function<void()> m_script_quit;
+
+	EventTimers m_timers;
 
 	struct {
-		uint64_t virt_time;
-		uint64_t next_timer_time;
 		int32_t cycles_left;
 		char curr_prgname[PRG_NAME_LEN];
 	} m_s;
 
-	std::atomic<uint64_t> m_mt_virt_time;
-
 	std::string m_irq_names[16];
 
 	SystemROM m_sysrom;
@@ -101,11 +99,12 @@ private:
 	bool m_curr_prgname_changed;
 
 	void core_step(int32_t _cpu_cycles);
+	int32_t core_block(int32_t _cpu_cycles, uint32_t _cycle_time);
 	void pause();
 	void resume();
 	void mem_reset();
 	void power_off();
-	bool update_timers(uint64_t _vtime);
+	void run_script(uint64_t);
 
 	CircularFifo<Machine_fun_t,10> m_cmd_fifo;
 
@@ -135,11 +134,13 @@ public:
 	void config_changed();
 
 	void set_heartbeat(unsigned _us);
-	inline uint64_t get_virt_time_ns() const { return m_s.virt_time; }
-	inline uint64_t get_virt_time_us() const { return NSEC_TO_USEC(m_s.virt_time); }
-	inline uint64_t get_virt_time_ns_mt() const { return m_mt_virt_time; }
-	inline uint64_t get_virt_time_us_mt() const { return NSEC_TO_USEC(m_mt_virt_time); }
+	inline uint64_t get_virt_time_ns() const { return m_timers.get_time(); }
+	inline uint64_t get_next_timer_time() const { return m_timers.get_next_timer_time(); }
+	inline uint64_t get_virt_time_us() const { return NSEC_TO_USEC(m_timers.get_time()); }
+	inline uint64_t get_virt_time_ns_mt() const { return m_timers.get_time_mt(); }
+	inline uint64_t get_virt_time_us_mt() const { return NSEC_TO_USEC(m_timers.get_time_mt()); }
 	inline HWBench & get_bench() { return m_bench; }
+	void bench_sample(const std::string &_phase);
 
 	inline unsigned type() const { return model().type; }
 	inline std::string type_str() const { return g_machine_type_str.at(type()); }
@@ -155,8 +156,7 @@ public:
 	void deactivate_timer(unsigned _timer);
 	void set_timer_callback(unsigned _timer, timer_fun_t _func);
 	inline bool is_timer_active(unsigned _timer) const {
-		assert(_timer!=0 && _timer<m_num_timers);
-		return m_timers[_timer].active;
+		return m_timers.is_timer_active(_timer);
 	}
 
 	void register_irq(uint8_t irq, const char* name);
@@ -172,6 +172,7 @@ public:
 
 	inline bool is_on() { return m_on; }
 	inline bool is_paused() { return m_cpu_single_step; }
+	inline bool is_max_speed() { return m_max_speed; }
 
 	//inter-thread commands:
 	void cmd_quit();
@@ -189,6 +190,9 @@ public:
 	void cmd_cpulog();
 	void cmd_prg_cpulog(std::string _prg_name);
 	void cmd_cycles_adjust(double _factor);
+	void cmd_toggle_max_speed();
+	void cmd_bench_sample(std::string _phase);
+	void cmd_run_script(InputScript *_script, Mixer *_mixer, std::function<void()> _quit);
 	void cmd_save_state(StateBuf &_state, std::mutex &_mutex, std::condition_variable &_cv);
 	void cmd_restore_state(StateBuf &_state, std::mutex &_mutex, std::condition_variable &_cv);
 	void cmd_insert_media(uint _drive, uint _type, std::string _file, bool _wp);
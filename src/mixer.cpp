@@ -224,7 +224,12 @@ void Mixer::main_loop()
 			return;
 		} else if(m_paused) {
 			continue;
-		} else if(!is_enabled()) {
+		}
+
+		HWProfiler::Scope prof(HWProfiler::MIXER);
+
+		if(!is_enabled() || g_machine.is_max_speed()) {
+			// at max speed the audio is produced faster than real time, drop it
 			for(auto ch : m_mix_channels) {
 				if(ch.second->is_enabled()) {
 					ch.second->update(time_span_us, false);
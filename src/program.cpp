@@ -27,6 +27,7 @@
 #include "mixer.h"
 #include "statebuf.h"
 #include <cstdio>
+#include <fstream>
 #include <libgen.h>
 #include <thread>
 #include <sys/types.h>
@@ -47,6 +48,7 @@ Program::Program()
 m_threads_sync(false),
 m_machine(nullptr),
 m_gui(nullptr),
+m_headless(false),
 m_restore_fn(nullptr)
 {
 
@@ -324,8 +326,22 @@ bool Program::initialize(int argc, char** argv)
 	std::string dumplog = m_config[0].get_file_path("log.txt", FILE_TYPE_USER);
 	g_syslog.add_device(LOG_ALL_PRIORITIES, LOG_ALL_FACILITIES, new LogStream(dumplog.c_str()));
 
+	if(m_headless) {
+		// nothing to keep in sync with real time, run as fast as possible
+		m_config[0].set_bool(PROGRAM_SECTION, PROGRAM_MAX_SPEED, true);
+	}
+
 	m_config[1].copy(m_config[0]);
 
+	if(m_headless) {
+		// the mixer keeps working with a device that discards the audio,
+		// the audio capture to wave files is still available
+		SDL_setenv("SDL_AUDIODRIVER", "dummy", 0);
+		if(!m_script_file.empty()) {
+			m_script.load(m_script_file);
+		}
+	}
+
 	init_SDL();
 
 	PINFO(LOG_V0, "Calibrating...");
@@ -424,8 +440,20 @@ void Program::parse_arguments(int argc, char** argv)
 
 	opterr = 0;
 
-	while((c = getopt(argc, argv, "v:c:u:")) != -1) {
+	while((c = getopt(argc, argv, "v:c:u:Hs:j:p:")) != -1) {
 		switch(c) {
+			case 'H':
+				m_headless = true;
+				break;
+			case 's':
+				m_script_file = optarg;
+				break;
+			case 'j':
+				m_bench_file = optarg;
+				break;
+			case 'p':
+				m_prof_file = optarg;
+				break;
 			case 'c':
 				if(!FileSys::file_exists(optarg)) {
 					PERRF(LOG_PROGRAM, "The specified config file doesn't exists\n");
@@ -448,7 +476,7 @@ void Program::parse_arguments(int argc, char** argv)
 				break;
 			}
 			case '?':
-				if(optopt == 'c')
+				if(optopt == 'c' || optopt == 's' || optopt == 'j')
 					PERRF(LOG_PROGRAM, "Option -%c requires an argument\n", optopt);
 				else if(isprint(optopt))
 					PERRF(LOG_PROGRAM, "Unknown option `-%c'\n", optopt);
@@ -475,7 +503,11 @@ void Program::set_gui(GUI *_gui)
 		throw std::exception();
 	}
 	m_gui = _gui;
-	m_gui->init(m_machine, m_mixer);
+	if(m_headless) {
+		m_gui->init_headless(m_machine, m_mixer);
+	} else {
+		m_gui->init(m_machine, m_mixer);
+	}
 	m_gui->config_changed();
 }
 
@@ -572,19 +604,66 @@ void Program::main_loop()
 	}
 }
 
+void Program::main_loop_headless()
+{
+	/* There's nothing to render, the program thread only starts the input
+	 * script, which is executed by the machine thread, and waits for the quit
+	 * event (SDL sends it on SIGINT/SIGTERM).
+	 */
+	m_machine->cmd_power_on();
+	m_machine->cmd_run_script(&m_script, m_mixer, [this] () {
+		stop();
+	});
+	while(!m_quit) {
+		std::this_thread::sleep_for(std::chrono::microseconds(m_heartbeat));
+		process_evts();
+	}
+}
+
 void Program::start()
 {
 	PDEBUGF(LOG_V1, LOG_PROGRAM, "Program thread started\n");
+	if(!m_prof_file.empty()) {
+		// the profiler adds its own overhead, it's not enabled by -j alone
+		g_hwprof.set_enabled(true);
+	}
 	std::thread machine(&Machine::start,m_machine);
 	std::thread mixer(&Mixer::start,m_mixer);
 
-	main_loop();
+	if(m_headless) {
+		main_loop_headless();
+	} else {
+		main_loop();
+	}
 
+	if(!m_bench_file.empty()) {
+		// end the last benchmark phase
+		m_machine->cmd_bench_sample("");
+	}
 	m_machine->cmd_power_off();
 	m_machine->cmd_quit();
 	machine.join();
 	PDEBUGF(LOG_V1, LOG_PROGRAM, "Machine thread stopped\n");
 
+	if(!m_bench_file.empty()) {
+		std::ofstream file(m_bench_file.c_str());
+		if(file.is_open()) {
+			m_machine->get_bench().write_json(file);
+			PINFOF(LOG_V0, LOG_PROGRAM, "Benchmark results written to '%s'\n", m_bench_file.c_str());
+		} else {
+			PERRF(LOG_PROGRAM, "Unable to write the benchmark results to '%s'\n", m_bench_file.c_str());
+		}
+	}
+	if(!m_prof_file.empty()) {
+		std::ofstream csv(m_prof_file.c_str());
+		if(csv.is_open()) {
+			g_hwprof.write_csv(csv);
+			PINFOF(LOG_V0, LOG_PROGRAM, "Host time profile written to '%s'\n", m_prof_file.c_str());
+		} else {
+			PERRF(LOG_PROGRAM, "Unable to write the host time profile to '%s'\n", m_prof_file.c_str());
+		}
+	}
+
 	m_mixer->cmd_quit();
 	mixer.join();
 	PDEBUGF(LOG_V1, LOG_PROGRAM, "Mixer thread stopped\n");
@@ -23,6 +23,7 @@
 #include "chrono.h"
 #include "bench.h"
 #include "appconfig.h"
+#include "inputscript.h"
 #include <condition_variable>
 
 class GUI;
@@ -41,7 +42,7 @@ class Program
 	std::atomic<unsigned> m_heartbeat;
 	uint64_t m_next_beat;
 	unsigned m_frameskip;
-	bool m_quit;
+	std::atomic<bool> m_quit;
 	Chrono m_main_chrono;
 	Bench m_bench;
 
@@ -51,6 +52,11 @@ class Program
 
 	std::string m_user_dir; // the directory where the user keeps files like ibmulator.ini
 	std::string m_cfg_file; // the full path of ibmulator.ini
+	bool m_headless;        // run without window, OpenGL and audio device
+	std::string m_script_file; // the input script for the headless mode
+	InputScript m_script;
+	std::string m_bench_file;  // where to write the benchmark results (JSON)
+	std::string m_prof_file;   // where to write the host time profile (CSV)
 	AppConfig m_config[2];  // 0: the start up program config, 1: the current config
 
 	std::function<void()> m_restore_fn;
@@ -58,6 +64,7 @@ class Program
 	void init_SDL();
 	void process_evts();
 	void main_loop();
+	void main_loop_headless();
 
 	std::string get_assets_dir(int argc, char** argv);
 	void parse_arguments(int argc, char** argv);
@@ -81,6 +88,7 @@ public:
 	void stop();
 
 	bool threads_sync() const { return m_threads_sync; }
+	bool is_headless() const { return m_headless; }
 	unsigned heartbeat() const { return m_heartbeat; }
 	void set_heartbeat(unsigned _us) { m_heartbeat = _us; }
 
@@ -20,176 +20,174 @@
 #include "ibmulator.h"
 #include "timers.h"
 #include "statebuf.h"
+#include "hwbench.h"
 #include <cstring>
 
 
 EventTimers::EventTimers()
 {
 	memset(&m_s, 0, sizeof(m_s));
+	m_mt_time = 0;
 }
 
 EventTimers::~EventTimers()
 {
 }
 
+#define TIMERS_STATE_NAME "EventTimers"
+#define TIMERS_LIST_NAME  "EventTimers list"
+
 void EventTimers::save_state(StateBuf &_state)
 {
-	_state.write(&m_s, {sizeof(m_s), "EventTimers"});
+	_state.write(&m_s, {sizeof(m_s), TIMERS_STATE_NAME});
+
+	std::vector<TimerState> timers;
+	for(auto &t : m_timers) {
+		if(t.in_use) {
+			TimerState ts;
+			memset(&ts, 0, sizeof(ts));
+			memcpy(ts.name, t.name, TIMER_NAME_LEN);
+			ts.period = t.period;
+			ts.time_to_fire = t.time_to_fire;
+			ts.active = t.active;
+			ts.continuous = t.continuous;
+			timers.push_back(ts);
+		}
+	}
+	_state.write(timers.data(), {sizeof(TimerState)*timers.size(), TIMERS_LIST_NAME});
 }
 
 void EventTimers::restore_state(StateBuf &_state)
 {
-	_state.check({sizeof(m_s), "EventTimers"});
+	_state.read(&m_s, {sizeof(m_s), TIMERS_STATE_NAME});
+
+	StateHeader h;
+	_state.get_next_lump_header(h);
+	if(h.name != TIMERS_LIST_NAME || h.data_size % sizeof(TimerState)) {
+		PERRF(LOG_MACHINE, "invalid timers state\n");
+		throw std::exception();
+	}
+	std::vector<TimerState> timers(h.data_size / sizeof(TimerState));
+	_state.read(timers.data(), h);
 
 	//for every timer in the savestate
-	for(uint t=0; t<MAX_TIMERS; t++) {
-		Timer *savtimer = (Timer*)_state.get_buf();
-		if(savtimer->in_use) {
-			uint mchtidx;
-			// find the correct machine timer, which MUST be already registered.
-			// here we reset the timing period and related data only.
-			for(mchtidx=0; mchtidx<MAX_TIMERS; mchtidx++) {
-				if(strcmp(m_s.timers[mchtidx].name, savtimer->name) == 0) {
-					break;
-				}
-			}
-			if(mchtidx>=MAX_TIMERS) {
-				PERRF(LOG_MACHINE, "cant find timer %s\n", savtimer->name);
-				throw std::exception();
+	for(auto &savtimer : timers) {
+		savtimer.name[TIMER_NAME_LEN-1] = 0;
+		unsigned mchtidx;
+		// find the correct machine timer, which MUST be already registered.
+		// here we reset the timing period and related data only.
+		for(mchtidx=0; mchtidx<m_timers.size(); mchtidx++) {
+			if(m_timers[mchtidx].in_use && strcmp(m_timers[mchtidx].name, savtimer.name) == 0) {
+				break;
 			}
-			if(!m_s.timers[mchtidx].in_use) {
-				PERRF(LOG_MACHINE, "timer %s is not in use\n", m_s.timers[mchtidx].name);
-				throw std::exception();
-			}
-			m_s.timers[mchtidx].period = savtimer->period;
-			m_s.timers[mchtidx].time_to_fire = savtimer->time_to_fire;
-			m_s.timers[mchtidx].active = savtimer->active;
-			m_s.timers[mchtidx].continuous = savtimer->continuous;
 		}
-		_state.advance(sizeof(Timer));
+		if(mchtidx>=m_timers.size()) {
+			PERRF(LOG_MACHINE, "cant find timer %s\n", savtimer.name);
+			throw std::exception();
+		}
+		m_timers[mchtidx].period = savtimer.period;
+		m_timers[mchtidx].time_to_fire = savtimer.time_to_fire;
+		m_timers[mchtidx].active = savtimer.active;
+		m_timers[mchtidx].continuous = savtimer.continuous;
 	}
-	m_s.time = *(uint64_t*)_state.get_buf();
-	m_s.next_timer_time = *(uint64_t*)_state.get_buf();
+	heap_rebuild();
 
 	m_mt_time = m_s.time;
 }
 
-
 void EventTimers::init()
 {
-	m_num_timers = 0;
+	m_timers.clear();
+	m_heap.clear();
+	update_next_timer_time();
 }
 
 void EventTimers::reset()
 {
 	m_s.time = 0;
-	m_s.next_timer_time = 0;
 	m_mt_time = 0;
-	for(unsigned i = 0; i < m_num_timers; i++) {
-		if(m_s.timers[i].in_use && m_s.timers[i].active && m_s.timers[i].continuous) {
-			m_s.timers[i].time_to_fire = m_s.timers[i].period;
+	for(auto &t : m_timers) {
+		if(t.in_use && t.active && t.continuous) {
+			t.time_to_fire = t.period;
 		}
 	}
+	heap_rebuild();
 }
 
-bool EventTimers::update(uint64_t _current_time)
+void EventTimers::update(uint64_t _current_time)
 {
 	// We need to service all the active timers, and invoke callbacks
-	// from those timers which have fired.
-	m_s.next_timer_time = (uint64_t) -1;
-	static std::multimap<uint64_t, ushort> triggered;
-	triggered.clear();
-	for(unsigned i=0; i<m_num_timers; i++) {
-		if(m_s.timers[i].active) {
-			if(m_s.timers[i].time_to_fire <= _current_time) {
-
-				//timers need to fire in an ordered manner
-				triggered.insert(std::pair<uint64_t,ushort>(m_s.timers[i].time_to_fire,i));
-
-			} else {
-
-				// This timer is not ready to fire yet.
-				if(m_s.timers[i].time_to_fire < m_s.next_timer_time) {
-					m_s.next_timer_time = m_s.timers[i].time_to_fire;
-				}
-
-			}
+	// from those timers which have fired, in time order.
+	while(!m_heap.empty()) {
+		unsigned thistimer = m_heap[0];
+		Timer &timer = m_timers[thistimer];
+		uint64_t thistimer_time = timer.time_to_fire;
+		if(thistimer_time > _current_time) {
+			break;
 		}
-	}
-
-	uint64_t prevtimer_time = 0;
-	for(auto timer : triggered) {
-		unsigned thistimer = timer.second;
-		uint64_t thistimer_time = timer.first;
-
-		assert(thistimer_time >= prevtimer_time);
-		assert(thistimer_time <= _current_time);
+		assert(thistimer_time >= m_s.time);
 
 		// Call requested timer function.  It may request a different
 		// timer period or deactivate etc.
-		// it can even reactivate the same timer and set it to fire BEFORE the next cycle
-		if(!m_s.timers[thistimer].continuous) {
+		// it can even reactivate the same timer and set it to fire BEFORE the
+		// current time, it will be fired again by this same loop.
+		if(!timer.continuous) {
 			// If triggered timer is one-shot, deactive.
-			m_s.timers[thistimer].active = false;
+			timer.active = false;
+			heap_remove(thistimer);
 		} else {
 			// Continuous timer, increment time-to-fire by period.
-			m_s.timers[thistimer].time_to_fire += m_s.timers[thistimer].period;
-			if(m_s.timers[thistimer].time_to_fire < m_s.next_timer_time) {
-				m_s.next_timer_time = m_s.timers[thistimer].time_to_fire;
-			}
+			timer.time_to_fire += timer.period;
+			heap_down(0);
+			update_next_timer_time();
 		}
-		if(m_s.timers[thistimer].fire != nullptr) {
+		if(timer.fire != nullptr) {
 			//the current time is when the timer fires
-			//time must advance in a monotonic way (that's why we use a map)
+			//time must advance in a monotonic way
 			m_s.time = thistimer_time;
 			m_mt_time = thistimer_time;
-			m_s.timers[thistimer].fire(m_s.time);
-			if(m_s.timers[thistimer].time_to_fire <= _current_time) {
-				// the timer set itself to fire again before or at the time point
-				// we need to reorder
-				return false;
-			}
+			HWProfiler::Scope prof(timer.prof);
+			timer.fire(thistimer_time);
 		}
-		prevtimer_time = thistimer_time;
 	}
 	m_s.time = _current_time;
 	m_mt_time = _current_time;
-	return true;
 }
 
 unsigned EventTimers::register_timer(timer_fun_t _func, const char *_name)
 {
 	unsigned timer = NULL_TIMER_HANDLE;
 
-	if(m_num_timers >= MAX_TIMERS) {
-    	PERR("register_fn: too many registered timers\n");
-    	throw std::exception();
-	}
-
 	// search for new timer
-	for(unsigned i = 0; i < m_num_timers; i++) {
+	for(unsigned i = 0; i < m_timers.size(); i++) {
 		//check if there's another timer with the same name
-		if(m_s.timers[i].in_use && strcmp(m_s.timers[i].name, _name)==0) {
+		if(m_timers[i].in_use && strcmp(m_timers[i].name, _name)==0) {
 			//cannot be 2 timers with the same name
 			return NULL_TIMER_HANDLE;
 		}
-		if((!m_s.timers[i].in_use) && (timer==NULL_TIMER_HANDLE)) {
+		if((!m_timers[i].in_use) && (timer==NULL_TIMER_HANDLE)) {
 			//free timer found
 			timer = i;
 		}
 	}
 	if(timer == NULL_TIMER_HANDLE) {
-		// If we didn't find a free slot, increment the bound m_num_timers.
-		timer = m_num_timers;
-		m_num_timers++;
-	}
-	m_s.timers[timer].in_use = true;
-	m_s.timers[timer].period = 0;
-	m_s.timers[timer].time_to_fire = 0;
-	m_s.timers[timer].active = false;
-	m_s.timers[timer].continuous = false;
-	m_s.timers[timer].fire = _func;
-	snprintf(m_s.timers[timer].name, TIMER_NAME_LEN, "%s", _name);
+		// If we didn't find a free slot, add a new timer.
+		timer = m_timers.size();
+		if(timer == NULL_TIMER_HANDLE) {
+			PERR("register_timer: too many registered timers\n");
+			throw std::exception();
+		}
+		m_timers.emplace_back();
+	}
+	m_timers[timer].in_use = true;
+	m_timers[timer].period = 0;
+	m_timers[timer].time_to_fire = 0;
+	m_timers[timer].active = false;
+	m_timers[timer].continuous = false;
+	m_timers[timer].fire = _func;
+	m_timers[timer].heap_pos = TIMER_NOT_QUEUED;
+	snprintf(m_timers[timer].name, TIMER_NAME_LEN, "%s", _name);
+	m_timers[timer].prof = g_hwprof.register_counter(std::string("timer ") + _name);
 
 	return timer;
 }
@@ -199,53 +197,144 @@ void EventTimers::unregister_timer(unsigned _timer)
 	if(_timer == NULL_TIMER_HANDLE) {
 		return;
 	}
-	assert(_timer < MAX_TIMERS);
-	m_s.timers[_timer].in_use = false;
-	m_s.timers[_timer].active = false;
-	m_s.timers[_timer].fire = nullptr;
-	_timer = NULL_TIMER_HANDLE;
+	assert(_timer < m_timers.size());
+	deactivate_timer(_timer);
+	m_timers[_timer].in_use = false;
+	m_timers[_timer].fire = nullptr;
 }
 
 void EventTimers::activate_timer(unsigned _timer, uint64_t _period, bool _continuous)
 {
-	assert(_timer<m_num_timers);
+	assert(_timer < m_timers.size());
 
 	if(_period == 0) {
 		//use default stored in period field
-		_period = m_s.timers[_timer].period;
+		_period = m_timers[_timer].period;
 	}
 
-	m_s.timers[_timer].active = true;
-	m_s.timers[_timer].period = _period;
-	m_s.timers[_timer].time_to_fire = m_s.time + _period;
-	m_s.timers[_timer].continuous = _continuous;
+	m_timers[_timer].active = true;
+	m_timers[_timer].period = _period;
+	m_timers[_timer].time_to_fire = m_s.time + _period;
+	m_timers[_timer].continuous = _continuous;
 
-	if(m_s.timers[_timer].time_to_fire < m_s.next_timer_time) {
-		m_s.next_timer_time = m_s.timers[_timer].time_to_fire;
+	if(m_timers[_timer].heap_pos == TIMER_NOT_QUEUED) {
+		heap_insert(_timer);
+	} else {
+		heap_update(_timer);
 	}
 }
 
 void EventTimers::deactivate_timer(unsigned _timer)
 {
-	assert(_timer<m_num_timers);
+	assert(_timer < m_timers.size());
 
-	m_s.timers[_timer].active = false;
+	m_timers[_timer].active = false;
+	if(m_timers[_timer].heap_pos != TIMER_NOT_QUEUED) {
+		heap_remove(_timer);
+	}
 }
 
 uint64_t EventTimers::get_timer_eta(unsigned _timer) const
 {
-	assert(_timer < m_num_timers);
+	assert(_timer < m_timers.size());
 
-	if(!m_s.timers[_timer].active) {
+	if(!m_timers[_timer].active) {
 		return 0;
 	}
-	assert(m_s.timers[_timer].time_to_fire >= m_s.time);
-	return (m_s.timers[_timer].time_to_fire - m_s.time);
+	assert(m_timers[_timer].time_to_fire >= m_s.time);
+	return (m_timers[_timer].time_to_fire - m_s.time);
 }
 
 void EventTimers::set_timer_callback(unsigned _timer, timer_fun_t _func)
 {
-	assert(_timer<m_num_timers);
+	assert(_timer < m_timers.size());
+
+	m_timers[_timer].fire = _func;
+}
+
+void EventTimers::heap_set(unsigned _pos, unsigned _timer)
+{
+	m_heap[_pos] = _timer;
+	m_timers[_timer].heap_pos = _pos;
+}
+
+void EventTimers::heap_up(unsigned _pos)
+{
+	unsigned timer = m_heap[_pos];
+	while(_pos > 0) {
+		unsigned parent = (_pos - 1) / 2;
+		if(!fires_before(timer, m_heap[parent])) {
+			break;
+		}
+		heap_set(_pos, m_heap[parent]);
+		_pos = parent;
+	}
+	heap_set(_pos, timer);
+}
+
+void EventTimers::heap_down(unsigned _pos)
+{
+	unsigned timer = m_heap[_pos];
+	unsigned size = m_heap.size();
+	while(true) {
+		unsigned child = _pos*2 + 1;
+		if(child >= size) {
+			break;
+		}
+		if(child+1 < size && fires_before(m_heap[child+1], m_heap[child])) {
+			child++;
+		}
+		if(!fires_before(m_heap[child], timer)) {
+			break;
+		}
+		heap_set(_pos, m_heap[child]);
+		_pos = child;
+	}
+	heap_set(_pos, timer);
+}
+
+void EventTimers::heap_insert(unsigned _timer)
+{
+	m_heap.push_back(_timer);
+	heap_up(m_heap.size() - 1);
+	update_next_timer_time();
+}
+
+void EventTimers::heap_remove(unsigned _timer)
+{
+	unsigned pos = m_timers[_timer].heap_pos;
+	assert(pos < m_heap.size() && m_heap[pos] == _timer);
+	m_timers[_timer].heap_pos = TIMER_NOT_QUEUED;
+	unsigned last = m_heap.back();
+	m_heap.pop_back();
+	if(pos < m_heap.size()) {
+		heap_set(pos, last);
+		heap_update(last);
+	} else {
+		update_next_timer_time();
+	}
+}
+
+void EventTimers::heap_update(unsigned _timer)
+{
+	unsigned pos = m_timers[_timer].heap_pos;
+	if(pos > 0 && fires_before(_timer, m_heap[(pos - 1) / 2])) {
+		heap_up(pos);
+	} else {
+		heap_down(pos);
+	}
+	update_next_timer_time();
+}
 
-	m_s.timers[_timer].fire = _func;
+void EventTimers::heap_rebuild()
+{
+	m_heap.clear();
+	for(unsigned i=0; i<m_timers.size(); i++) {
+		m_timers[i].heap_pos = TIMER_NOT_QUEUED;
+		if(m_timers[i].in_use && m_timers[i].active) {
+			m_heap.push_back(i);
+			heap_up(m_heap.size() - 1);
+		}
+	}
+	update_next_timer_time();
 }
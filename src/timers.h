@@ -21,6 +21,8 @@
 #define IBMULATOR_TIMERS_H
 
 #include "statebuf.h"
+#include <deque>
+#include <vector>
 
 typedef std::function<void(uint64_t)> timer_fun_t;
 
@@ -29,9 +31,9 @@ typedef std::function<void(uint64_t)> timer_fun_t;
 #define NSEC_PER_SECOND (1000000000L)
 #define INV_USEC_PER_SECOND_D (0.000001)
 #define NSEC_TO_USEC(nsec) (nsec/1000)
-#define MAX_TIMERS 24
 #define NULL_TIMER_HANDLE 10000
 #define TIMER_NAME_LEN 20
+#define TIMER_NOT_QUEUED ((unsigned)-1)
 
 constexpr uint64_t operator"" _us ( unsigned long long int _t ) { return _t * 1000L; }
 constexpr uint64_t operator"" _ms ( unsigned long long int _t ) { return _t * 1000000L; }
@@ -45,18 +47,37 @@ struct Timer {
 	bool        continuous;   // false=one-shot timer, true=continuous periodicity.
 	timer_fun_t fire;         // A callback function for when the timer fires.
 	char        name[TIMER_NAME_LEN];
+	unsigned    heap_pos;     // position in the scheduling heap, TIMER_NOT_QUEUED if not active
+	unsigned    prof;         // host time profiler counter
 };
 
+/* The events scheduler.
+ * Active timers are kept in a binary min-heap ordered by time to fire (and by
+ * index for timers firing at the same time, so the order is deterministic).
+ * The next timer to fire is always at the top, and activations, deactivations
+ * and firings cost O(log n) regardless of the number of registered timers.
+ * Timers are stored in a deque so callbacks can register new timers while
+ * being executed.
+ */
 class EventTimers
 {
 private:
+	std::deque<Timer> m_timers;
+	std::vector<unsigned> m_heap;
 	struct {
-		Timer timers[MAX_TIMERS];
 		uint64_t time;
 		uint64_t next_timer_time;
 	} m_s;
 	std::atomic<uint64_t> m_mt_time;
-	uint m_num_timers;
+
+	// what's saved in the state for every registered timer
+	struct TimerState {
+		char     name[TIMER_NAME_LEN];
+		uint64_t period;
+		uint64_t time_to_fire;
+		bool     active;
+		bool     continuous;
+	};
 
 public:
 	EventTimers();
@@ -66,10 +87,15 @@ public:
 	void reset();
 	void save_state(StateBuf &_state);
 	void restore_state(StateBuf &_state);
-	bool update(uint64_t _current_time);
+	void update(uint64_t _current_time);
 
 	inline uint64_t get_time() const { return m_s.time; }
 	inline uint64_t get_time_mt() const { return m_mt_time; }
+	inline uint64_t get_next_timer_time() const { return m_s.next_timer_time; }
+	// advances the time, the caller must call update() if a timer is due
+	inline void set_time(uint64_t _time) { m_s.time = _time; }
+	// makes the current time visible to other threads
+	inline void set_time_mt() { m_mt_time.store(m_s.time); }
 
 	unsigned register_timer(timer_fun_t _func, const char *_name);
 	void unregister_timer(unsigned _timer);
@@ -78,15 +104,32 @@ public:
 	void deactivate_timer(unsigned _timer);
 	void set_timer_callback(unsigned _timer, timer_fun_t _func);
 	inline bool is_timer_active(unsigned _timer) const {
-		assert(_timer < m_num_timers);
-		return m_s.timers[_timer].active;
+		assert(_timer < m_timers.size());
+		return m_timers[_timer].active;
 	}
-/*
-	const Timer & operator[](unsigned _timer) const {
-		assert(_timer < m_num_timers);
-		return m_s.timers(_timer);
+	inline unsigned get_num_timers() const { return m_timers.size(); }
+	inline const char * get_timer_name(unsigned _timer) const {
+		assert(_timer < m_timers.size());
+		return m_timers[_timer].name;
+	}
+
+private:
+	inline bool fires_before(unsigned _t1, unsigned _t2) const {
+		const Timer &t1 = m_timers[_t1], &t2 = m_timers[_t2];
+		return (t1.time_to_fire < t2.time_to_fire) ||
+		       (t1.time_to_fire == t2.time_to_fire && _t1 < _t2);
+	}
+	inline void update_next_timer_time() {
+		m_s.next_timer_time = m_heap.empty() ?
+				(uint64_t)-1 : m_timers[m_heap[0]].time_to_fire;
 	}
-*/
+	void heap_insert(unsigned _timer);
+	void heap_remove(unsigned _timer);
+	void heap_update(unsigned _timer);
+	void heap_set(unsigned _pos, unsigned _timer);
+	void heap_up(unsigned _pos);
+	void heap_down(unsigned _pos);
+	void heap_rebuild();
 };
 
 #endif